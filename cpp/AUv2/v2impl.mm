@@ -2,12 +2,18 @@
 #include "AudioToolbox/AudioToolbox.h"
 #include "Brinicle/AUv2/ViewFactory_v2.h"
 #include "Brinicle/Glue/Make_kernel_factory.h"
-#include "Brinicle/Thread/Event_stream.h"
+#include "Brinicle/Kernel/Buffer_planner.h"
+#include "Brinicle/Kernel/Preset.h"
+#include "Brinicle/Kernel/Render_arena.h"
+#include "Brinicle/Thread/Parameter_change_bus.h"
+#include "Brinicle/Thread/Realtime_checks.h"
 #include "Brinicle/Thread/Wrapped_kernel.h"
 #include "Brinicle/Utilities/Overload.h"
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <utility>
 #include <variant>
@@ -61,7 +67,9 @@ private:
 namespace {
 struct Preallocated_buffer {
     bool should_allocate = true;
-    vector<vector<float>> buffer_backing;
+
+    // In `Instance_data::render_arena`; empty if `should_allocate` was false at initialize.
+    Render_arena::Channels channels;
 };
 }
 
@@ -87,13 +95,13 @@ struct Instance_data {
     std::recursive_mutex host_mutex;
     std::unique_ptr<KernelFactory> processor;
     KernelFactory::Info plugin_info;
-    std::map<std::string, uint64_t> id_to_address;
-    std::map<uint64_t, std::string> address_to_id;
-    Parameter_state host_mirror;
+    std::shared_ptr<const Parameter_registry> registry;
+    std::unique_ptr<Preset_codec> preset_codec;
+    Dense_parameter_state host_mirror;
     std::shared_ptr<Instance_threaded_kernel_client> kernel_client;
     std::shared_ptr<Wrapped_kernel> kernel;
 
-    std::multimap<int64_t, Audio_event> next_buffer_events;
+    Audio_event_buffer next_buffer_events;
 
     // kAudioUnitProperty_StreamFormat
     std::optional<AudioStreamBasicDescription> input_format;
@@ -102,13 +110,30 @@ struct Instance_data {
     uint32_t max_frames_per_slice;
     Preallocated_buffer output_buffer;
     Preallocated_buffer input_buffer;
-    vector<uint8_t> input_buffer_list_backing;
+
+    // The buffers above, `input_buffer_list`, `host_input_pointers` and `host_output_pointers`
+    // all live in here.
+    Render_arena render_arena;
     AudioBufferList* input_buffer_list = nullptr;
-    vector<float*> render_pointers;
+
+    // The host's buffers for this block, gathered for `buffer_planner`.
+    float** host_input_pointers = nullptr;
+    float** host_output_pointers = nullptr;
+    uint32_t render_pointer_count = 0;
     bool process_in_place = true;
 
+    // Picks the buffers we render in, using our own buffers above as scratch.
+    std::unique_ptr<Buffer_planner> buffer_planner;
+
     uint64_t latency = 0;
 
+    // Whether we've rendered since initializing.  Only then, and not while the host renders
+    // offline, do restored states ramp to their new values.
+    bool rendering = false;
+
+    // kAudioUnitProperty_OfflineRender
+    bool offline_render = false;
+
     // kAudioUnitProperty_PresentPreset
     AUPreset present_preset;
 
@@ -121,9 +146,8 @@ struct Instance_data {
     // Pending render notifications - since a callback could add or remove itself.
     std::set<Render_callback> pending_render_callbacks;
 
-    std::pair<std::shared_ptr<Event_stream<uint64_t, float>>,
-              std::shared_ptr<Event_emitter<uint64_t, float>>>
-        parameter_change_event = make_event<uint64_t, float>();
+    // Parameter changes for the UI, coalesced and delivered once per timer tick.
+    std::shared_ptr<Parameter_change_bus> parameter_changes;
 
     // Optimization - only push pending callbacks into the live version if they
     // are dirty.
@@ -176,17 +200,13 @@ void Instance_threaded_kernel_client::ungrab(uint64_t parameter)
     //  AUEventListenerNotify(NULL, NULL, &event);
 }
 
-static void
-preallocate_buffers(Preallocated_buffer& buffer, uint32_t num_samples, uint32_t num_channels)
+static void reserve_buffers(Preallocated_buffer& buffer,
+                            Render_arena::Layout& layout,
+                            uint32_t num_samples,
+                            uint32_t num_channels)
 {
-    if (!buffer.should_allocate) {
-        return;
-    }
-
-    buffer.buffer_backing.resize(num_channels);
-    for (auto& buffer_backing : buffer.buffer_backing) {
-        buffer_backing.resize(num_samples);
-    }
+    buffer.channels = buffer.should_allocate ? layout.reserve_channels(num_channels, num_samples)
+                                             : Render_arena::Channels {};
 }
 
 namespace {
@@ -230,6 +250,14 @@ static AudioStreamBasicDescription default_format(double sample_rate, uint32_t n
 
 static AUPreset dummy_preset() { return AUPreset {-1, nullptr}; }
 
+// Our binary `Parameter_state`, in `ClassInfo` alongside the "settings" dictionary.  It's much
+// quicker to restore, and we read it in preference to the dictionary when it's present.
+static CFStringRef binary_state_key() { return CFSTR("brinicle-state"); }
+
+// When a state is restored while we're rendering in real time, parameters ramp to their new
+// values over this long.  Outside of that, restoring is immediate, so it's deterministic.
+static constexpr double state_ramp_seconds = 0.01;
+
 static uint get_default_channel_count(const std::variant<Any_channel_count, Channel_count>& format)
 {
     return std::visit(
@@ -254,11 +282,12 @@ static OSStatus open(void* instance_void, AudioUnit audio_unit)
     instance->data->audio_unit = audio_unit;
     instance->data->processor = make_kernel_factory();
     instance->data->plugin_info = instance->data->processor->info();
-    instance->data->host_mirror = get_default_state(instance->data->plugin_info.parameters);
-    for (const auto& parameter : instance->data->plugin_info.parameters) {
-        instance->data->id_to_address[parameter.identifier_string] = parameter.address;
-        instance->data->address_to_id[parameter.address] = parameter.identifier_string;
-    }
+    instance->data->registry = instance->data->processor->parameter_registry();
+    instance->data->parameter_changes
+        = std::make_shared<Parameter_change_bus>(instance->data->registry);
+    instance->data->host_mirror = instance->data->registry->default_state();
+    instance->data->preset_codec = std::make_unique<Preset_codec>(
+        instance->data->plugin_info.parameters);
 
     const auto default_sampling_rate = 44100.f;
     if (instance->data->plugin_info.type == KernelFactory::Type::effect) {
@@ -321,11 +350,10 @@ static OSStatus initialize(Instance* instance)
             instance->data->input_format ? instance->data->input_format->mChannelsPerFrame : 0,
             instance->data->output_format.mChannelsPerFrame,
             instance->data->output_format.mSampleRate),
-        instance->data->plugin_info.parameters,
-        instance->data->kernel_client);
-    set_param_state(*instance->data->kernel,
-                    instance->data->host_mirror,
-                    instance->data->plugin_info.parameters);
+        instance->data->registry,
+        instance->data->kernel_client,
+        instance->data->output_format.mSampleRate);
+    instance->data->kernel->set_state(instance->data->host_mirror);
     instance->data->kernel->sync_from_ui_thread([](uint64_t, float) {});
     update_latency(instance->data.get());
 
@@ -333,36 +361,67 @@ static OSStatus initialize(Instance* instance)
         scheduledTimerWithTimeInterval:0.05
                                repeats:YES
                                  block:^(NSTimer*) {
+                                     auto& changes = *instance->data->parameter_changes;
                                      instance->data->kernel->sync_from_ui_thread(
                                          [&](uint64_t address, float value) {
-                                             instance->data->parameter_change_event.second->emit(
-                                                 address, value);
+                                             changes.publish(address, value);
                                          });
+                                     changes.deliver();
                                  }]);
     ;
 
+    // All render memory comes from one allocation, made here, so rendering never allocates
+    // and its first block doesn't page fault.
+    Render_arena::Layout layout;
+    Render_arena::Bytes input_buffer_list_bytes;
     if (instance->data->input_format) {
         // Note that for technical reasons (to avoid copies in the render function),
         // we should allocate enough so we can cover the output as well.
         auto input_channels = std::max(instance->data->input_format->mChannelsPerFrame,
                                        instance->data->output_format.mChannelsPerFrame);
-        preallocate_buffers(
-            instance->data->input_buffer, instance->data->max_frames_per_slice, input_channels);
-        instance->data->input_buffer_list_backing.resize(
+        reserve_buffers(instance->data->input_buffer,
+                        layout,
+                        instance->data->max_frames_per_slice,
+                        input_channels);
+        input_buffer_list_bytes = layout.reserve_bytes(
             sizeof(AudioBufferList) + sizeof(AudioBuffer) * (input_channels - 1));
-        instance->data->input_buffer_list = reinterpret_cast<AudioBufferList*>(
-            instance->data->input_buffer_list_backing.data());
     }
-    instance->data->render_pointers.resize(
-        instance->data->input_format ? std::max(instance->data->input_format->mChannelsPerFrame,
-                                                instance->data->output_format.mChannelsPerFrame)
-                                     : instance->data->output_format.mChannelsPerFrame);
+    const auto render_pointer_count = instance->data->input_format
+        ? std::max(instance->data->input_format->mChannelsPerFrame,
+                   instance->data->output_format.mChannelsPerFrame)
+        : instance->data->output_format.mChannelsPerFrame;
+    const auto host_input_pointer_bytes
+        = layout.reserve_bytes(sizeof(float*) * render_pointer_count);
+    const auto host_output_pointer_bytes
+        = layout.reserve_bytes(sizeof(float*) * render_pointer_count);
 
     // Always allocate the output buffer to the max output so we can render
     // in-place.
-    preallocate_buffers(instance->data->output_buffer,
-                        instance->data->max_frames_per_slice,
-                        static_cast<uint32_t>(instance->data->render_pointers.size()));
+    reserve_buffers(instance->data->output_buffer,
+                    layout,
+                    instance->data->max_frames_per_slice,
+                    render_pointer_count);
+
+    instance->data->render_arena.allocate(layout);
+    instance->data->input_buffer_list = instance->data->input_format
+        ? instance->data->render_arena.as<AudioBufferList>(input_buffer_list_bytes)
+        : nullptr;
+    instance->data->host_input_pointers
+        = instance->data->render_arena.as<float*>(host_input_pointer_bytes);
+    instance->data->host_output_pointers
+        = instance->data->render_arena.as<float*>(host_output_pointer_bytes);
+    instance->data->render_pointer_count = render_pointer_count;
+
+    // Scratch comes from whichever of our buffers the host let us allocate.
+    const auto& scratch_buffer = instance->data->output_buffer.should_allocate
+        ? instance->data->output_buffer
+        : instance->data->input_buffer;
+    std::vector<float*> scratch(scratch_buffer.channels.channel_count);
+    for (uint32_t i = 0; i < scratch.size(); ++i) {
+        scratch[i] = instance->data->render_arena.channel(scratch_buffer.channels, i);
+    }
+    instance->data->buffer_planner = std::make_unique<Buffer_planner>(
+        scratch.data(), static_cast<uint32_t>(scratch.size()), render_pointer_count);
     return noErr;
 }
 
@@ -371,11 +430,11 @@ static OSStatus uninitialize(Instance* instance)
     std::lock_guard<decltype(instance->data->host_mutex)> lock(instance->data->host_mutex);
 
     if (instance->data->kernel) {
-        instance->data->host_mirror = get_param_state(*instance->data->kernel,
-                                                      instance->data->plugin_info.parameters);
+        instance->data->host_mirror = instance->data->registry->get_state(*instance->data->kernel);
         instance->data->timer = nullptr;
     }
     instance->data->kernel = nullptr;
+    instance->data->rendering = false;
     instance->data->next_buffer_events.clear();
 
     return noErr;
@@ -454,10 +513,7 @@ static variant<OSStatus, Property_info> get_property_info_internal(Instance* ins
         if (scope != kAudioUnitScope_Global) {
             return kAudioUnitErr_InvalidScope;
         }
-        if (std::find_if(begin(instance->data->plugin_info.parameters),
-                         end(instance->data->plugin_info.parameters),
-                         [&](const auto& parameter) { return parameter.address == elem; })
-            == end(instance->data->plugin_info.parameters)) {
+        if (instance->data->registry->index_of(uint64_t(elem)) == Parameter_registry::npos) {
             return kAudioUnitErr_InvalidElement;
         }
 
@@ -466,13 +522,12 @@ static variant<OSStatus, Property_info> get_property_info_internal(Instance* ins
         if (scope != kAudioUnitScope_Global) {
             return kAudioUnitErr_InvalidScope;
         }
-        auto param = std::find_if(begin(instance->data->plugin_info.parameters),
-                                  end(instance->data->plugin_info.parameters),
-                                  [&](const auto& parameter) { return parameter.address == elem; });
-        if (param == end(instance->data->plugin_info.parameters)) {
+        const auto index = instance->data->registry->index_of(uint64_t(elem));
+        if (index == Parameter_registry::npos) {
             return kAudioUnitErr_InvalidElement;
         }
-        if (!std::holds_alternative<Indexed_parameter_info>(param->info)) {
+        if (!std::holds_alternative<Indexed_parameter_info>(
+                instance->data->registry->info(index).info)) {
             return kAudioUnitErr_InvalidElement;
         }
         return Property_info {sizeof(CFArrayRef), false};
@@ -488,6 +543,7 @@ static variant<OSStatus, Property_info> get_property_info_internal(Instance* ins
         }
         return Property_info {sizeof(AudioUnitCocoaViewInfo), false};
     case kAudioUnitProperty_InPlaceProcessing:
+    case kAudioUnitProperty_OfflineRender:
         if (scope != kAudioUnitScope_Global) {
             return kAudioUnitErr_InvalidScope;
         }
@@ -647,13 +703,13 @@ static OSStatus get_property_internal(Instance* instance,
                                  ? instance->data->present_preset.presetName
                                  : CFSTR("Untitled"));
 
-        auto settings = instance->data->host_mirror;
+        const auto& settings = instance->data->host_mirror;
 
         CFMutableDictionaryRef param_dict = CFDictionaryCreateMutable(
             NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
-        for (auto setting : settings) {
-            CFNumberRef num = CFNumberCreate(NULL, kCFNumberFloatType, &setting.second);
-            auto& key_str = instance->data->address_to_id[setting.first];
+        for (size_t index = 0; index < settings.size(); ++index) {
+            CFNumberRef num = CFNumberCreate(NULL, kCFNumberFloatType, &settings[index]);
+            const auto& key_str = instance->data->registry->identifier(index);
             auto key = CFStringCreateWithBytes(nullptr,
                                                reinterpret_cast<const uint8_t*>(key_str.data()),
                                                key_str.size(),
@@ -666,6 +722,11 @@ static OSStatus get_property_internal(Instance* instance,
         CFDictionarySetValue(dict, CFSTR("settings"), param_dict);
         CFRelease(param_dict);
 
+        const auto state = instance->data->preset_codec->serialize(settings);
+        auto state_data = CFDataCreate(nullptr, state.data(), static_cast<CFIndex>(state.size()));
+        CFDictionarySetValue(dict, binary_state_key(), state_data);
+        CFRelease(state_data);
+
         *reinterpret_cast<CFMutableDictionaryRef*>(output_buffer) = dict;
         return noErr;
     }
@@ -685,10 +746,8 @@ static OSStatus get_property_internal(Instance* instance,
     case kAudioUnitProperty_ParameterInfo: {
         auto info = reinterpret_cast<AudioUnitParameterInfo*>(output_buffer);
         std::memset(info, 0, sizeof(AudioUnitParameterInfo));
-        const auto param = std::find_if(
-            begin(instance->data->plugin_info.parameters),
-            end(instance->data->plugin_info.parameters),
-            [&](const auto& parameter) { return parameter.address == elem; });
+        const auto param = &instance->data->registry->info(
+            instance->data->registry->index_of(uint64_t(elem)));
         info->cfNameString = CFStringCreateWithBytes(
             nullptr,
             reinterpret_cast<const uint8_t*>(param->identifier_string.data()),
@@ -727,10 +786,8 @@ static OSStatus get_property_internal(Instance* instance,
         return noErr;
     }
     case kAudioUnitProperty_ParameterValueStrings: {
-        const auto param = std::find_if(
-            begin(instance->data->plugin_info.parameters),
-            end(instance->data->plugin_info.parameters),
-            [&](const auto& parameter) { return parameter.address == elem; });
+        const auto param = &instance->data->registry->info(
+            instance->data->registry->index_of(uint64_t(elem)));
 
         auto& info = std::get<Indexed_parameter_info>(param->info);
         auto names = CFArrayCreateMutable(
@@ -762,6 +819,9 @@ static OSStatus get_property_internal(Instance* instance,
     case kAudioUnitProperty_InPlaceProcessing:
         *reinterpret_cast<UInt32*>(output_buffer) = instance->data->process_in_place;
         return noErr;
+    case kAudioUnitProperty_OfflineRender:
+        *reinterpret_cast<UInt32*>(output_buffer) = instance->data->offline_render;
+        return noErr;
     case kAudioUnitProperty_ShouldAllocateBuffer:
         *reinterpret_cast<UInt32*>(output_buffer) = (scope == kAudioUnitScope_Output)
             ? instance->data->output_buffer.should_allocate
@@ -769,7 +829,9 @@ static OSStatus get_property_internal(Instance* instance,
         return noErr;
     case kAudioUnitProperty_BypassEffect:
         *reinterpret_cast<UInt32*>(output_buffer)
-            = instance->data->host_mirror[*instance->data->plugin_info.bypass_parameter] == 1.f;
+            = instance->data->host_mirror[instance->data->registry->index_of(
+                  *instance->data->plugin_info.bypass_parameter)]
+            == 1.f;
         return noErr;
     case s_secret_instance_property:
         *reinterpret_cast<Instance**>(output_buffer) = instance;
@@ -847,6 +909,36 @@ static OSStatus validate_format(const AudioStreamBasicDescription& format)
     return noErr;
 }
 
+// Unknown addresses are ignored.
+static void set_host_mirror(Instance_data* data, uint64_t address, float value)
+{
+    const auto index = data->registry->index_of(address);
+    if (index != Parameter_registry::npos) {
+        data->host_mirror[index] = value;
+    }
+}
+
+// Queues an event for the next render.  If the block's event buffer is full, parameter
+// changes are applied immediately instead (losing only their sample accuracy), and MIDI is
+// dropped.
+static void schedule_event(Instance_data* data, const Audio_event& event)
+{
+    if (data->next_buffer_events.push(event)) {
+        return;
+    }
+    std::visit(overload {[&](const Parameter_change& change) {
+                             set_host_mirror(data, change.address, change.value);
+                             data->kernel->set_parameter(change.address, change.value);
+                         },
+                         [&](const Ramped_parameter_change& change) {
+                             set_host_mirror(data, change.address, change.value);
+                             data->kernel->set_parameter(change.address, change.value);
+                         },
+                         [](const Midi_message&) {},
+                         [](const Midi_packet&) {}},
+               event);
+}
+
 static OSStatus set_parameter(Instance* instance,
                               AudioUnitParameterID param,
                               AudioUnitScope scope,
@@ -986,18 +1078,29 @@ static OSStatus set_property_internal(Instance* instance,
         if (data_size != sizeof(CFDictionaryRef)) {
             return kAudioUnitErr_InvalidPropertyValue;
         }
-        auto state = get_default_state(instance->data->plugin_info.parameters);
+        auto state = instance->data->registry->default_state();
 
         const auto dict = reinterpret_cast<const CFDictionaryRef*>(data);
 
+        const auto state_data = reinterpret_cast<const CFDataRef>(
+            CFDictionaryGetValue(*dict, binary_state_key()));
+        std::optional<Preset_view> preset;
+        if (state_data && CFGetTypeID(state_data) == CFDataGetTypeID()) {
+            preset = Preset_view::parse(CFDataGetBytePtr(state_data),
+                                        static_cast<size_t>(CFDataGetLength(state_data)));
+        }
+
         const auto param_dict = reinterpret_cast<const CFDictionaryRef>(
             CFDictionaryGetValue(*dict, CFSTR("settings")));
-        if (param_dict) {
-            for (const auto& parameter : instance->data->plugin_info.parameters) {
+        if (preset) {
+            instance->data->preset_codec->apply(*preset, state);
+        } else if (param_dict) {
+            for (size_t index = 0; index < state.size(); ++index) {
+                const auto& identifier = instance->data->registry->identifier(index);
                 auto key = CFStringCreateWithBytes(
                     nullptr,
-                    reinterpret_cast<const uint8_t*>(parameter.identifier_string.data()),
-                    parameter.identifier_string.size(),
+                    reinterpret_cast<const uint8_t*>(identifier.data()),
+                    identifier.size(),
                     kCFStringEncodingUTF8,
                     false);
                 CFNumberRef value = reinterpret_cast<CFNumberRef>(
@@ -1006,13 +1109,18 @@ static OSStatus set_property_internal(Instance* instance,
                 if (value) {
                     float float_value;
                     CFNumberGetValue(value, kCFNumberFloat32Type, &float_value);
-                    state[parameter.address] = float_value;
+                    state[index] = float_value;
                 }
             }
         }
         instance->data->host_mirror = state;
         if (instance->data->kernel) {
-            set_param_state(*instance->data->kernel, state, instance->data->plugin_info.parameters);
+            const bool ramp = instance->data->rendering && !instance->data->offline_render;
+            instance->data->kernel->set_state(
+                state,
+                ramp ? static_cast<uint32_t>(instance->data->output_format.mSampleRate
+                                             * state_ramp_seconds)
+                     : 0);
         }
         return noErr;
     }
@@ -1026,6 +1134,16 @@ static OSStatus set_property_internal(Instance* instance,
         instance->data->process_in_place = *reinterpret_cast<const UInt32*>(data);
         return noErr;
     }
+    case kAudioUnitProperty_OfflineRender: {
+        if (scope != kAudioUnitScope_Global) {
+            return kAudioUnitErr_InvalidScope;
+        }
+        if (data_size != sizeof(UInt32)) {
+            return kAudioUnitErr_InvalidPropertyValue;
+        }
+        instance->data->offline_render = *reinterpret_cast<const UInt32*>(data);
+        return noErr;
+    }
     case kAudioUnitProperty_ShouldAllocateBuffer: {
         if (scope == kAudioUnitScope_Input && !instance->data->input_format) {
             return kAudioUnitErr_InvalidScope;
@@ -1201,46 +1319,43 @@ Kernel_ui_interface Brinicle::plugin_ui_interface_for_audio_unit(AudioUnit unit)
 
     return Kernel_ui_interface {ui_parameter_set_for_kernel(instance->data->kernel),
                                 instance->data->plugin_info.parameters,
-                                [stream = instance->data->parameter_change_event.first](
+                                [changes = instance->data->parameter_changes](
                                     std::function<void(uint64_t, float)> listener) -> std::any {
-                                    return stream->subscribe(listener);
+                                    return changes->subscribe(
+                                        [listener](Parameter_change_batch batch) {
+                                            for (const auto& change : batch) {
+                                                listener(change.address, change.value);
+                                            }
+                                        });
                                 }};
 }
 
-// Shared render code.
+// Shared render code, once `buffer_planner` has planned the block.
 static void render_internal(Instance* instance, uint32_t num_frames)
 {
-    auto event_generator = [&,
-                            event_iterator = begin(instance->data->next_buffer_events)]() mutable {
-        if (event_iterator == instance->data->next_buffer_events.end()) {
-            return std::optional<Audio_event> {};
-        }
-        auto ret = event_iterator->second;
-        event_iterator++;
-        return std::optional<Audio_event>(std::move(ret));
-    };
-
+    instance->data->rendering = true;
     instance->data->kernel->sync_from_dsp_thread();
 
-    auto render_channels = instance->data->input_format
-        ? std::max(instance->data->input_format->mChannelsPerFrame,
-                   instance->data->output_format.mChannelsPerFrame)
-        : instance->data->output_format.mChannelsPerFrame;
+    const auto& planner = *instance->data->buffer_planner;
+    planner.copy_input(num_frames);
     auto buffer = Deinterleaved_audio {
-        render_channels, num_frames, instance->data->render_pointers.data()};
+        planner.render_channel_count(), num_frames, planner.render_channels()};
 
-    instance->data->kernel->process(buffer, std::move(event_generator));
+    instance->data->kernel->process(buffer, instance->data->next_buffer_events.span());
 
     // update host mirror for scheduled events.
-    for (const auto& event : instance->data->next_buffer_events) {
+    for (const auto& event : instance->data->next_buffer_events.span()) {
         std::visit(overload {[&](const Parameter_change& change) {
-                                 instance->data->host_mirror[change.address] = change.value;
+                                 set_host_mirror(
+                                     instance->data.get(), change.address, change.value);
                              },
                              [&](const Ramped_parameter_change& change) {
-                                 instance->data->host_mirror[change.address] = change.value;
+                                 set_host_mirror(
+                                     instance->data.get(), change.address, change.value);
                              },
-                             [](const Midi_message&) {}},
-                   event.second);
+                             [](const Midi_message&) {},
+                             [](const Midi_packet&) {}},
+                   event);
     }
 
     instance->data->next_buffer_events.clear();
@@ -1249,16 +1364,16 @@ static void render_internal(Instance* instance, uint32_t num_frames)
 // Update the host mirror - note that this is called after the render callbacks.
 static void update_host_mirror(Instance_data* data)
 {
-    // update the host of any changes.
-    for (auto& host_mirror_param : data->host_mirror) {
-        auto kernel_version = data->kernel->get_parameter(host_mirror_param.first);
-        if (host_mirror_param.second != kernel_version) {
-            host_mirror_param.second = kernel_version;
-            if (host_mirror_param.first == data->plugin_info.bypass_parameter) {
+    // update the host of any changes.  Only parameters the kernel may have changed are visited.
+    data->kernel->take_parameter_changes([data](uint64_t parameter_address, float kernel_version) {
+        const auto index = data->registry->index_of(parameter_address);
+        if (data->host_mirror[index] != kernel_version) {
+            data->host_mirror[index] = kernel_version;
+            if (parameter_address == data->plugin_info.bypass_parameter) {
                 notify_listeners(data, kAudioUnitProperty_BypassEffect, kAudioUnitScope_Global, 0);
             } else {
                 auto audio_unit = data->audio_unit;
-                AudioUnitParameterID address = static_cast<unsigned int>(host_mirror_param.first);
+                AudioUnitParameterID address = static_cast<unsigned int>(parameter_address);
                 AudioUnitEvent event;
 
                 event.mEventType = kAudioUnitEvent_ParameterValueChange;
@@ -1270,8 +1385,10 @@ static void update_host_mirror(Instance_data* data)
                 AUEventListenerNotify(NULL, NULL, &event);
             }
         }
-    }
+    });
 
+    // Parameter changes only reach the kernel at the start of the next block, so this, rather
+    // than `set_parameter`, is where a latency they change is first seen.
     update_latency(data);
 }
 
@@ -1294,6 +1411,7 @@ static OSStatus render(Instance* instance,
                        UInt32 num_frames,
                        AudioBufferList* data)
 {
+    BRINICLE_REALTIME_SCOPE();
     std::lock_guard<decltype(instance->data->host_mutex)> lock(instance->data->host_mutex);
 
     if (data->mNumberBuffers != instance->data->output_format.mChannelsPerFrame) {
@@ -1301,7 +1419,7 @@ static OSStatus render(Instance* instance,
     }
 
     auto output_channels = instance->data->output_format.mChannelsPerFrame;
-    if (output_channels > instance->data->render_pointers.size()) {
+    if (output_channels > instance->data->render_pointer_count) {
         return kAudioUnitErr_Uninitialized;
     }
 
@@ -1324,10 +1442,6 @@ static OSStatus render(Instance* instance,
         data->mBuffers[i].mNumberChannels = 1;
     }
 
-    bool render_buffers_valid = false;
-    bool need_to_copy_render_to_output = false;
-    auto render_channels = output_channels;
-
     // We only support one output for now.
     if (bus_number != 0) {
         return kAudioUnitErr_InvalidPropertyValue;
@@ -1349,108 +1463,63 @@ static OSStatus render(Instance* instance,
             render_callback.data, &flags, time_stamp, bus_number, num_frames, data);
     }
 
+    // If the caller passed in buffers, we render straight into them; otherwise we pick them.
+    auto& planner = *instance->data->buffer_planner;
+    auto request = Buffer_planner::Request {Buffer_planner::Input::none,
+                                            0u,
+                                            output_channels,
+                                            nullptr,
+                                            nullptr,
+                                            instance->data->process_in_place};
+    if (caller_buffers_valid) {
+        for (decltype(output_channels) i = 0; i < output_channels; ++i) {
+            instance->data->host_output_pointers[i] = reinterpret_cast<float*>(
+                data->mBuffers[i].mData);
+        }
+        request.host_output = instance->data->host_output_pointers;
+    }
+
     if (instance->data->input_format) {
         auto input_channels = instance->data->input_format->mChannelsPerFrame;
-        render_channels = std::max(input_channels, output_channels);
+        request.input_channel_count = input_channels;
 
-        if (input_channels > instance->data->render_pointers.size()) {
+        if (input_channels > instance->data->render_pointer_count) {
             return kAudioUnitErr_Uninitialized;
         }
 
+        instance->data->input_buffer_list->mNumberBuffers = input_channels;
+        for (decltype(input_channels) i = 0; i < input_channels; ++i) {
+            instance->data->input_buffer_list->mBuffers[i].mNumberChannels = 1u;
+            instance->data->input_buffer_list->mBuffers[i].mDataByteSize = required_buffer_size;
+        }
+
         // We take input, so, we need to get input before we render.
         auto input_error = std::visit(
             overload {
                 [&](const AURenderCallbackStruct& input_callback) -> OSStatus {
-                    AudioBufferList* input_buffer_list = nullptr;
-
-                    // Set up our input buffers - note that if the user passed in
-                    // buffers and
-                    // they are big enough we can just use those.
-                    if (caller_buffers_valid && output_channels >= input_channels) {
-                        data->mNumberBuffers = input_channels;
-                        input_buffer_list = data;
-
-                        // Render in-place.
-                        for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-                            instance->data->render_pointers[i] = reinterpret_cast<float*>(
-                                data->mBuffers[i].mData);
-                        }
-                        render_buffers_valid = true;
-                    } else {
-                        // Otherwise, validate then use our pre-allocated buffers.
-                        if (instance->data->input_buffer.buffer_backing.size() < input_channels) {
-                            return kAudioUnitErr_TooManyFramesToProcess;
-                        }
-                        if (instance->data->input_buffer.buffer_backing[0].size() < num_frames) {
-                            return kAudioUnitErr_TooManyFramesToProcess;
-                        }
-
-                        instance->data->input_buffer_list->mNumberBuffers = input_channels;
-                        for (decltype(input_channels) i = 0; i < input_channels; ++i) {
-                            instance->data->input_buffer_list->mBuffers[i].mData
-                                = instance->data->input_buffer.buffer_backing[i].data();
-                            instance->data->input_buffer_list->mBuffers[i].mNumberChannels = 1;
-                            instance->data->input_buffer_list->mBuffers[i].mDataByteSize
-                                = required_buffer_size;
-                        }
-                        input_buffer_list = instance->data->input_buffer_list;
-
-                        // Set up output/render - if we provide the buffers, use ours to
-                        // avoid a
-                        // copy; otherwise use theirs and copy.
-                        if (!caller_buffers_valid) {
-                            // Note that we always allocate enough input buffer backing to
-                            // support
-                            // the output channels too.
-                            assert(instance->data->input_buffer.buffer_backing.size()
-                                   >= output_channels);
-                            for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-                                data->mBuffers[i].mData
-                                    = instance->data->input_buffer.buffer_backing[i].data();
-                            }
-
-                            for (decltype(input_channels) i = 0;
-                                 i < std::max(input_channels, output_channels);
-                                 ++i) {
-                                instance->data->render_pointers[i]
-                                    = instance->data->input_buffer.buffer_backing[i].data();
-                            }
-                            render_buffers_valid = true;
-                        } else {
-                            // Gross out-of-place case.
-                            for (decltype(input_channels) i = 0;
-                                 i < std::max(input_channels, output_channels);
-                                 ++i) {
-                                instance->data->render_pointers[i]
-                                    = instance->data->input_buffer.buffer_backing[i].data();
-                            }
-                            render_buffers_valid = true;
-                            need_to_copy_render_to_output = true;
-                        }
+                    // We provide the buffers, so have the input rendered right where we'll
+                    // process it.
+                    request.input = Buffer_planner::Input::pulled;
+                    if (!planner.plan(request)) {
+                        return kAudioUnitErr_Uninitialized;
+                    }
+                    for (decltype(input_channels) i = 0; i < input_channels; ++i) {
+                        instance->data->input_buffer_list->mBuffers[i].mData
+                            = planner.render_channels()[i];
                     }
-                    // Get the data.
                     return input_callback.inputProc(input_callback.inputProcRefCon,
                                                     action_flags,
                                                     time_stamp,
                                                     0u,
                                                     num_frames,
-                                                    input_buffer_list);
+                                                    instance->data->input_buffer_list);
                 },
                 [](const std::nullptr_t&) -> OSStatus { return kAudioUnitErr_NoConnection; },
                 [&](const AudioUnitConnection& connection) -> OSStatus {
-                    if (input_channels < output_channels
-                        && instance->data->output_buffer.buffer_backing.size() < output_channels) {
-                        return kAudioUnitErr_Uninitialized;
-                    }
-
                     // Our connection has to supply the buffers for us :-\, so we have
                     // to set up the input buffers as nullptrs.
-                    instance->data->input_buffer_list->mNumberBuffers = input_channels;
                     for (decltype(input_channels) i = 0; i < input_channels; ++i) {
                         instance->data->input_buffer_list->mBuffers[i].mData = nullptr;
-                        instance->data->input_buffer_list->mBuffers[i].mNumberChannels = 1u;
-                        instance->data->input_buffer_list->mBuffers[i].mDataByteSize
-                            = required_buffer_size;
                     }
 
                     AudioUnitRender(connection.sourceAudioUnit,
@@ -1460,73 +1529,32 @@ static OSStatus render(Instance* instance,
                                     num_frames,
                                     instance->data->input_buffer_list);
 
-                    // At this point, we should have valid buffers - Note that if
-                    // we're allowed to process in place, we can re-use these for the
-                    // output.
-                    for (decltype(render_channels) i = 0; i < render_channels; ++i) {
-                        instance->data->render_pointers[i] = (i < input_channels)
-                            ? reinterpret_cast<float*>(
-                                instance->data->input_buffer_list->mBuffers[i].mData)
-                            : instance->data->output_buffer.buffer_backing[i].data();
-                    }
-
-                    render_buffers_valid = true;
-
-                    if (!caller_buffers_valid && instance->data->process_in_place) {
-                        for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-                            data->mBuffers[i].mData = instance->data->render_pointers[i];
-                        }
-                    } else {
-                        // Ugh!  Caller passed in buffers or defeated process in place
-                        // so we'll have to copy.
-                        need_to_copy_render_to_output = true;
+                    // We may only process in the connection's buffers if we're allowed to
+                    // process in place.
+                    for (decltype(input_channels) i = 0; i < input_channels; ++i) {
+                        instance->data->host_input_pointers[i] = reinterpret_cast<float*>(
+                            instance->data->input_buffer_list->mBuffers[i].mData);
                     }
-                    return noErr;
+                    request.input = Buffer_planner::Input::supplied;
+                    request.supplied_input = instance->data->host_input_pointers;
+                    return planner.plan(request) ? noErr : kAudioUnitErr_Uninitialized;
                 }},
             instance->data->input);
         if (input_error != noErr) {
             return input_error;
         }
-    } else {
-        // Output-only case.
-        if (caller_buffers_valid) {
-            for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-                instance->data->render_pointers[i] = reinterpret_cast<float*>(
-                    data->mBuffers[i].mData);
-            }
-            render_buffers_valid = true;
-        } else {
-            if (instance->data->output_buffer.buffer_backing.size() < output_channels) {
-                return kAudioUnitErr_Uninitialized;
-            }
-
-            for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-                instance->data->render_pointers[i]
-                    = instance->data->output_buffer.buffer_backing[i].data();
-                data->mBuffers[i].mData = instance->data->render_pointers[i];
-            }
-            render_buffers_valid = true;
-        }
+    } else if (!planner.plan(request)) {
+        return kAudioUnitErr_Uninitialized;
     }
 
-    // Double check we've set up the render buffers by now.
-    assert(render_buffers_valid);
-
-    // Note we may have fucked with the number of buffers in the caller's buffer
-    // list during the input stage; so fix that now.
-    data->mNumberBuffers = output_channels;
-
-    render_internal(instance, num_frames);
-
-    // If we rendered out-of-place; go ahead and copy.
-    if (need_to_copy_render_to_output) {
+    if (!caller_buffers_valid) {
         for (decltype(output_channels) i = 0; i < output_channels; ++i) {
-            std::copy(instance->data->render_pointers[i],
-                      instance->data->render_pointers[i] + num_frames,
-                      reinterpret_cast<float*>(data->mBuffers[i].mData));
+            data->mBuffers[i].mData = planner.render_channels()[i];
         }
     }
 
+    render_internal(instance, num_frames);
+
     if (instance->data->render_callbacks_dirty) {
         instance->data->render_callbacks = instance->data->pending_render_callbacks;
         instance->data->render_callbacks_dirty = false;
@@ -1549,6 +1577,7 @@ static OSStatus process(Instance* instance,
                         UInt32 num_frames,
                         AudioBufferList* data)
 {
+    BRINICLE_REALTIME_SCOPE();
     std::lock_guard<decltype(instance->data->host_mutex)> lock(instance->data->host_mutex);
 
     if (!instance->data->kernel) {
@@ -1572,50 +1601,35 @@ static OSStatus process(Instance* instance,
 
     const UInt32 required_byte_size = sizeof(float) * num_frames;
     // We actually need valid buffers.
-    for (unsigned int i = 0; i < input_channels; ++i) {
+    for (unsigned int i = 0; i < render_channels; ++i) {
         if (data->mBuffers[i].mDataByteSize < required_byte_size) {
             return kAudioUnitErr_TooManyFramesToProcess;
         }
 
-        if (data->mBuffers[i].mData == nullptr) {
+        if (i < input_channels && data->mBuffers[i].mData == nullptr) {
             return kAudioUnitErr_InvalidPropertyValue;
         }
 
         data->mBuffers[i].mNumberChannels = 1;
         data->mBuffers[i].mDataByteSize = required_byte_size;
-
-        if (instance->data->process_in_place) {
-            instance->data->render_pointers[i] = reinterpret_cast<float*>(data->mBuffers[i].mData);
-        } else {
-            if (instance->data->input_buffer.buffer_backing.size() < render_channels) {
-                return kAudioUnitErr_Uninitialized;
-            }
-
-            instance->data->render_pointers[i]
-                = instance->data->input_buffer.buffer_backing[i].data();
-            std::copy(reinterpret_cast<float*>(data->mBuffers[i].mData),
-                      reinterpret_cast<float*>(data->mBuffers[i].mData) + num_frames,
-                      instance->data->render_pointers[i]);
-            data->mBuffers[i].mData = instance->data->render_pointers[i];
-        }
+        instance->data->host_input_pointers[i] = reinterpret_cast<float*>(data->mBuffers[i].mData);
+    }
+
+    // The same buffers hold the input and take the output.  Any we can't use, because they're
+    // null or we mustn't process in place, are swapped for ours.
+    auto& planner = *instance->data->buffer_planner;
+    const auto request = Buffer_planner::Request {
+        input_channels ? Buffer_planner::Input::supplied : Buffer_planner::Input::none,
+        input_channels,
+        output_channels,
+        instance->data->host_input_pointers,
+        instance->data->host_input_pointers,
+        instance->data->process_in_place};
+    if (!planner.plan(request)) {
+        return kAudioUnitErr_Uninitialized;
     }
-    for (auto i = input_channels; i < render_channels; ++i) {
-        if (data->mBuffers[i].mDataByteSize < required_byte_size) {
-            return kAudioUnitErr_TooManyFramesToProcess;
-        }
-        data->mBuffers[i].mNumberChannels = 1;
-        data->mBuffers[i].mDataByteSize = required_byte_size;
-        if (data->mBuffers[i].mData == nullptr || !instance->data->process_in_place) {
-            if (instance->data->output_buffer.buffer_backing.size() < render_channels) {
-                return kAudioUnitErr_Uninitialized;
-            }
-
-            instance->data->render_pointers[i]
-                = instance->data->output_buffer.buffer_backing[i].data();
-            data->mBuffers[i].mData = instance->data->render_pointers[i];
-        } else {
-            instance->data->render_pointers[i] = reinterpret_cast<float*>(data->mBuffers[i].mData);
-        }
+    for (unsigned int i = 0; i < render_channels; ++i) {
+        data->mBuffers[i].mData = planner.render_channels()[i];
     }
 
     render_internal(instance, num_frames);
@@ -1636,7 +1650,11 @@ static OSStatus get_parameter(Instance* instance,
         return kAudioUnitErr_InvalidScope;
     }
 
-    *value = instance->data->host_mirror[param];
+    const auto index = instance->data->registry->index_of(uint64_t(param));
+    if (index == Parameter_registry::npos) {
+        return kAudioUnitErr_InvalidParameter;
+    }
+    *value = instance->data->host_mirror[index];
 
     return noErr;
 }
@@ -1658,17 +1676,20 @@ static OSStatus set_parameter(Instance* instance,
         return kAudioUnitErr_InvalidElement;
     }
 
+    const auto index = instance->data->registry->index_of(uint64_t(param));
+    if (index == Parameter_registry::npos) {
+        return kAudioUnitErr_InvalidParameter;
+    }
+
     if (instance->data->kernel) {
         if (buffer_offset == 0) {
-            instance->data->host_mirror[param] = value;
+            instance->data->host_mirror[index] = value;
             instance->data->kernel->set_parameter(param, value);
         } else {
-            instance->data->next_buffer_events.insert(
-                {buffer_offset, Parameter_change {buffer_offset, param, value}});
+            schedule_event(instance->data.get(), Parameter_change {buffer_offset, param, value});
         }
     }
 
-    update_latency(instance->data.get());
     return noErr;
 }
 
@@ -1705,18 +1726,17 @@ static OSStatus schedule_parameters(Instance* instance,
                 return kAudioUnitErr_InvalidElement;
             }
 
-            instance->data->next_buffer_events.insert(
-                {parameter_event.eventValues.ramp.startBufferOffset,
-                 Parameter_change {parameter_event.eventValues.ramp.startBufferOffset,
-                                   parameter_event.parameter,
-                                   parameter_event.eventValues.ramp.startValue}});
-
-            instance->data->next_buffer_events.insert(
-                {parameter_event.eventValues.ramp.startBufferOffset,
-                 Ramped_parameter_change {parameter_event.eventValues.ramp.startBufferOffset,
-                                          parameter_event.parameter,
-                                          parameter_event.eventValues.ramp.endValue,
-                                          parameter_event.eventValues.ramp.durationInFrames}});
+            schedule_event(instance->data.get(),
+                           Parameter_change {parameter_event.eventValues.ramp.startBufferOffset,
+                                             parameter_event.parameter,
+                                             parameter_event.eventValues.ramp.startValue});
+
+            schedule_event(
+                instance->data.get(),
+                Ramped_parameter_change {parameter_event.eventValues.ramp.startBufferOffset,
+                                         parameter_event.parameter,
+                                         parameter_event.eventValues.ramp.endValue,
+                                         parameter_event.eventValues.ramp.durationInFrames});
         } else {
             return kAudioUnitErr_InvalidParameter;
         }
@@ -1752,18 +1772,52 @@ midi_event(Instance* instance, UInt32 status, UInt32 data1, UInt32 data2, UInt32
     }
     uint8_t cable = 0u;
     uint16_t valid_bytes = 3u;
-    instance->data->next_buffer_events.insert(
-        {buffer_offset,
-         Midi_message {buffer_offset,
-                       cable,
-                       valid_bytes,
-                       std::array<uint8_t, 3> {static_cast<uint8_t>(status),
-                                               static_cast<uint8_t>(data1),
-                                               static_cast<uint8_t>(data2)}}});
+    schedule_event(instance->data.get(),
+                   Midi_message {buffer_offset,
+                                 cable,
+                                 valid_bytes,
+                                 std::array<uint8_t, 3> {static_cast<uint8_t>(status),
+                                                         static_cast<uint8_t>(data1),
+                                                         static_cast<uint8_t>(data2)}});
 
     return noErr;
 }
 
+// Sysex has no time, so it's handled at the start of the next render.  Dropped if the block
+// is full.
+static OSStatus sysex(Instance* instance, const UInt8* data, UInt32 length)
+{
+    std::lock_guard<decltype(instance->data->host_mutex)> lock(instance->data->host_mutex);
+
+    if (!instance->data->kernel) {
+        return kAudioUnitErr_Uninitialized;
+    }
+    uint8_t cable = 0u;
+    instance->data->next_buffer_events.push_midi_packet(
+        0, cable, Midi_packet_format::bytes, data, length);
+    return noErr;
+}
+
+#if defined(__MAC_12_0)
+static OSStatus
+midi_event_list(Instance* instance, UInt32 buffer_offset, const MIDIEventList* event_list)
+{
+    std::lock_guard<decltype(instance->data->host_mutex)> lock(instance->data->host_mutex);
+
+    if (!instance->data->kernel) {
+        return kAudioUnitErr_Uninitialized;
+    }
+    uint8_t cable = 0u;
+    auto packet = &event_list->packet[0];
+    for (UInt32 i = 0; i < event_list->numPackets; ++i) {
+        instance->data->next_buffer_events.push_ump(
+            buffer_offset, cable, packet->words, packet->wordCount);
+        packet = MIDIEventPacketNext(packet);
+    }
+    return noErr;
+}
+#endif
+
 static AudioComponentMethod lookup(SInt16 selector)
 {
     switch (selector) {
@@ -1799,6 +1853,12 @@ static AudioComponentMethod lookup(SInt16 selector)
         return reinterpret_cast<AudioComponentMethod>(render);
     case kMusicDeviceMIDIEventSelect:
         return reinterpret_cast<AudioComponentMethod>(midi_event);
+    case kMusicDeviceSysExSelect:
+        return reinterpret_cast<AudioComponentMethod>(sysex);
+#if defined(__MAC_12_0)
+    case kMusicDeviceMIDIEventListSelect:
+        return reinterpret_cast<AudioComponentMethod>(midi_event_list);
+#endif
     case kAudioUnitProcessSelect:
         return reinterpret_cast<AudioComponentMethod>(process);
     }
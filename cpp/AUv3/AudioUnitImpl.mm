@@ -1,5 +1,7 @@
 #import "Brinicle/AUv3/AudioUnitImpl.h"
 #import "Brinicle/Glue/Make_kernel_factory.h"
+#include "Brinicle/Kernel/Buffer_planner.h"
+#include "Brinicle/Thread/Realtime_checks.h"
 #include "Brinicle/Thread/Wrapped_kernel.h"
 #include "Brinicle/Utilities/Overload.h"
 #include <algorithm>
@@ -91,7 +93,11 @@ public:
 
 @end
 
-static constexpr size_t MAX_CHANNEL_COUNT = 10;
+// The most channels a bus takes when the kernel allows any channel count: enough for
+// seventh-order ambisonics, or any of the immersive speaker layouts.  Channel tables are sized
+// for the bus formats when render resources are allocated, so this costs nothing in smaller
+// formats.
+static constexpr AVAudioChannelCount MAX_CHANNEL_COUNT = 64;
 
 static NSArray<NSString*>* convertArrayString(const std::vector<std::string>& strings)
 {
@@ -126,6 +132,13 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
     BufferedOutputBus _output_bus_buffer;
     BufferedInputBus _input_bus_buffer;
     NSTimer* _ui_sync_timer;
+    Audio_event_buffer _events;
+    std::unique_ptr<Buffer_planner> _buffer_planner;
+
+    // Per-block channel tables, sized when render resources are allocated.
+    std::vector<float*> _host_output_channels;
+    std::vector<float*> _pulled_channels;
+    std::unique_ptr<bool[]> _pulled_in_place;
 }
 
 @synthesize channelCapabilities = _channelCapabilities;
@@ -169,13 +182,20 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
         initial_input_format = [[AVAudioFormat alloc]
             initStandardFormatWithSampleRate:44100.
                                     channels:default_input_count];
+        auto get_max_channels = overload {
+            [](const Any_channel_count&) -> AVAudioChannelCount { return MAX_CHANNEL_COUNT; },
+            [](const Channel_count& count) -> AVAudioChannelCount {
+                return static_cast<AVAudioChannelCount>(count.channels);
+            }};
         const auto get_max = [&](const auto& io) {
-            return std::visit(get_channels,
+            return std::visit(get_max_channels,
                               io(*std::max_element(begin(info.allowed_channel_configurations),
                                                    end(info.allowed_channel_configurations),
                                                    [&](const auto& lhs, const auto& rhs) {
-                                                       return std::visit(get_channels, io(lhs))
-                                                           < std::visit(get_channels, io(rhs));
+                                                       return std::visit(get_max_channels,
+                                                                         io(lhs))
+                                                           < std::visit(get_max_channels,
+                                                                        io(rhs));
                                                    })));
         };
 
@@ -210,8 +230,10 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
         initial_output_format.channelCount,
         initial_output_format.sampleRate);
     apply_defaults(*internal_kernel, params);
-    _kernel = std::make_shared<Wrapped_kernel>(
-        std::move(internal_kernel), params, std::make_shared<Wrapped_kernel::Host_interface>());
+    _kernel = std::make_shared<Wrapped_kernel>(std::move(internal_kernel),
+                                               _plugin->parameter_registry(),
+                                               std::make_shared<Wrapped_kernel::Host_interface>(),
+                                               initial_output_format.sampleRate);
     _ui_set = std::make_shared<Facade_UI_set>(ui_parameter_set_for_kernel(_kernel));
     // convert parameters into au-parameters
     std::vector<AUParameter*> auparams(params.size());
@@ -341,16 +363,38 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
         _input_bus_buffer.allocateRenderResources(self.maximumFramesToRender);
     }
 
+    // When a channel can't be rendered in a host buffer, it's rendered in the output bus's
+    // buffer for that channel, or else the input bus's.
+    const auto output_channels = _output_bus_buffer.bus.format.channelCount;
+    const auto input_channels = _type == KernelFactory::Type::effect
+        ? _input_bus_buffer.bus.format.channelCount
+        : 0u;
+    const auto render_channels = std::max(input_channels, output_channels);
+    std::vector<float*> scratch(render_channels);
+    for (AVAudioChannelCount channel = 0; channel < render_channels; ++channel) {
+        const auto& buffers = channel < output_channels
+            ? *_output_bus_buffer.originalAudioBufferList
+            : *_input_bus_buffer.originalAudioBufferList;
+        scratch[channel] = reinterpret_cast<float*>(buffers.mBuffers[channel].mData);
+    }
+    _buffer_planner
+        = std::make_unique<Buffer_planner>(scratch.data(), render_channels, render_channels);
+    _host_output_channels.assign(output_channels, nullptr);
+    _pulled_channels.assign(input_channels, nullptr);
+    _pulled_in_place = std::make_unique<bool[]>(input_channels);
+
     const auto params = _plugin->info().parameters;
     const auto state = get_param_state(*_kernel, params);
     _kernel = std::make_unique<Wrapped_kernel>(
         _plugin->make_kernel(self.inputBusses[0].format.channelCount,
                              self.outputBus.format.channelCount,
                              self.outputBus.format.sampleRate),
-        params,
-        std::make_shared<Wrapped_kernel::Host_interface>());
-    set_param_state(*_kernel, state, params);
+        _plugin->parameter_registry(),
+        std::make_shared<Wrapped_kernel::Host_interface>(),
+        self.outputBus.format.sampleRate);
+    _kernel->set_state(state);
     _ui_set->switch_set(ui_parameter_set_for_kernel(_kernel));
+    _events.set_capacity(Audio_event_buffer::default_capacity);
 
     return YES;
 }
@@ -358,6 +402,7 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
 - (void)deallocateRenderResources
 {
     _output_bus_buffer.deallocateRenderResources();
+    _buffer_planner.reset();
 
     [super deallocateRenderResources];
 }
@@ -372,6 +417,11 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
   render, we're doing it wrong.
   */
     __block auto kernel = &_kernel;
+    __block auto events = &_events;
+    __block auto planner = &_buffer_planner;
+    __block auto host_output_channels = &_host_output_channels;
+    __block auto pulled_channels = &_pulled_channels;
+    __block auto pulled_in_place = &_pulled_in_place;
 
     return ^AUAudioUnitStatus(AudioUnitRenderActionFlags* actionFlags,
                               const AudioTimeStamp* timestamp,
@@ -380,97 +430,148 @@ static NSArray<NSNumber*>* convertNumberArray(const std::vector<uint64_t>& numbe
                               AudioBufferList* outputData,
                               const AURenderEvent* realtimeEventListHead,
                               AURenderPullInputBlock pullInputBlock) {
-        _output_bus_buffer.prepareOutputBufferList(outputData, frameCount);
+        BRINICLE_REALTIME_SCOPE();
+        auto& buffer_planner = **planner;
+        const auto output_count = outputData->mNumberBuffers;
+        auto& host_output = *host_output_channels;
+        if (output_count > host_output.size()) {
+            return kAudioUnitErr_FormatNotSupported;
+        }
 
-        Deinterleaved_audio ioAudio;
-        ioAudio.frame_count = frameCount;
-        std::array<float*, MAX_CHANNEL_COUNT> channels;
+        // Output channels the host left null are ours to pick.
+        for (UInt32 channel = 0; channel < output_count; ++channel) {
+            host_output[channel] = reinterpret_cast<float*>(outputData->mBuffers[channel].mData);
+        }
+        _output_bus_buffer.prepareOutputBufferList(outputData, frameCount);
 
+        auto request = Buffer_planner::Request {
+            Buffer_planner::Input::none, 0u, output_count, host_output.data(), nullptr, false};
         if (_type == KernelFactory::Type::effect) {
-            _input_bus_buffer.pullInput(actionFlags, timestamp, frameCount, 0, pullInputBlock);
-            ioAudio.channel_count = std::max(_input_bus_buffer.bus.format.channelCount,
-                                             outputData->mNumberBuffers);
-            for (size_t channel = 0; channel < _input_bus_buffer.bus.format.channelCount;
-                 ++channel) {
-                channels[channel] = reinterpret_cast<float*>(
-                    _input_bus_buffer.mutableAudioBufferList->mBuffers[channel].mData);
+            if (pullInputBlock == nullptr) {
+                return kAudioUnitErr_NoConnection;
             }
-            for (size_t channel = _input_bus_buffer.bus.format.channelCount;
-                 channel < outputData->mNumberBuffers;
-                 ++channel) {
-                channels[channel] = reinterpret_cast<float*>(outputData->mBuffers[channel].mData);
+
+            // Pull the input straight into the channels we'll render in.
+            request.input = Buffer_planner::Input::pulled;
+            request.input_channel_count = _input_bus_buffer.bus.format.channelCount;
+            if (!buffer_planner.plan(request)) {
+                return kAudioUnitErr_FormatNotSupported;
+            }
+            auto input = _input_bus_buffer.mutableAudioBufferList;
+            input->mNumberBuffers = request.input_channel_count;
+            for (UInt32 channel = 0; channel < request.input_channel_count; ++channel) {
+                input->mBuffers[channel].mNumberChannels = 1;
+                input->mBuffers[channel].mDataByteSize = frameCount * sizeof(float);
+                input->mBuffers[channel].mData = buffer_planner.render_channels()[channel];
+            }
+            const auto status = pullInputBlock(actionFlags, timestamp, frameCount, 0, input);
+            if (status != noErr) {
+                return status;
             }
 
-        } else {
-            ioAudio.channel_count = outputData->mNumberBuffers;
-            for (size_t channel = 0; channel < ioAudio.channel_count; ++channel) {
-                channels[channel] = reinterpret_cast<float*>(outputData->mBuffers[channel].mData);
+            // The pull may have handed us its own buffers instead for some channels, which we
+            // mustn't write.  The rest are still ours, and stay where they are.
+            auto& pulled = *pulled_channels;
+            const auto in_place = pulled_in_place->get();
+            bool replaced = false;
+            for (UInt32 channel = 0; channel < request.input_channel_count; ++channel) {
+                pulled[channel] = reinterpret_cast<float*>(input->mBuffers[channel].mData);
+                in_place[channel] = pulled[channel] == buffer_planner.render_channels()[channel];
+                replaced |= !in_place[channel];
             }
+            if (replaced) {
+                request.input = Buffer_planner::Input::supplied;
+                request.supplied_input = pulled.data();
+                request.channel_in_place = in_place;
+                if (!buffer_planner.plan(request)) {
+                    return kAudioUnitErr_FormatNotSupported;
+                }
+            }
+        } else if (!buffer_planner.plan(request)) {
+            return kAudioUnitErr_FormatNotSupported;
         }
 
-        ioAudio.data = channels.data();
+        for (UInt32 channel = 0; channel < output_count; ++channel) {
+            if (!host_output[channel]) {
+                outputData->mBuffers[channel].mData = buffer_planner.render_channels()[channel];
+            }
+        }
+        buffer_planner.copy_input(frameCount);
+        const auto ioAudio = Deinterleaved_audio {
+            buffer_planner.render_channel_count(), frameCount, buffer_planner.render_channels()};
 
         assert(timestamp->mFlags | kAudioTimeStampSampleTimeValid);
 
-        auto fnNextEvent = [realtimeEventListHead,
-                            &timestamp]() mutable -> std::optional<Audio_event> {
-            if (realtimeEventListHead == nullptr)
-                return std::nullopt;
-
-            // Since we can't handle every type of event yet, loop until
-            // we find the next event we can handle, or we're out of events.
-            while (realtimeEventListHead) {
-                auto lastEvent = realtimeEventListHead;
-                int64_t bufferOffsetTime = lastEvent->head.eventSampleTime - timestamp->mSampleTime;
-                realtimeEventListHead = realtimeEventListHead->head.next;
-                switch (lastEvent->head.eventType) {
-                case AURenderEventParameter: {
-                    const auto& paramEvent = lastEvent->parameter;
-                    return Audio_event {Parameter_change {
-                        bufferOffsetTime, paramEvent.parameterAddress, paramEvent.value}};
-                } break;
-                case AURenderEventParameterRamp: {
-                    const auto& paramEvent = lastEvent->parameter;
-                    return Audio_event {
-                        Ramped_parameter_change {bufferOffsetTime,
-                                                 paramEvent.parameterAddress,
-                                                 paramEvent.value,
-                                                 paramEvent.rampDurationSampleFrames}};
-                } break;
-                case AURenderEventMIDI: {
-                    const auto& midiEvent = lastEvent->MIDI;
-                    Midi_message retval;
-                    retval.buffer_offset_time = bufferOffsetTime;
-                    retval.cable = midiEvent.cable;
-                    retval.valid_bytes = midiEvent.length;
-                    std::copy(std::begin(midiEvent.data),
-                              std::end(midiEvent.data),
-                              std::begin(retval.data));
-                    return Audio_event {std::move(retval)};
-                } break;
-                default:
-                    break;
-                }
+        // Gather this block's events.  If there are more than we have room for, parameter
+        // changes are applied immediately, and MIDI is dropped.
+        events->clear();
+        auto schedule_parameter_change = [&](const Audio_event& event,
+                                             AUParameterAddress address,
+                                             AUValue value) {
+            if (!events->push(event)) {
+                (*kernel)->set_parameter(address, value);
             }
-
-            return std::nullopt;
         };
-
-        (*kernel)->sync_from_dsp_thread();
-        (*kernel)->process(ioAudio, std::move(fnNextEvent));
-
-        if (_type == KernelFactory::Type::effect) {
-            const auto copy_channels = std::min(outputData->mNumberBuffers,
-                                                _input_bus_buffer.bus.format.channelCount);
-            for (size_t channel = 0; channel < copy_channels; ++channel) {
-                const auto in_channel = reinterpret_cast<float*>(
-                    _input_bus_buffer.mutableAudioBufferList->mBuffers[channel].mData);
-                const auto out_channel = reinterpret_cast<float*>(
-                    outputData->mBuffers[channel].mData);
-                std::copy(in_channel, in_channel + frameCount, out_channel);
+        for (auto event = realtimeEventListHead; event; event = event->head.next) {
+            int64_t bufferOffsetTime = event->head.eventSampleTime - timestamp->mSampleTime;
+            switch (event->head.eventType) {
+            case AURenderEventParameter: {
+                const auto& paramEvent = event->parameter;
+                schedule_parameter_change(
+                    Parameter_change {
+                        bufferOffsetTime, paramEvent.parameterAddress, paramEvent.value},
+                    paramEvent.parameterAddress,
+                    paramEvent.value);
+            } break;
+            case AURenderEventParameterRamp: {
+                const auto& paramEvent = event->parameter;
+                schedule_parameter_change(
+                    Ramped_parameter_change {bufferOffsetTime,
+                                             paramEvent.parameterAddress,
+                                             paramEvent.value,
+                                             paramEvent.rampDurationSampleFrames},
+                    paramEvent.parameterAddress,
+                    paramEvent.value);
+            } break;
+            case AURenderEventMIDI: {
+                const auto& midiEvent = event->MIDI;
+                Midi_message message;
+                message.buffer_offset_time = bufferOffsetTime;
+                message.cable = midiEvent.cable;
+                message.valid_bytes = midiEvent.length;
+                std::copy(
+                    std::begin(midiEvent.data), std::end(midiEvent.data), std::begin(message.data));
+                events->push(message);
+            } break;
+            case AURenderEventMIDISysEx: {
+                // The message's bytes run on past the end of `data`.
+                const auto& midiEvent = event->MIDI;
+                events->push_midi_packet(bufferOffsetTime,
+                                         midiEvent.cable,
+                                         Midi_packet_format::bytes,
+                                         midiEvent.data,
+                                         midiEvent.length);
+            } break;
+#if defined(__MAC_12_0) || defined(__IPHONE_15_0)
+            case AURenderEventMIDIEventList: {
+                const auto& listEvent = event->MIDIEventsList;
+                auto packet = &listEvent.eventList.packet[0];
+                for (UInt32 i = 0; i < listEvent.eventList.numPackets; ++i) {
+                    events->push_ump(
+                        bufferOffsetTime, listEvent.cable, packet->words, packet->wordCount);
+                    packet = MIDIEventPacketNext(packet);
+                }
+            } break;
+#endif
+            default:
+                // Since we can't handle every type of event yet, skip the ones we don't know.
+                break;
             }
         }
 
+        (*kernel)->sync_from_dsp_thread();
+        (*kernel)->process(ioAudio, events->span());
+
         return noErr;
     };
 }
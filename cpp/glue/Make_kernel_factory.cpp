@@ -1,5 +1,8 @@
 #include "Brinicle/Glue/Make_kernel_factory.h"
 #include "Brinicle/Utilities/Overload.h"
+#include <functional>
+#include <optional>
+#include <vector>
 
 using namespace Brinicle;
 
@@ -7,18 +10,23 @@ using namespace std;
 namespace {
 struct rust_kernel;
 
-struct glue_event {
+// Must match `GlueEvent` in the rust glue crate.  This is kept to 32 bytes so a block's
+// events pack two to a cache line, so a MIDI packet (`ty` 3) reuses the parameter fields:
+// `param_addr` points at its bytes in the block's payload, `param_ramp_time` is their count,
+// and `midi_bytes[0]` is its `Midi_packet_format`.
+struct alignas(32) glue_event {
     int64_t time;
-    uint64_t ty;
 
     uint64_t param_addr;
-    double param_value;
+    float param_value;
     uint32_t param_ramp_time;
 
+    uint8_t ty;
     uint8_t midi_cable;
     uint16_t midi_valid_bytes;
     uint8_t midi_bytes[3];
 };
+static_assert(sizeof(glue_event) == 32, "glue_event must stay packed");
 }
 extern "C" {
 void get_params(void*,
@@ -52,6 +60,8 @@ void set_kernel_parameter(rust_kernel*, uint64_t, double);
 double get_kernel_parameter(const rust_kernel*, uint64_t);
 uint64_t get_kernel_latency(const rust_kernel*);
 void reset_kernel(rust_kernel*);
+uint32_t get_kernel_reports_changes();
+uint64_t take_kernel_changes(rust_kernel*, void*, void (*changed)(void*, uint64_t));
 
 void process_kernel(rust_kernel*,
                     float* const*,
@@ -60,6 +70,13 @@ void process_kernel(rust_kernel*,
                     void*,
                     const glue_event* (*event_stream)(void*));
 
+void process_kernel_batched(rust_kernel*,
+                            float* const*,
+                            uint64_t channels,
+                            uint64_t samples,
+                            const glue_event* events,
+                            uint64_t num_events);
+
 uint32_t get_kernel_type();
 
 void get_kernel_allowed_channel_formats(void*, void (*format)(void*, int32_t, int32_t));
@@ -76,37 +93,55 @@ struct rust_kernel_deleter {
 
 using rust_kernel_ptr = std::unique_ptr<rust_kernel, rust_kernel_deleter>;
 
+static void convert_event(const Audio_event& audio_event, const uint8_t* payload, glue_event& event)
+{
+    std::visit(overload {[&](const Parameter_change& param_change) {
+                             event.time = param_change.buffer_offset_time;
+                             event.ty = 0;
+                             event.param_addr = param_change.address;
+                             event.param_value = param_change.value;
+                         },
+                         [&](const Ramped_parameter_change& param_change) {
+                             event.time = param_change.buffer_offset_time;
+                             event.ty = 1;
+                             event.param_addr = param_change.address;
+                             event.param_value = param_change.value;
+                             event.param_ramp_time = param_change.ramp_length;
+                         },
+                         [&](const Midi_message& midi_message) {
+                             event.time = midi_message.buffer_offset_time;
+                             event.ty = 2;
+                             event.midi_cable = midi_message.cable;
+                             event.midi_valid_bytes = midi_message.valid_bytes;
+                             std::copy(begin(midi_message.data),
+                                       end(midi_message.data),
+                                       begin(event.midi_bytes));
+                         },
+                         [&](const Midi_packet& midi_packet) {
+                             event.time = midi_packet.buffer_offset_time;
+                             event.ty = 3;
+                             event.midi_cable = midi_packet.cable;
+                             event.param_addr
+                                 = reinterpret_cast<uintptr_t>(payload + midi_packet.offset);
+                             event.param_ramp_time = midi_packet.size;
+                             event.midi_bytes[0] = static_cast<uint8_t>(midi_packet.format);
+                         }},
+               audio_event);
+}
+
+struct glue_event_stream_context {
+    Audio_event_span events;
+    size_t next_index;
+    glue_event event;
+};
+
 static const glue_event* glue_event_stream(void* ctx)
 {
-    auto p = reinterpret_cast<pair<Audio_event_generator, glue_event>*>(ctx);
-    auto& generator = p->first;
-    auto& event = p->second;
-    auto nextEvent = generator();
-    if (nextEvent) {
-        std::visit(overload {[&](const Parameter_change& param_change) {
-                                 event.time = param_change.buffer_offset_time;
-                                 event.ty = 0;
-                                 event.param_addr = param_change.address;
-                                 event.param_value = param_change.value;
-                             },
-                             [&](const Ramped_parameter_change& param_change) {
-                                 event.time = param_change.buffer_offset_time;
-                                 event.ty = 1;
-                                 event.param_addr = param_change.address;
-                                 event.param_value = param_change.value;
-                                 event.param_ramp_time = param_change.ramp_length;
-                             },
-                             [&](const Midi_message& midi_message) {
-                                 event.time = midi_message.buffer_offset_time;
-                                 event.ty = 2;
-                                 event.midi_cable = midi_message.cable;
-                                 event.midi_valid_bytes = midi_message.valid_bytes;
-                                 std::copy(begin(midi_message.data),
-                                           end(midi_message.data),
-                                           begin(event.midi_bytes));
-                             }},
-                   *nextEvent);
-        return &event;
+    auto& context = *reinterpret_cast<glue_event_stream_context*>(ctx);
+    if (context.next_index < context.events.size()) {
+        convert_event(
+            context.events[context.next_index++], context.events.payload(), context.event);
+        return &context.event;
     } else {
         return nullptr;
     }
@@ -114,7 +149,10 @@ static const glue_event* glue_event_stream(void* ctx)
 
 class kernel_impl : public Kernel {
 public:
-    kernel_impl(rust_kernel_ptr kernel_) : kernel(std::move(kernel_)) {}
+    kernel_impl(rust_kernel_ptr kernel_)
+        : kernel(std::move(kernel_)), batched_events(Audio_event_buffer::default_capacity)
+    {
+    }
     ~kernel_impl() override {}
 
     void set_parameter(uint64_t identifier, float value) override
@@ -130,19 +168,42 @@ public:
 
     void reset() override { reset_kernel(kernel.get()); }
 
-    void process(Deinterleaved_audio deinterleaved_audio, Audio_event_generator events) override
+    bool reports_changes() const override { return get_kernel_reports_changes() != 0; }
+
+    bool take_changes(void* context, void (*changed)(void* context, uint64_t address)) override
+    {
+        return take_kernel_changes(kernel.get(), context, changed) != 0;
+    }
+
+    void process(Deinterleaved_audio deinterleaved_audio, Audio_event_span events) override
     {
-        auto p = make_pair(events, glue_event {});
+        if (events.size() <= batched_events.size()) {
+            for (size_t i = 0; i < events.size(); ++i) {
+                convert_event(events[i], events.payload(), batched_events[i]);
+            }
+            process_kernel_batched(kernel.get(),
+                                   deinterleaved_audio.data,
+                                   deinterleaved_audio.channel_count,
+                                   deinterleaved_audio.frame_count,
+                                   batched_events.data(),
+                                   events.size());
+            return;
+        }
+
+        // Too many events to batch without allocating - fall back to handing them over one
+        // at a time.
+        auto context = glue_event_stream_context {events, 0, glue_event {}};
         process_kernel(kernel.get(),
                        deinterleaved_audio.data,
                        deinterleaved_audio.channel_count,
                        deinterleaved_audio.frame_count,
-                       reinterpret_cast<void*>(&p),
+                       reinterpret_cast<void*>(&context),
                        glue_event_stream);
     }
 
 private:
     rust_kernel_ptr kernel;
+    std::vector<glue_event> batched_events;
 };
 }
 
@@ -0,0 +1,195 @@
+#include "Brinicle/Headless/Audio_file_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+constexpr uint16_t wave_format_ieee_float = 3;
+constexpr size_t wav_header_bytes = 46;
+}
+
+static void put_u16(unsigned char* data, uint16_t value)
+{
+    data[0] = static_cast<unsigned char>(value);
+    data[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void put_u32(unsigned char* data, uint32_t value)
+{
+    put_u16(data, static_cast<uint16_t>(value));
+    put_u16(data + 2, static_cast<uint16_t>(value >> 16));
+}
+
+Audio_file_writer::Audio_file_writer(const std::string& path_,
+                                     Format format_,
+                                     uint32_t channel_count_,
+                                     double sample_rate_,
+                                     size_t buffer_frames_)
+    : path(path_)
+    , format(format_)
+    , channel_count(channel_count_)
+    , sample_rate(sample_rate_)
+    , buffer_frames(std::max<size_t>(buffer_frames_, 1))
+{
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    // We do our own buffering.
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    if (format == Format::wav) {
+        write_header(0);
+    }
+    for (auto& buffer : buffers) {
+        buffer.resize(buffer_frames * channel_count);
+    }
+    writer = std::thread([this] { writer_main(); });
+}
+
+Audio_file_writer::~Audio_file_writer()
+{
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+void Audio_file_writer::write(const float* const* channels, size_t frames)
+{
+    size_t done = 0;
+    while (done < frames) {
+        const auto chunk = std::min(frames - done, buffer_frames - filled_frames);
+        auto out = buffers[filling].data() + filled_frames * channel_count;
+        for (uint32_t channel = 0; channel < channel_count; ++channel) {
+            const auto in = channels[channel] + done;
+            for (size_t frame = 0; frame < chunk; ++frame) {
+                out[frame * channel_count + channel] = in[frame];
+            }
+        }
+        filled_frames += chunk;
+        frame_count += chunk;
+        done += chunk;
+        if (filled_frames == buffer_frames) {
+            hand_off_buffer();
+        }
+    }
+}
+
+void Audio_file_writer::hand_off_buffer()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    wake.wait(guard, [&] { return !writing; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    writing = true;
+    writing_frames = filled_frames;
+    filling = 1 - filling;
+    filled_frames = 0;
+    guard.unlock();
+    wake.notify_all();
+}
+
+void Audio_file_writer::writer_main()
+{
+    while (true) {
+        size_t frames;
+        const float* data;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return writing || stopping; });
+            if (!writing) {
+                return;
+            }
+            frames = writing_frames;
+            data = buffers[1 - filling].data();
+        }
+
+        const auto samples = frames * channel_count;
+        const bool ok = std::fwrite(data, sizeof(float), samples, file) == samples;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!ok && !error) {
+                error = std::make_exception_ptr(
+                    std::runtime_error(path + ": write failed: " + std::strerror(errno)));
+            }
+            writing = false;
+        }
+        wake.notify_all();
+    }
+}
+
+void Audio_file_writer::finish()
+{
+    if (!file) {
+        return;
+    }
+    // However this goes, the writer thread has to be stopped and the file closed.
+    std::exception_ptr result;
+    if (filled_frames > 0) {
+        try {
+            hand_off_buffer();
+        } catch (...) {
+            result = std::current_exception();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+
+    if (!result) {
+        result = error;
+    }
+    if (!result && format == Format::wav) {
+        try {
+            write_header(frame_count * channel_count * sizeof(float));
+        } catch (...) {
+            result = std::current_exception();
+        }
+    }
+    if (std::fclose(file) != 0 && !result) {
+        result = std::make_exception_ptr(std::runtime_error(path + ": " + std::strerror(errno)));
+    }
+    file = nullptr;
+    if (result) {
+        std::rethrow_exception(result);
+    }
+}
+
+void Audio_file_writer::write_header(uint64_t data_bytes)
+{
+    // WAV can't describe more than 4GB; like most writers, we then leave the sizes maxed out,
+    // and readers (including `Mapped_audio_file`) fall back on the file size.
+    const auto max_size = std::numeric_limits<uint32_t>::max();
+    const auto data_size = static_cast<uint32_t>(std::min<uint64_t>(data_bytes, max_size));
+    const auto riff_size = static_cast<uint32_t>(
+        std::min<uint64_t>(data_bytes + wav_header_bytes - 8, max_size));
+    const auto block_align = static_cast<uint16_t>(channel_count * sizeof(float));
+
+    unsigned char header[wav_header_bytes];
+    std::memcpy(header, "RIFF", 4);
+    put_u32(header + 4, riff_size);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 18);
+    put_u16(header + 20, wave_format_ieee_float);
+    put_u16(header + 22, static_cast<uint16_t>(channel_count));
+    put_u32(header + 24, static_cast<uint32_t>(sample_rate));
+    put_u32(header + 28, static_cast<uint32_t>(sample_rate) * block_align);
+    put_u16(header + 32, block_align);
+    put_u16(header + 34, 32);
+    put_u16(header + 36, 0);
+    std::memcpy(header + 38, "data", 4);
+    put_u32(header + 42, data_size);
+
+    if (std::fseek(file, 0, SEEK_SET) != 0
+        || std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        throw std::runtime_error(path + ": couldn't write WAV header");
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Brinicle {
+
+/// Writes 32-bit float audio to a WAV or raw file on a background thread.
+///
+/// Audio is interleaved into one of two large buffers; while one fills, the other is written
+/// to disk, so rendering and disk I/O overlap.  `write` only waits if the disk falls a whole
+/// buffer behind.  I/O errors are rethrown from `write` or `finish` as `std::runtime_error`.
+class Audio_file_writer {
+public:
+    enum class Format {
+        wav,
+        raw,
+    };
+
+    Audio_file_writer(const std::string& path,
+                      Format format,
+                      uint32_t channel_count,
+                      double sample_rate,
+                      size_t buffer_frames = 1 << 16);
+
+    /// Finishes the file if `finish` wasn't called, ignoring any errors.
+    ~Audio_file_writer();
+
+    Audio_file_writer(const Audio_file_writer&) = delete;
+    Audio_file_writer& operator=(const Audio_file_writer&) = delete;
+
+    /// Queues `frame_count` frames from the de-interleaved `channels`.
+    void write(const float* const* channels, size_t frame_count);
+
+    /// Writes everything queued, completes the header and closes the file.
+    void finish();
+
+    uint64_t frames_written() const { return frame_count; }
+
+private:
+    void hand_off_buffer();
+    void write_header(uint64_t data_bytes);
+    void writer_main();
+
+    std::string path;
+    Format format;
+    uint32_t channel_count;
+    double sample_rate;
+    size_t buffer_frames;
+    std::FILE* file = nullptr;
+    uint64_t frame_count = 0;
+
+    // `buffers[filling]` is owned by the caller; the other belongs to the writer thread while
+    // `writing` is set.
+    std::vector<float> buffers[2];
+    size_t filling = 0;
+    size_t filled_frames = 0;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    bool writing = false;
+    size_t writing_frames = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread writer;
+};
+
+}
@@ -0,0 +1,42 @@
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include <cstdlib>
+#include <string>
+
+using namespace Brinicle;
+
+std::vector<double> Brinicle::parse_number_list(const char* arg)
+{
+    std::vector<double> ret;
+    std::string list(arg);
+    size_t start = 0;
+    while (start <= list.size()) {
+        auto end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        ret.push_back(std::strtod(list.substr(start, end - start).c_str(), nullptr));
+        start = end + 1;
+    }
+    return ret;
+}
+
+uint64_t Brinicle::elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+}
+
+std::vector<Parameter_info> Brinicle::make_parameters(size_t count, Numeric_parameter_info numeric)
+{
+    std::vector<Parameter_info> parameters;
+    for (size_t i = 0; i < count; ++i) {
+        parameters.push_back(Parameter_info {"param" + std::to_string(i),
+                                             i * 7 + 3,
+                                             "Param " + std::to_string(i),
+                                             0,
+                                             numeric,
+                                             {}});
+    }
+    return parameters;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Brinicle/Kernel/Parameter.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Parses a comma-separated list of numbers, such as `64,256,1024`, from a tool's command line.
+std::vector<double> parse_number_list(const char* arg);
+
+template <typename T = size_t> std::vector<T> parse_list(const char* arg)
+{
+    std::vector<T> ret;
+    for (auto number : parse_number_list(arg)) {
+        ret.push_back(static_cast<T>(number));
+    }
+    return ret;
+}
+
+/// Nanoseconds from `start` until now.
+uint64_t elapsed_ns(std::chrono::steady_clock::time_point start);
+
+/// `count` numeric parameters called `param0`, `param1`, ..., with their addresses spread out,
+/// as real kernels' often are.
+std::vector<Parameter_info>
+make_parameters(size_t count, Numeric_parameter_info numeric = {0., 1., 0u, 0.5});
+
+}
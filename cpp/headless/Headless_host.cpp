@@ -0,0 +1,79 @@
+#include "Brinicle/Headless/Headless_host.h"
+#include "Brinicle/Thread/Realtime_checks.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
+
+using namespace Brinicle;
+
+Headless_host::Headless_host(const KernelFactory& factory, Configuration configuration)
+    : configuration_(configuration)
+    , info_(factory.info())
+    , client(std::make_shared<Wrapped_kernel::Host_interface>())
+{
+    kernel_ = std::make_shared<Wrapped_kernel>(
+        factory.make_kernel(configuration_.input_channel_count,
+                            configuration_.output_channel_count,
+                            configuration_.sample_rate),
+        factory.parameter_registry(),
+        client,
+        configuration_.sample_rate);
+    apply_defaults(*kernel_, info_.parameters);
+    kernel_->sync_from_ui_thread([](uint64_t, float) {});
+
+    Render_arena::Layout layout;
+    const auto channels = layout.reserve_channels(render_channel_count(),
+                                                  configuration_.max_frames_per_block);
+    const auto pointers = layout.reserve_bytes(sizeof(float*) * render_channel_count());
+    arena.allocate(layout);
+    render_pointers = arena.as<float*>(pointers);
+    for (uint32_t channel = 0; channel < render_channel_count(); ++channel) {
+        render_pointers[channel] = arena.channel(channels, channel);
+    }
+    next_block_events.set_capacity(configuration_.max_events_per_block);
+}
+
+Headless_host::~Headless_host() {}
+
+uint32_t Headless_host::render_channel_count() const
+{
+    return std::max(configuration_.input_channel_count, configuration_.output_channel_count);
+}
+
+bool Headless_host::add_event(const Audio_event& event) { return next_block_events.push(event); }
+
+bool Headless_host::add_midi_packet(int64_t buffer_offset_time,
+                                    uint8_t cable,
+                                    Midi_packet_format format,
+                                    const uint8_t* bytes,
+                                    size_t size)
+{
+    return next_block_events.push_midi_packet(buffer_offset_time, cable, format, bytes, size);
+}
+
+void Headless_host::render(uint32_t frame_count)
+{
+    BRINICLE_REALTIME_SCOPE();
+    kernel_->sync_from_dsp_thread();
+    kernel_->process(Deinterleaved_audio {render_channel_count(), frame_count, render_pointers},
+                     next_block_events.span());
+    next_block_events.clear();
+}
+
+bool Brinicle::is_allowed_channel_configuration(const KernelFactory::Info& info,
+                                                uint32_t input_channel_count,
+                                                uint32_t output_channel_count)
+{
+    auto matches = [](uint32_t channel_count,
+                      const std::variant<Any_channel_count, Channel_count>& format) {
+        return std::visit(
+            overload {[](Any_channel_count) { return true; },
+                      [&](Channel_count count) { return count.channels == channel_count; }},
+            format);
+    };
+    return std::any_of(begin(info.allowed_channel_configurations),
+                       end(info.allowed_channel_configurations),
+                       [&](const auto& allowed) {
+                           return matches(input_channel_count, allowed.input_channels)
+                               && matches(output_channel_count, allowed.output_channels);
+                       });
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "Brinicle/Kernel/KernelFactory.h"
+#include "Brinicle/Kernel/Render_arena.h"
+#include "Brinicle/Thread/Wrapped_kernel.h"
+#include <memory>
+#include <vector>
+
+namespace Brinicle {
+
+/// Drives a kernel through the same `Wrapped_kernel` stack the audio unit wrappers use, but
+/// without any audio unit host.  This lets us render (and time) kernels on machines without
+/// AudioToolbox.
+///
+/// Like the wrappers, all buffers are allocated up front; `render` itself doesn't allocate.
+class Headless_host {
+public:
+    struct Configuration {
+        uint32_t input_channel_count;
+        uint32_t output_channel_count;
+        double sample_rate;
+        uint32_t max_frames_per_block;
+        size_t max_events_per_block;
+    };
+
+    Headless_host(const KernelFactory& factory, Configuration configuration);
+    ~Headless_host();
+
+    Headless_host(const Headless_host&) = delete;
+    Headless_host& operator=(const Headless_host&) = delete;
+
+    const Configuration& configuration() const { return configuration_; }
+
+    /// The number of channels the kernel renders in-place - this is the max of the input
+    /// and output channel counts.
+    uint32_t render_channel_count() const;
+
+    /// Channel `channel` of the in-place render buffer.  Before `render`, the first
+    /// `input_channel_count` channels are the input; afterwards, the first
+    /// `output_channel_count` are the output.
+    float* channel(uint32_t channel) { return render_pointers[channel]; }
+
+    /// Schedule an event for the next call to `render`.  Returns false (and drops the event)
+    /// if the block is already full.
+    bool add_event(const Audio_event& event);
+
+    /// Schedule a sysex message or MIDI 2.0 packets for the next call to `render`, copying
+    /// `size` bytes into the block's payload.  Returns false (and drops them) if the block is
+    /// already full.
+    bool add_midi_packet(int64_t buffer_offset_time,
+                         uint8_t cable,
+                         Midi_packet_format format,
+                         const uint8_t* bytes,
+                         size_t size);
+
+    /// Render one block of `frame_count` frames, exactly as the audio unit wrappers would.
+    void render(uint32_t frame_count);
+
+    Wrapped_kernel& kernel() { return *kernel_; }
+    const KernelFactory::Info& info() const { return info_; }
+
+private:
+    Configuration configuration_;
+    KernelFactory::Info info_;
+    std::shared_ptr<Wrapped_kernel::Host_interface> client;
+    std::shared_ptr<Wrapped_kernel> kernel_;
+    // Holds the channels and the pointers to them, like the audio unit wrappers do.
+    Render_arena arena;
+    float** render_pointers = nullptr;
+    Audio_event_buffer next_block_events;
+};
+
+bool is_allowed_channel_configuration(const KernelFactory::Info& info,
+                                      uint32_t input_channel_count,
+                                      uint32_t output_channel_count);
+
+}
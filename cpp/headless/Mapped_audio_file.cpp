@@ -0,0 +1,182 @@
+#include "Brinicle/Headless/Mapped_audio_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Brinicle;
+
+namespace {
+constexpr uint16_t wave_format_pcm = 1;
+constexpr uint16_t wave_format_ieee_float = 3;
+constexpr uint16_t wave_format_extensible = 0xfffe;
+}
+
+static uint16_t read_u16(const unsigned char* data)
+{
+    return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8
+        | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+static std::runtime_error file_error(const std::string& path, const std::string& what)
+{
+    return std::runtime_error(path + ": " + what);
+}
+
+Mapped_audio_file::Mapped_audio_file(const std::string& path)
+{
+    map(path);
+    parse_wav(path);
+}
+
+Mapped_audio_file::Mapped_audio_file(const std::string& path, Raw_format format)
+    : channel_count_(format.channel_count), sample_rate_(format.sample_rate)
+{
+    if (channel_count_ == 0) {
+        throw file_error(path, "raw files need at least one channel");
+    }
+    map(path);
+    samples = mapping;
+    frame_count_ = mapping_size / (sizeof(float) * channel_count_);
+}
+
+Mapped_audio_file::~Mapped_audio_file()
+{
+    if (mapping) {
+        munmap(const_cast<unsigned char*>(mapping), mapping_size);
+    }
+}
+
+void Mapped_audio_file::map(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw file_error(path, std::strerror(errno));
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        const auto error = errno;
+        close(fd);
+        throw file_error(path, std::strerror(error));
+    }
+    mapping_size = static_cast<size_t>(status.st_size);
+    if (mapping_size == 0) {
+        close(fd);
+        return;
+    }
+    void* address = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto error = errno;
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw file_error(path, std::strerror(error));
+    }
+    // We read each file front to back, once.
+    madvise(address, mapping_size, MADV_SEQUENTIAL);
+    mapping = static_cast<const unsigned char*>(address);
+}
+
+void Mapped_audio_file::parse_wav(const std::string& path)
+{
+    if (mapping_size < 12 || std::memcmp(mapping, "RIFF", 4) != 0
+        || std::memcmp(mapping + 8, "WAVE", 4) != 0) {
+        throw file_error(path, "not a WAV file");
+    }
+
+    bool found_format = false;
+    size_t offset = 12;
+    while (offset + 8 <= mapping_size) {
+        const auto chunk = mapping + offset;
+        const auto chunk_size = static_cast<size_t>(read_u32(chunk + 4));
+        const auto available = mapping_size - offset - 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && available >= chunk_size) {
+            auto format_tag = read_u16(chunk + 8);
+            channel_count_ = read_u16(chunk + 10);
+            sample_rate_ = read_u32(chunk + 12);
+            const auto bits = read_u16(chunk + 22);
+            if (format_tag == wave_format_extensible && chunk_size >= 40) {
+                // The real format tag is the start of the sub-format GUID.
+                format_tag = read_u16(chunk + 32);
+            }
+            bytes_per_sample = bits / 8u;
+            if (format_tag == wave_format_ieee_float && bits == 32) {
+                sample_format = Sample_format::float32;
+            } else if (format_tag == wave_format_pcm && bits == 16) {
+                sample_format = Sample_format::int16;
+            } else if (format_tag == wave_format_pcm && bits == 24) {
+                sample_format = Sample_format::int24;
+            } else if (format_tag == wave_format_pcm && bits == 32) {
+                sample_format = Sample_format::int32;
+            } else {
+                throw file_error(path, "unsupported WAV sample format");
+            }
+            if (channel_count_ == 0) {
+                throw file_error(path, "WAV file has no channels");
+            }
+            found_format = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!found_format) {
+                throw file_error(path, "WAV data chunk comes before its format chunk");
+            }
+            // Writers that exceed the 4GB RIFF limit leave the size as 0xffffffff, and
+            // truncated files claim more than they have, so then we go by the file size.
+            const auto data_size = chunk_size == 0xffffffff ? available
+                                                            : std::min(chunk_size, available);
+            samples = chunk + 8;
+            frame_count_ = data_size / (bytes_per_sample * channel_count_);
+            return;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+    throw file_error(path, "WAV file has no data");
+}
+
+void Mapped_audio_file::read(uint64_t first, size_t count, float* const* channels) const
+{
+    const auto available = first < frame_count_
+        ? static_cast<size_t>(std::min<uint64_t>(count, frame_count_ - first))
+        : 0;
+    const auto frame_bytes = static_cast<size_t>(bytes_per_sample) * channel_count_;
+    const auto frames = samples + first * frame_bytes;
+
+    for (uint32_t channel = 0; channel < channel_count_; ++channel) {
+        auto out = channels[channel];
+        auto in = frames + channel * bytes_per_sample;
+        switch (sample_format) {
+        case Sample_format::float32:
+            for (size_t frame = 0; frame < available; ++frame, in += frame_bytes) {
+                std::memcpy(out + frame, in, sizeof(float));
+            }
+            break;
+        case Sample_format::int16:
+            for (size_t frame = 0; frame < available; ++frame, in += frame_bytes) {
+                out[frame] = static_cast<int16_t>(read_u16(in)) * (1.f / 32768.f);
+            }
+            break;
+        case Sample_format::int24:
+            for (size_t frame = 0; frame < available; ++frame, in += frame_bytes) {
+                const auto value = static_cast<int32_t>(static_cast<uint32_t>(in[0]) << 8
+                                                        | static_cast<uint32_t>(in[1]) << 16
+                                                        | static_cast<uint32_t>(in[2]) << 24);
+                out[frame] = static_cast<float>(value) * (1.f / 2147483648.f);
+            }
+            break;
+        case Sample_format::int32:
+            for (size_t frame = 0; frame < available; ++frame, in += frame_bytes) {
+                out[frame] = static_cast<float>(static_cast<int32_t>(read_u32(in)))
+                    * (1.f / 2147483648.f);
+            }
+            break;
+        }
+        std::fill(out + available, out + count, 0.f);
+    }
+}
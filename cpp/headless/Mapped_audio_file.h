@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Brinicle {
+
+/// A read-only audio file, memory-mapped so that even very large files can be read in blocks
+/// without copying them into memory first.
+///
+/// Supports WAV files with 16, 24 or 32-bit integer or 32-bit float samples, and headerless
+/// files of interleaved 32-bit native-endian floats.  Throws `std::runtime_error` if the file
+/// can't be opened or isn't in a supported format.
+class Mapped_audio_file {
+public:
+    struct Raw_format {
+        uint32_t channel_count;
+        double sample_rate;
+    };
+
+    /// Opens a WAV file.
+    explicit Mapped_audio_file(const std::string& path);
+
+    /// Opens a file of raw interleaved floats.
+    Mapped_audio_file(const std::string& path, Raw_format format);
+
+    ~Mapped_audio_file();
+
+    Mapped_audio_file(const Mapped_audio_file&) = delete;
+    Mapped_audio_file& operator=(const Mapped_audio_file&) = delete;
+
+    uint32_t channel_count() const { return channel_count_; }
+    double sample_rate() const { return sample_rate_; }
+    uint64_t frame_count() const { return frame_count_; }
+
+    /// De-interleaves frames `[first, first + count)` into `channels`, converting to float.
+    /// Frames past the end of the file read as silence.
+    void read(uint64_t first, size_t count, float* const* channels) const;
+
+private:
+    enum class Sample_format {
+        int16,
+        int24,
+        int32,
+        float32,
+    };
+
+    void map(const std::string& path);
+    void parse_wav(const std::string& path);
+
+    const unsigned char* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    const unsigned char* samples = nullptr;
+    Sample_format sample_format = Sample_format::float32;
+    uint32_t bytes_per_sample = 4;
+    uint32_t channel_count_ = 0;
+    double sample_rate_ = 0.;
+    uint64_t frame_count_ = 0;
+};
+
+}
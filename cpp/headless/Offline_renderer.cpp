@@ -0,0 +1,94 @@
+#include "Brinicle/Headless/Offline_renderer.h"
+#include "Brinicle/Headless/Headless_host.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+}
+
+static double seconds_between(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+Offline_render_result Brinicle::render_offline(const KernelFactory& factory,
+                                               const Mapped_audio_file& input,
+                                               const std::string& output_path,
+                                               Audio_file_writer::Format output_format,
+                                               const Offline_render_options& options)
+{
+    const auto& info = factory.info();
+    if (info.type != KernelFactory::Type::effect) {
+        throw std::invalid_argument("offline rendering needs an effect kernel");
+    }
+    const auto input_channels = input.channel_count();
+    const auto output_channels = options.output_channel_count ? options.output_channel_count
+                                                              : input_channels;
+    if (!is_allowed_channel_configuration(info, input_channels, output_channels)) {
+        throw std::invalid_argument("kernel doesn't support this channel configuration");
+    }
+    if (options.block_size == 0) {
+        throw std::invalid_argument("block size must be positive");
+    }
+
+    const auto start = Clock::now();
+    Headless_host host(factory,
+                       Headless_host::Configuration {input_channels,
+                                                     output_channels,
+                                                     input.sample_rate(),
+                                                     options.block_size,
+                                                     1});
+    for (const auto& [address, value] : options.parameters) {
+        host.kernel().set_parameter(address, value);
+    }
+    Audio_file_writer output(output_path, output_format, output_channels, input.sample_rate());
+
+    std::vector<float*> input_pointers(input_channels);
+    std::vector<const float*> output_pointers(output_channels);
+    for (uint32_t channel = 0; channel < input_channels; ++channel) {
+        input_pointers[channel] = host.channel(channel);
+    }
+
+    Offline_render_result result {};
+    result.input_frames = input.frame_count();
+    const auto tail_frames = static_cast<uint64_t>(options.tail_seconds * input.sample_rate());
+    const auto wanted_frames = result.input_frames + tail_frames;
+
+    uint64_t frames_read = 0;
+    uint64_t frames_to_skip = 0;
+    while (result.output_frames < wanted_frames) {
+        const auto block_start = Clock::now();
+        input.read(frames_read, options.block_size, input_pointers.data());
+        frames_read += options.block_size;
+
+        const auto render_start = Clock::now();
+        host.render(options.block_size);
+        if (frames_read == options.block_size) {
+            result.latency_frames = host.kernel().get_latency();
+            frames_to_skip = result.latency_frames;
+        }
+
+        const auto write_start = Clock::now();
+        const auto skip = std::min<uint64_t>(frames_to_skip, options.block_size);
+        frames_to_skip -= skip;
+        const auto frames
+            = std::min<uint64_t>(options.block_size - skip, wanted_frames - result.output_frames);
+        for (uint32_t channel = 0; channel < output_channels; ++channel) {
+            output_pointers[channel] = host.channel(channel) + skip;
+        }
+        output.write(output_pointers.data(), frames);
+        result.output_frames += frames;
+        const auto block_end = Clock::now();
+
+        result.read_seconds += seconds_between(block_start, render_start);
+        result.render_seconds += seconds_between(render_start, write_start);
+        result.write_seconds += seconds_between(write_start, block_end);
+    }
+    output.finish();
+    result.total_seconds = seconds_between(start, Clock::now());
+    return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Brinicle/Headless/Audio_file_writer.h"
+#include "Brinicle/Headless/Mapped_audio_file.h"
+#include "Brinicle/Kernel/KernelFactory.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Brinicle {
+
+struct Offline_render_options {
+    uint32_t block_size = 4096;
+
+    /// Zero means the same as the input.
+    uint32_t output_channel_count = 0;
+
+    /// How long to keep rendering silence after the input ends, e.g. for reverb tails.
+    double tail_seconds = 0.;
+
+    /// (address, value) pairs to apply before the first block.
+    std::vector<std::pair<uint64_t, float>> parameters;
+};
+
+struct Offline_render_result {
+    uint64_t input_frames;
+    uint64_t output_frames;
+    uint64_t latency_frames;
+
+    /// Time spent reading input, rendering and queueing output, respectively.
+    double read_seconds;
+    double render_seconds;
+    double write_seconds;
+
+    /// Wall-clock time for the whole render, including waiting for the disk at the end.
+    double total_seconds;
+};
+
+/// Runs a kernel from `factory` over all of `input`, writing the result to `output_path`, as
+/// fast as possible.
+///
+/// Goes through the same `Wrapped_kernel` stack as the audio units.  The kernel's latency
+/// (as of the first block) is trimmed off the start of the output, and the input is followed
+/// by silence long enough to flush it, plus `tail_seconds`, so the output lines up with the
+/// input.  Throws `std::invalid_argument` if the kernel doesn't support the channel
+/// configuration or isn't an effect, and `std::runtime_error` on I/O errors.
+Offline_render_result render_offline(const KernelFactory& factory,
+                                     const Mapped_audio_file& input,
+                                     const std::string& output_path,
+                                     Audio_file_writer::Format output_format,
+                                     const Offline_render_options& options);
+
+}
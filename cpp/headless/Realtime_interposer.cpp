@@ -0,0 +1,266 @@
+// Link this into a program (together with code built with `BRINICLE_REALTIME_CHECKS=1`) to
+// report calls that aren't real-time safe from inside a `Realtime_checks::Scope`.
+//
+// `operator new` and `delete` are replaced everywhere.  On Linux (glibc), the `malloc` family,
+// mutex and condition variable waits, sleeps and blocking IO are interposed as well, by
+// defining them here and forwarding to the next definition (`dlsym(RTLD_NEXT, ...)`); this
+// catches calls made by other libraries too, including the Rust kernel.  Link with `-ldl` on
+// glibc older than 2.34.
+
+#include "Brinicle/Thread/Realtime_checks.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#define BRINICLE_INTERPOSE_LIBC 1
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+}
+#else
+#define BRINICLE_INTERPOSE_LIBC 0
+#endif
+
+using namespace Brinicle;
+
+using Realtime_checks::Violation;
+
+// Allocate without reporting; on glibc, our `malloc` would report a second time.
+static void* raw_malloc(size_t size)
+{
+#if BRINICLE_INTERPOSE_LIBC
+    return __libc_malloc(size);
+#else
+    return std::malloc(size);
+#endif
+}
+
+static void* raw_aligned_malloc(size_t size, size_t alignment)
+{
+#if BRINICLE_INTERPOSE_LIBC
+    return __libc_memalign(alignment, size);
+#else
+    void* ret = nullptr;
+    return posix_memalign(&ret, alignment, size) == 0 ? ret : nullptr;
+#endif
+}
+
+static void raw_free(void* pointer)
+{
+#if BRINICLE_INTERPOSE_LIBC
+    __libc_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+static void* checked_new(size_t size, size_t alignment, bool nothrow)
+{
+    Realtime_checks::check(Violation::allocation, "operator new");
+    if (size == 0) {
+        size = 1;
+    }
+    void* ret = alignment > alignof(std::max_align_t) ? raw_aligned_malloc(size, alignment)
+                                                      : raw_malloc(size);
+    if (!ret && !nothrow) {
+        throw std::bad_alloc();
+    }
+    return ret;
+}
+
+static void checked_delete(void* pointer)
+{
+    if (pointer) {
+        Realtime_checks::check(Violation::allocation, "operator delete");
+        raw_free(pointer);
+    }
+}
+
+void* operator new(size_t size) { return checked_new(size, 0, false); }
+void* operator new[](size_t size) { return checked_new(size, 0, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return checked_new(size, 0, true);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return checked_new(size, 0, true);
+}
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return checked_new(size, static_cast<size_t>(alignment), false);
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return checked_new(size, static_cast<size_t>(alignment), false);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return checked_new(size, static_cast<size_t>(alignment), true);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return checked_new(size, static_cast<size_t>(alignment), true);
+}
+
+void operator delete(void* pointer) noexcept { checked_delete(pointer); }
+void operator delete[](void* pointer) noexcept { checked_delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { checked_delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { checked_delete(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { checked_delete(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { checked_delete(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { checked_delete(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { checked_delete(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    checked_delete(pointer);
+}
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+    checked_delete(pointer);
+}
+
+#if BRINICLE_INTERPOSE_LIBC
+
+// Looks up the definition `name` would have had without this file.  A race here just looks
+// the symbol up twice.
+static void* next_definition(std::atomic<void*>& cache, const char* name)
+{
+    auto ret = cache.load(std::memory_order_relaxed);
+    if (!ret) {
+        Realtime_checks::Allowed allowed;
+        ret = dlsym(RTLD_NEXT, name);
+        cache.store(ret, std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+#define BRINICLE_FORWARD(kind, name, ...)                                                      \
+    do {                                                                                       \
+        static std::atomic<void*> next_##name = {nullptr};                                     \
+        Realtime_checks::check(Violation::kind, #name);                                        \
+        return reinterpret_cast<decltype(&::name)>(next_definition(next_##name, #name))(       \
+            __VA_ARGS__);                                                                      \
+    } while (false)
+
+extern "C" {
+
+void* malloc(size_t size) __THROW
+{
+    Realtime_checks::check(Violation::allocation, "malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW
+{
+    Realtime_checks::check(Violation::allocation, "calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) __THROW
+{
+    Realtime_checks::check(Violation::allocation, "realloc");
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) __THROW
+{
+    if (pointer) {
+        Realtime_checks::check(Violation::allocation, "free");
+    }
+    __libc_free(pointer);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) __THROW
+{
+    Realtime_checks::check(Violation::allocation, "aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) __THROW
+{
+    BRINICLE_FORWARD(allocation, posix_memalign, out, alignment, size);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL
+{
+    BRINICLE_FORWARD(lock, pthread_mutex_lock, mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) __THROWNL
+{
+    BRINICLE_FORWARD(lock, pthread_rwlock_rdlock, lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) __THROWNL
+{
+    BRINICLE_FORWARD(lock, pthread_rwlock_wrlock, lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+    BRINICLE_FORWARD(blocking_call, pthread_cond_wait, condition, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* condition,
+                           pthread_mutex_t* mutex,
+                           const struct timespec* time)
+{
+    BRINICLE_FORWARD(blocking_call, pthread_cond_timedwait, condition, mutex, time);
+}
+
+int pthread_join(pthread_t thread, void** result)
+{
+    BRINICLE_FORWARD(blocking_call, pthread_join, thread, result);
+}
+
+int sem_wait(sem_t* semaphore) { BRINICLE_FORWARD(blocking_call, sem_wait, semaphore); }
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    BRINICLE_FORWARD(blocking_call, nanosleep, duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock,
+                    int flags,
+                    const struct timespec* duration,
+                    struct timespec* remaining)
+{
+    BRINICLE_FORWARD(blocking_call, clock_nanosleep, clock, flags, duration, remaining);
+}
+
+int usleep(useconds_t duration) { BRINICLE_FORWARD(blocking_call, usleep, duration); }
+
+unsigned int sleep(unsigned int seconds) { BRINICLE_FORWARD(blocking_call, sleep, seconds); }
+
+ssize_t read(int file, void* buffer, size_t size)
+{
+    BRINICLE_FORWARD(blocking_call, read, file, buffer, size);
+}
+
+ssize_t write(int file, const void* buffer, size_t size)
+{
+    BRINICLE_FORWARD(blocking_call, write, file, buffer, size);
+}
+
+int fsync(int file) { BRINICLE_FORWARD(blocking_call, fsync, file); }
+
+int poll(struct pollfd* files, nfds_t count, int timeout)
+{
+    BRINICLE_FORWARD(blocking_call, poll, files, count, timeout);
+}
+}
+
+#endif
@@ -0,0 +1,27 @@
+#include "Brinicle/Headless/Timing_statistics.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace Brinicle;
+
+Timing_statistics Brinicle::summarize_timings(std::vector<uint64_t>& samples_ns)
+{
+    if (samples_ns.empty()) {
+        return Timing_statistics {0, 0., 0, 0, 0, 0, 0, 0};
+    }
+
+    std::sort(begin(samples_ns), end(samples_ns));
+    auto percentile = [&](double p) {
+        auto index = static_cast<size_t>(p * static_cast<double>(samples_ns.size() - 1) + 0.5);
+        return samples_ns[std::min(index, samples_ns.size() - 1)];
+    };
+    const auto total = std::accumulate(begin(samples_ns), end(samples_ns), uint64_t(0));
+    return Timing_statistics {samples_ns.size(),
+                              static_cast<double>(total) / static_cast<double>(samples_ns.size()),
+                              percentile(0.5),
+                              percentile(0.9),
+                              percentile(0.99),
+                              percentile(0.999),
+                              samples_ns.back(),
+                              total};
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Summary of a set of per-block timings, in nanoseconds.
+struct Timing_statistics {
+    size_t count;
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    uint64_t total_ns;
+};
+
+/// Note that this sorts `samples_ns` in place.
+Timing_statistics summarize_timings(std::vector<uint64_t>& samples_ns);
+
+}
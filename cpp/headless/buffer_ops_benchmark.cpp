@@ -0,0 +1,358 @@
+// Times each `Buffer_ops` operation, in every implementation this CPU supports, against the
+// scalar version, and checks that they all give the same results.  Then, for each `--channels`
+// count, times the channel-batched operations against calling the single-channel ones for
+// each channel, at the short block sizes in `--batch-frames`.  Exits non-zero if any
+// implementation disagrees with the scalar one.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> frame_counts = {64, 256, 1024, 4096};
+    std::vector<size_t> batch_frame_counts = {16, 32, 64, 256};
+    std::vector<size_t> channel_counts = {16, 64};
+    size_t repetitions = 20000;
+};
+
+struct Operation {
+    const char* name;
+
+    // Runs the operation from `implementation` on `in` and `out`, returning a value to check.
+    std::function<float(const Buffer_ops::Implementation&, const float*, float*, size_t)> run;
+};
+
+// A channel-batched operation, and the same thing done a channel at a time.
+struct Batched_operation {
+    const char* name;
+
+    // Run on `channel_count` channels of `frame_count` frames, with `values` per channel.
+    std::function<void(
+        const Buffer_ops::Implementation&, float* const*, float*, size_t, size_t)>
+        run_batched;
+    std::function<void(
+        const Buffer_ops::Implementation&, float* const*, float*, size_t, size_t)>
+        run_per_channel;
+};
+}
+
+// Keeps results from being optimized away.
+static std::atomic<float> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--frames") == 0) {
+            options.frame_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--batch-frames") == 0) {
+            options.batch_frame_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--channels") == 0) {
+            options.channel_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--repetitions") == 0) {
+            options.repetitions = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+static std::vector<Operation> make_operations()
+{
+    // Gains are close to one, so that repeating an operation in place stays in range.
+    return {
+        {"copy",
+         [](const auto& ops, const float* in, float* out, size_t n) {
+             ops.copy(in, out, n);
+             return 0.f;
+         }},
+        {"add",
+         [](const auto& ops, const float* in, float* out, size_t n) {
+             ops.add(in, out, n);
+             return 0.f;
+         }},
+        {"multiply_add",
+         [](const auto& ops, const float* in, float* out, size_t n) {
+             ops.multiply_add(in, -0.5f, out, n);
+             return 0.f;
+         }},
+        {"gain",
+         [](const auto& ops, const float*, float* out, size_t n) {
+             ops.apply_gain(out, 0.999f, n);
+             return 0.f;
+         }},
+        {"gain_ramp",
+         [](const auto& ops, const float*, float* out, size_t n) {
+             ops.apply_gain_ramp(out, 1.001f, 0.999f, n);
+             return 0.f;
+         }},
+        {"clear",
+         [](const auto& ops, const float*, float* out, size_t n) {
+             ops.clear(out, n);
+             return 0.f;
+         }},
+        {"peak",
+         [](const auto& ops, const float* in, float*, size_t n) { return ops.peak(in, n); }},
+    };
+}
+
+static std::vector<Batched_operation> make_batched_operations()
+{
+    // `values` holds gains close to one, or takes peaks.
+    return {
+        {"gains",
+         [](const auto& ops, float* const* channels, float* values, size_t c, size_t n) {
+             ops.apply_gains(channels, values, c, n);
+         },
+         [](const auto& ops, float* const* channels, float* values, size_t c, size_t n) {
+             for (size_t channel = 0; channel < c; ++channel) {
+                 ops.apply_gain(channels[channel], values[channel], n);
+             }
+         }},
+        {"peaks",
+         [](const auto& ops, float* const* channels, float* values, size_t c, size_t n) {
+             ops.peaks(channels, values, c, n);
+         },
+         [](const auto& ops, float* const* channels, float* values, size_t c, size_t n) {
+             for (size_t channel = 0; channel < c; ++channel) {
+                 values[channel] = ops.peak(channels[channel], n);
+             }
+         }},
+    };
+}
+
+// Channels of random audio, with the pointers to them.
+struct Channels {
+    Channels(size_t channel_count, size_t frame_count, size_t offset)
+        : storage(channel_count, std::vector<float>(frame_count + offset))
+    {
+        std::mt19937 random(2);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        for (auto& channel : storage) {
+            std::generate(begin(channel), end(channel), [&] { return distribution(random); });
+            pointers.push_back(channel.data() + offset);
+        }
+    }
+
+    std::vector<std::vector<float>> storage;
+    std::vector<float*> pointers;
+};
+
+// Gains close to one, so that repeating an operation in place stays in range.
+static std::vector<float> batch_values(size_t channel_count)
+{
+    std::vector<float> values(channel_count);
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        values[channel] = 0.999f + 0.0001f * static_cast<float>(channel % 8);
+    }
+    return values;
+}
+
+// Runs `operation` batched once from fresh buffers, and checks it matches the scalar version.
+static bool check_batched(const Batched_operation& operation,
+                          const Buffer_ops::Implementation& implementation,
+                          const Buffer_ops::Implementation& scalar,
+                          size_t channel_count,
+                          size_t frame_count)
+{
+    // Odd channel counts, offsets and lengths exercise the leftover channels, unaligned loads
+    // and the lanes.
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (auto channels : {channel_count, channel_count - 1, size_t(3)}) {
+            for (auto count : {frame_count, frame_count - 1, size_t(3)}) {
+                Channels expected(channels, count, offset);
+                Channels actual(channels, count, offset);
+                auto expected_values = batch_values(channels);
+                auto actual_values = expected_values;
+                operation.run_batched(
+                    scalar, expected.pointers.data(), expected_values.data(), channels, count);
+                operation.run_batched(
+                    implementation, actual.pointers.data(), actual_values.data(), channels, count);
+                if (actual.storage != expected.storage || actual_values != expected_values) {
+                    std::printf("MISMATCH: %s %s, %zu channels of %zu frames at offset %zu\n",
+                                implementation.name,
+                                operation.name,
+                                channels,
+                                count,
+                                offset);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Returns the mean time per call, in nanoseconds, of `run` on `channel_count` channels.
+template <typename Run>
+static double time_batched(const Run& run,
+                           const Buffer_ops::Implementation& implementation,
+                           size_t channel_count,
+                           size_t frame_count,
+                           size_t repetitions)
+{
+    Channels channels(channel_count, frame_count, 0);
+    auto values = batch_values(channel_count);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+        run(implementation, channels.pointers.data(), values.data(), channel_count, frame_count);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    benchmark_sink = benchmark_sink + values[0] + channels.pointers[0][frame_count / 2];
+    return std::chrono::duration<double, std::nano>(end - start).count()
+        / static_cast<double>(repetitions);
+}
+
+// Runs `operation` once from fresh buffers, and checks it matches the scalar version.
+static bool check(const Operation& operation,
+                  const Buffer_ops::Implementation& implementation,
+                  const Buffer_ops::Implementation& scalar,
+                  const std::vector<float>& input,
+                  size_t frame_count)
+{
+    // Odd offsets and lengths exercise unaligned loads and the scalar tails.
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (auto count : {frame_count, frame_count - 1, size_t(3)}) {
+            auto expected = std::vector<float>(input.rbegin(), input.rend());
+            auto actual = expected;
+            const auto expected_value
+                = operation.run(scalar, input.data() + offset, expected.data() + offset, count);
+            const auto actual_value = operation.run(
+                implementation, input.data() + offset, actual.data() + offset, count);
+            bool same = expected_value == actual_value;
+            for (size_t i = 0; i < actual.size(); ++i) {
+                same = same && std::fabs(actual[i] - expected[i]) <= 1e-6f;
+            }
+            if (!same) {
+                std::printf("MISMATCH: %s %s, %zu frames at offset %zu\n",
+                            implementation.name,
+                            operation.name,
+                            count,
+                            offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Returns the mean time per call, in nanoseconds.  Calls are timed together, since a single
+// call on a short buffer takes about as long as reading the clock.
+static double time_operation(const Operation& operation,
+                             const Buffer_ops::Implementation& implementation,
+                             const std::vector<float>& input,
+                             std::vector<float>& output,
+                             size_t frame_count,
+                             size_t repetitions)
+{
+    float sink = 0.f;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+        sink += operation.run(implementation, input.data(), output.data(), frame_count);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    benchmark_sink = benchmark_sink + sink + output[frame_count / 2];
+    return std::chrono::duration<double, std::nano>(end - start).count()
+        / static_cast<double>(repetitions);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--frames 64,256,...] [--batch-frames 16,32,...] "
+                     "[--channels 16,64,...] [--repetitions 20000]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const auto implementations = Buffer_ops::supported_implementations();
+    const auto& scalar = *implementations.front();
+    std::printf("using %s\n", Buffer_ops::implementation().name);
+
+    const auto max_frames = *std::max_element(begin(options.frame_counts),
+                                               end(options.frame_counts));
+    std::vector<float> input(max_frames + 8);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::generate(begin(input), end(input), [&] { return distribution(random); });
+    std::vector<float> output(input.size());
+
+    bool ok = true;
+    std::printf("%-14s %8s %-8s %12s %10s\n", "operation", "frames", "impl", "mean_ns", "speedup");
+    for (const auto& operation : make_operations()) {
+        for (auto frame_count : options.frame_counts) {
+            double scalar_ns = 0.;
+            for (const auto implementation : implementations) {
+                ok = check(operation, *implementation, scalar, input, frame_count) && ok;
+                std::copy(begin(input), end(input), begin(output));
+                const auto mean_ns = time_operation(
+                    operation, *implementation, input, output, frame_count, options.repetitions);
+                if (implementation == &scalar) {
+                    scalar_ns = mean_ns;
+                }
+                std::printf("%-14s %8zu %-8s %12.1f %10.2f\n",
+                            operation.name,
+                            frame_count,
+                            implementation->name,
+                            mean_ns,
+                            scalar_ns / mean_ns);
+            }
+        }
+    }
+
+    std::printf("\n%-14s %8s %8s %-8s %14s %12s %10s\n",
+                "batched",
+                "channels",
+                "frames",
+                "impl",
+                "per_channel_ns",
+                "batched_ns",
+                "speedup");
+    for (const auto& operation : make_batched_operations()) {
+        for (auto channel_count : options.channel_counts) {
+            for (auto frame_count : options.batch_frame_counts) {
+                if (channel_count < 4 || frame_count < 4) {
+                    continue;
+                }
+                for (const auto implementation : implementations) {
+                    ok = check_batched(
+                             operation, *implementation, scalar, channel_count, frame_count)
+                        && ok;
+                    const auto per_channel_ns = time_batched(operation.run_per_channel,
+                                                             *implementation,
+                                                             channel_count,
+                                                             frame_count,
+                                                             options.repetitions);
+                    const auto batched_ns = time_batched(operation.run_batched,
+                                                         *implementation,
+                                                         channel_count,
+                                                         frame_count,
+                                                         options.repetitions);
+                    std::printf("%-14s %8zu %8zu %-8s %14.1f %12.1f %10.2f\n",
+                                operation.name,
+                                channel_count,
+                                frame_count,
+                                implementation->name,
+                                per_channel_ns,
+                                batched_ns,
+                                per_channel_ns / batched_ns);
+                }
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
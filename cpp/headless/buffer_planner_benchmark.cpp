@@ -0,0 +1,426 @@
+// Checks `Buffer_planner` against every combination of input kind, channel counts, host
+// buffers and in-place policy, and against pulls that replace only some channels' buffers,
+// then compares the audio the wrappers copied per block before they used it with what they
+// copy now, for the render paths where that differs.  Doesn't need a kernel.  Exits non-zero
+// if any plan renders the wrong output, overwrites input it mustn't, or copies more than it
+// needs to.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include "Brinicle/Kernel/Buffer_planner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    uint32_t frames = 512;
+    size_t blocks = 20000;
+};
+
+constexpr uint32_t max_channels = 4;
+constexpr uint32_t check_frames = 16;
+
+// How the host hands over its output buffers in a check.
+enum class Host_output { none, all, some, same_as_input };
+
+const char* input_name(Buffer_planner::Input input)
+{
+    switch (input) {
+    case Buffer_planner::Input::none:
+        return "none";
+    case Buffer_planner::Input::pulled:
+        return "pulled";
+    default:
+        return "supplied";
+    }
+}
+
+const char* host_output_name(Host_output host_output)
+{
+    switch (host_output) {
+    case Host_output::none:
+        return "none";
+    case Host_output::all:
+        return "all";
+    case Host_output::some:
+        return "some";
+    default:
+        return "same as input";
+    }
+}
+
+float input_sample(uint32_t channel, uint32_t frame) { return float(channel * 100 + frame + 1); }
+
+// Stands in for a kernel processing in place: reads each channel's input, and overwrites it.
+void process(float* const* channels, uint32_t channel_count, uint32_t input_count)
+{
+    for (uint32_t channel = 0; channel < channel_count; ++channel) {
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            const auto in = channel < input_count ? channels[channel][frame] : 0.f;
+            channels[channel][frame] = in * 2.f + float(channel);
+        }
+    }
+}
+
+// One plan, run as a wrapper would.  Prints what went wrong and returns false if anything did.
+bool check(Buffer_planner::Input input,
+           uint32_t input_count,
+           uint32_t output_count,
+           Host_output host_output,
+           bool process_in_place)
+{
+    using Buffers = std::vector<std::vector<float>>;
+    auto make_buffers = [] { return Buffers(max_channels, std::vector<float>(check_frames)); };
+    auto input_buffers = make_buffers();
+    auto output_buffers = make_buffers();
+    auto scratch_buffers = make_buffers();
+    std::vector<float*> inputs, outputs, scratch;
+    for (uint32_t channel = 0; channel < max_channels; ++channel) {
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            input_buffers[channel][frame] = input_sample(channel, frame);
+        }
+        inputs.push_back(input_buffers[channel].data());
+        scratch.push_back(scratch_buffers[channel].data());
+        switch (host_output) {
+        case Host_output::none:
+        case Host_output::all:
+            outputs.push_back(output_buffers[channel].data());
+            break;
+        case Host_output::some:
+            outputs.push_back(channel % 2 ? nullptr : output_buffers[channel].data());
+            break;
+        case Host_output::same_as_input:
+            outputs.push_back(input_buffers[channel].data());
+            break;
+        }
+    }
+
+    const auto supplied = input == Buffer_planner::Input::supplied;
+    Buffer_planner planner(scratch.data(), max_channels, max_channels);
+    const auto request = Buffer_planner::Request {
+        input,
+        input_count,
+        output_count,
+        inputs.data(),
+        host_output == Host_output::none ? nullptr : outputs.data(),
+        process_in_place};
+    const auto description = std::string(input_name(input)) + ", " + std::to_string(input_count)
+        + " in, " + std::to_string(output_count) + " out, host output "
+        + host_output_name(host_output) + (process_in_place ? ", in place" : "");
+    auto fail = [&](const char* why) {
+        std::fprintf(stderr, "FAIL: %s: %s\n", description.c_str(), why);
+        return false;
+    };
+    if (!planner.plan(request)) {
+        return fail("no plan");
+    }
+
+    const auto render = planner.render_channels();
+    const auto render_count = planner.render_channel_count();
+    if (render_count != std::max(input == Buffer_planner::Input::none ? 0 : input_count,
+                                 output_count)) {
+        return fail("wrong number of render channels");
+    }
+    for (uint32_t a = 0; a < render_count; ++a) {
+        for (uint32_t b = a + 1; b < render_count; ++b) {
+            if (render[a] == render[b]) {
+                return fail("two channels render in the same buffer");
+            }
+        }
+    }
+
+    // The fewest copies any plan could make: supplied input that has to move to a buffer the
+    // host wants output in, or out of a buffer we mustn't write.
+    size_t needed_copies = 0;
+    for (uint32_t channel = 0; supplied && channel < input_count; ++channel) {
+        auto host = channel < output_count ? request.host_output ? outputs[channel] : nullptr
+                                           : nullptr;
+        if (host == inputs[channel] && !process_in_place) {
+            host = nullptr;
+        }
+        needed_copies += host ? host != inputs[channel] : !process_in_place;
+    }
+    if (planner.copy_count() != needed_copies) {
+        return fail("copies more than it needs to");
+    }
+
+    if (input == Buffer_planner::Input::pulled) {
+        for (uint32_t channel = 0; channel < input_count; ++channel) {
+            for (uint32_t frame = 0; frame < check_frames; ++frame) {
+                render[channel][frame] = input_sample(channel, frame);
+            }
+        }
+    }
+    planner.copy_input(check_frames);
+    process(render, render_count, input == Buffer_planner::Input::none ? 0 : input_count);
+
+    for (uint32_t channel = 0; channel < output_count; ++channel) {
+        const auto host = request.host_output ? outputs[channel] : nullptr;
+        const bool host_takes_ours = !host || (host == inputs[channel] && !process_in_place);
+        if (!host_takes_ours && render[channel] != host) {
+            return fail("didn't render into the host's output");
+        }
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            const auto in = input != Buffer_planner::Input::none && channel < input_count
+                ? input_sample(channel, frame)
+                : 0.f;
+            if (render[channel][frame] != in * 2.f + float(channel)) {
+                return fail("wrong output");
+            }
+        }
+    }
+    for (uint32_t channel = 0; supplied && !process_in_place && channel < input_count; ++channel) {
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            if (input_buffers[channel][frame] != input_sample(channel, frame)) {
+                return fail("overwrote input without processing in place");
+            }
+        }
+    }
+    return true;
+}
+
+// Pulls input, as the AUv3 wrapper does, from a host that hands over its own buffers for the
+// odd channels and renders the rest into ours, then plans again with just the replaced
+// channels as supplied input.  Checks that every channel's output ends up where the host
+// will read it.
+bool check_partial_pull(uint32_t input_count, uint32_t output_count, Host_output host_output)
+{
+    using Buffers = std::vector<std::vector<float>>;
+    auto make_buffers = [] { return Buffers(max_channels, std::vector<float>(check_frames)); };
+    auto pulled_buffers = make_buffers();
+    auto output_buffers = make_buffers();
+    auto scratch_buffers = make_buffers();
+    std::vector<float*> outputs, scratch;
+    for (uint32_t channel = 0; channel < max_channels; ++channel) {
+        scratch.push_back(scratch_buffers[channel].data());
+        const bool given = host_output == Host_output::all
+            || (host_output == Host_output::some && channel % 2 == 0);
+        outputs.push_back(given ? output_buffers[channel].data() : nullptr);
+    }
+
+    Buffer_planner planner(scratch.data(), max_channels, max_channels);
+    auto request = Buffer_planner::Request {Buffer_planner::Input::pulled,
+                                            input_count,
+                                            output_count,
+                                            nullptr,
+                                            outputs.data(),
+                                            false};
+    const auto description = std::to_string(input_count) + " in, "
+        + std::to_string(output_count) + " out, host output " + host_output_name(host_output)
+        + ", odd channels replaced by the pull";
+    auto fail = [&](const char* why) {
+        std::fprintf(stderr, "FAIL: %s: %s\n", description.c_str(), why);
+        return false;
+    };
+    if (!planner.plan(request)) {
+        return fail("no plan");
+    }
+
+    std::vector<float*> pulled(input_count);
+    bool in_place[max_channels];
+    for (uint32_t channel = 0; channel < input_count; ++channel) {
+        in_place[channel] = channel % 2 == 0;
+        pulled[channel] = in_place[channel] ? planner.render_channels()[channel]
+                                            : pulled_buffers[channel].data();
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            pulled[channel][frame] = input_sample(channel, frame);
+        }
+    }
+    request.input = Buffer_planner::Input::supplied;
+    request.supplied_input = pulled.data();
+    request.channel_in_place = in_place;
+    if (!planner.plan(request)) {
+        return fail("no plan after the pull");
+    }
+
+    // Channels the host left null take ours, as the wrapper points them at the plan's.
+    const auto render = planner.render_channels();
+    for (uint32_t channel = 0; channel < output_count; ++channel) {
+        if (!outputs[channel]) {
+            outputs[channel] = render[channel];
+        }
+    }
+    planner.copy_input(check_frames);
+    process(render, planner.render_channel_count(), input_count);
+
+    size_t replaced_inputs = 0;
+    for (uint32_t channel = 0; channel < input_count; ++channel) {
+        replaced_inputs += !in_place[channel];
+    }
+    if (planner.copy_count() != replaced_inputs) {
+        return fail("copies more than the replaced channels");
+    }
+    for (uint32_t channel = 0; channel < output_count; ++channel) {
+        if (render[channel] != outputs[channel]) {
+            return fail("didn't render where the host reads the output");
+        }
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            const auto in = channel < input_count ? input_sample(channel, frame) : 0.f;
+            if (outputs[channel][frame] != in * 2.f + float(channel)) {
+                return fail("wrong output");
+            }
+        }
+    }
+    for (uint32_t channel = 1; channel < input_count; channel += 2) {
+        for (uint32_t frame = 0; frame < check_frames; ++frame) {
+            if (pulled_buffers[channel][frame] != input_sample(channel, frame)) {
+                return fail("overwrote the host's buffer");
+            }
+        }
+    }
+    return true;
+}
+
+size_t check_all()
+{
+    size_t failures = 0;
+    for (auto input : {Buffer_planner::Input::none,
+                       Buffer_planner::Input::pulled,
+                       Buffer_planner::Input::supplied}) {
+        const uint32_t min_inputs = input == Buffer_planner::Input::none ? 0 : 1;
+        const uint32_t max_inputs = input == Buffer_planner::Input::none ? 0 : max_channels;
+        for (uint32_t input_count = min_inputs; input_count <= max_inputs; ++input_count) {
+            for (uint32_t output_count = 1; output_count <= max_channels; ++output_count) {
+                for (auto host_output : {Host_output::none,
+                                         Host_output::all,
+                                         Host_output::some,
+                                         Host_output::same_as_input}) {
+                    for (auto process_in_place : {false, true}) {
+                        failures += !check(
+                            input, input_count, output_count, host_output, process_in_place);
+                    }
+                }
+            }
+        }
+    }
+    for (uint32_t input_count = 1; input_count <= max_channels; ++input_count) {
+        for (uint32_t output_count = 1; output_count <= max_channels; ++output_count) {
+            for (auto host_output : {Host_output::none, Host_output::all, Host_output::some}) {
+                failures += !check_partial_pull(input_count, output_count, host_output);
+            }
+        }
+    }
+    return failures;
+}
+
+// A render path whose copies changed.  `old_copies` is how many channels the wrapper copied
+// each block before it used `Buffer_planner`.
+struct Scenario {
+    const char* name;
+    Buffer_planner::Input input;
+    uint32_t input_count;
+    uint32_t output_count;
+    bool host_buffers;
+    uint32_t old_copies;
+};
+
+const Scenario scenarios[] = {
+    {"AUv2 render callback, 2 -> 1", Buffer_planner::Input::pulled, 2, 1, true, 1},
+    {"AUv2 render callback, 6 -> 2", Buffer_planner::Input::pulled, 6, 2, true, 2},
+    {"AUv3, host buffers, 2 -> 2", Buffer_planner::Input::pulled, 2, 2, true, 2},
+    {"AUv3, our buffers, 2 -> 2", Buffer_planner::Input::pulled, 2, 2, false, 2},
+    {"AUv3, host buffers, 8 -> 8", Buffer_planner::Input::pulled, 8, 8, true, 8},
+};
+}
+
+// Keeps the copies from being optimized away.
+static std::atomic<float> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--frames") == 0) {
+            options.frames = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--blocks") == 0) {
+            options.blocks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.frames > 0;
+}
+
+// Times the buffer handling of a block - not the kernel - the old way, then through the
+// planner.
+static void run(const Options& options, const Scenario& scenario)
+{
+    const auto channel_count = std::max(scenario.input_count, scenario.output_count);
+    std::vector<std::vector<float>> host(channel_count, std::vector<float>(options.frames, 1.f));
+    std::vector<std::vector<float>> ours(channel_count, std::vector<float>(options.frames, 1.f));
+    std::vector<float*> host_pointers, our_pointers;
+    for (uint32_t channel = 0; channel < channel_count; ++channel) {
+        host_pointers.push_back(host[channel].data());
+        our_pointers.push_back(ours[channel].data());
+    }
+
+    Buffer_planner planner(our_pointers.data(), channel_count, channel_count);
+    const auto request = Buffer_planner::Request {
+        scenario.input,
+        scenario.input_count,
+        scenario.output_count,
+        nullptr,
+        scenario.host_buffers ? host_pointers.data() : nullptr,
+        false};
+
+    std::vector<uint64_t> old_ns, new_ns;
+    old_ns.reserve(options.blocks);
+    new_ns.reserve(options.blocks);
+    float sink = 0.f;
+    for (size_t block = 0; block < options.blocks; ++block) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t channel = 0; channel < scenario.old_copies; ++channel) {
+            Buffer_ops::copy(our_pointers[channel], host_pointers[channel], options.frames);
+        }
+        old_ns.push_back(elapsed_ns(start));
+        sink += host_pointers[0][block % options.frames];
+
+        start = std::chrono::steady_clock::now();
+        planner.plan(request);
+        planner.copy_input(options.frames);
+        new_ns.push_back(elapsed_ns(start));
+        sink += planner.render_channels()[0][block % options.frames];
+    }
+    benchmark_sink = benchmark_sink + sink;
+
+    const auto bytes_per_channel = options.frames * sizeof(float);
+    const auto old_timings = summarize_timings(old_ns);
+    const auto new_timings = summarize_timings(new_ns);
+    std::printf("%-32s %12zu %12zu %12.1f %12.1f\n",
+                scenario.name,
+                scenario.old_copies * bytes_per_channel,
+                planner.copy_count() * bytes_per_channel,
+                old_timings.mean_ns,
+                new_timings.mean_ns);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--frames 512] [--blocks 20000]\n", argv[0]);
+        return 1;
+    }
+
+    const auto failures = check_all();
+    std::printf("%zu failed combinations\n\n", failures);
+
+    std::printf("%-32s %12s %12s %12s %12s\n",
+                "",
+                "old_bytes",
+                "new_bytes",
+                "old_mean_ns",
+                "new_mean_ns");
+    for (const auto& scenario : scenarios) {
+        run(options, scenario);
+    }
+    return failures == 0 ? 0 : 1;
+}
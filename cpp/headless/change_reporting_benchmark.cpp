@@ -0,0 +1,210 @@
+// Compares publishing parameters after each block by polling every parameter of the kernel with
+// publishing only the ones it reports changing (`Kernel::reports_changes`).  Each block, the
+// host sets `--host-changes` parameters, and the kernel changes `--kernel-changes` of its own;
+// we time `Wrapped_kernel::process`, and the host's `take_parameter_changes` afterwards.
+// Doesn't need a kernel.  Exits non-zero if the host ever sees a value the kernel doesn't have.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Thread/Wrapped_kernel.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> parameter_counts = {16, 256, 4096};
+    std::vector<size_t> kernel_changes = {0, 1, 16};
+    size_t host_changes = 1;
+    size_t blocks = 20000;
+};
+
+// Changes `changes_per_block` random parameters itself each block, like a kernel whose
+// parameters follow a modulation source.  Does no audio processing.
+class Self_changing_kernel : public Kernel {
+public:
+    Self_changing_kernel(const std::vector<Parameter_info>& parameters,
+                         size_t changes_per_block_,
+                         bool reports)
+        : registry(parameters)
+        , values(registry.default_state())
+        , changes_per_block(changes_per_block_)
+        , reports_changes_(reports)
+    {
+        changed.reserve(changes_per_block);
+    }
+
+    void set_parameter(uint64_t address, float value) override
+    {
+        values[registry.index_of(address)] = value;
+    }
+    float get_parameter(uint64_t address) const override
+    {
+        return values[registry.index_of(address)];
+    }
+
+    void reset() override {}
+
+    void process(Deinterleaved_audio, Audio_event_span) override
+    {
+        std::uniform_int_distribution<size_t> index_distribution(0, values.size() - 1);
+        std::uniform_real_distribution<float> value_distribution(0.f, 1.f);
+        for (size_t i = 0; i < changes_per_block; ++i) {
+            const auto index = index_distribution(random);
+            values[index] = value_distribution(random);
+            if (reports_changes_) {
+                changed.push_back(registry.address(index));
+            }
+        }
+    }
+
+    uint64_t get_latency() const override { return 0; }
+
+    bool reports_changes() const override { return reports_changes_; }
+
+    bool take_changes(void* context, void (*f)(void* context, uint64_t address)) override
+    {
+        for (auto address : changed) {
+            f(context, address);
+        }
+        changed.clear();
+        return false;
+    }
+
+private:
+    Parameter_registry registry;
+    Dense_parameter_state values;
+    size_t changes_per_block;
+    bool reports_changes_;
+    std::vector<uint64_t> changed;
+    std::mt19937 random {2};
+};
+}
+
+// Keeps the host's changes from being optimized away.
+static std::atomic<uint64_t> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameter_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--kernel-changes") == 0) {
+            options.kernel_changes = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--host-changes") == 0) {
+            options.host_changes = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--blocks") == 0) {
+            options.blocks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// Returns false if the host's mirror ever disagrees with the kernel after a block.
+static bool run(const Options& options,
+                size_t parameter_count,
+                size_t kernel_changes,
+                bool reports_changes)
+{
+    const auto parameters = make_parameters(parameter_count);
+    const auto registry = std::make_shared<const Parameter_registry>(parameters);
+    auto owned_kernel
+        = std::make_unique<Self_changing_kernel>(parameters, kernel_changes, reports_changes);
+    const auto& kernel = *owned_kernel;
+    Wrapped_kernel wrapped(std::move(owned_kernel), registry, {}, 48000.);
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<size_t> index_distribution(0, parameter_count - 1);
+    std::uniform_real_distribution<float> value_distribution(0.f, 1.f);
+
+    auto host_mirror = registry->default_state();
+    std::vector<uint64_t> process_ns;
+    std::vector<uint64_t> host_ns;
+    process_ns.reserve(options.blocks);
+    host_ns.reserve(options.blocks);
+    uint64_t sink = 0;
+    bool ok = true;
+    for (size_t block = 0; block < options.blocks; ++block) {
+        for (size_t i = 0; i < options.host_changes; ++i) {
+            wrapped.set_parameter(parameters[index_distribution(random)].address,
+                                  value_distribution(random));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        wrapped.process(Deinterleaved_audio {0, 64, nullptr}, Audio_event_span());
+        process_ns.push_back(elapsed_ns(start));
+
+        start = std::chrono::steady_clock::now();
+        wrapped.take_parameter_changes([&](uint64_t address, float value) {
+            host_mirror[registry->index_of(address)] = value;
+            sink += address;
+        });
+        host_ns.push_back(elapsed_ns(start));
+
+        for (size_t index = 0; ok && index < parameter_count; ++index) {
+            ok = host_mirror[index] == kernel.get_parameter(registry->address(index));
+        }
+    }
+
+    benchmark_sink += sink;
+    const auto process = summarize_timings(process_ns);
+    const auto host = summarize_timings(host_ns);
+    std::printf("%-10s %10zu %14zu %14.1f %14llu %12.1f %12llu\n",
+                reports_changes ? "reporting" : "polling",
+                parameter_count,
+                kernel_changes,
+                process.mean_ns,
+                static_cast<unsigned long long>(process.p99_ns),
+                host.mean_ns,
+                static_cast<unsigned long long>(host.p99_ns));
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--parameters 16,256,...] [--kernel-changes 0,1,...] "
+                     "[--host-changes 1] [--blocks 20000]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%-10s %10s %14s %14s %14s %12s %12s\n",
+                "",
+                "params",
+                "kernel_changes",
+                "process_mean",
+                "process_p99",
+                "host_mean",
+                "host_p99");
+    bool ok = true;
+    for (auto parameter_count : options.parameter_counts) {
+        if (parameter_count == 0) {
+            continue;
+        }
+        for (auto kernel_changes : options.kernel_changes) {
+            for (auto reports_changes : {false, true}) {
+                if (!run(options, parameter_count, kernel_changes, reports_changes)) {
+                    std::fprintf(stderr,
+                                 "FAIL: host missed a change with %zu parameters, %zu kernel "
+                                 "changes\n",
+                                 parameter_count,
+                                 kernel_changes);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
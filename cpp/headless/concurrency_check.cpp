@@ -0,0 +1,217 @@
+// Hammers `Wrapped_kernel` from several threads while another renders, and fails if any
+// parameter change is lost, or if the kernel ever sees a state set with `set_state` only
+// partly applied.  Doesn't need a kernel.  Build with `-fsanitize=thread` to catch data races
+// too.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Thread/Wrapped_kernel.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    size_t parameters = 64;
+    size_t threads = 4;
+    size_t rounds = 20000;
+};
+
+// Holds its parameters as set, and counts the blocks in which they weren't all equal, which
+// only happens if a state was torn.
+class Echo_kernel : public Kernel {
+public:
+    explicit Echo_kernel(std::shared_ptr<const Parameter_registry> registry_)
+        : registry(std::move(registry_)), values(registry->default_state())
+    {
+    }
+
+    void set_parameter(uint64_t address, float value) override
+    {
+        values[registry->index_of(address)] = value;
+    }
+    float get_parameter(uint64_t address) const override
+    {
+        return values[registry->index_of(address)];
+    }
+
+    void reset() override { ++resets; }
+
+    void process(Deinterleaved_audio, Audio_event_span) override
+    {
+        if (check_uniform) {
+            for (auto value : values) {
+                if (value != values.front()) {
+                    ++torn_blocks;
+                    break;
+                }
+            }
+        }
+    }
+
+    uint64_t get_latency() const override { return 0; }
+
+    std::shared_ptr<const Parameter_registry> registry;
+    Dense_parameter_state values;
+    bool check_uniform = false;
+    size_t torn_blocks = 0;
+    size_t resets = 0;
+};
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const auto value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameters = value;
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options.threads = value;
+        } else if (std::strcmp(argv[i], "--rounds") == 0) {
+            options.rounds = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.parameters > 0 && options.threads > 0;
+}
+
+// Wide enough for every value the checks set.
+static std::shared_ptr<const Parameter_registry> make_registry(size_t count)
+{
+    return std::make_shared<const Parameter_registry>(make_parameters(count, {0., 1.e6, 0u, 0.}));
+}
+
+// Renders on one thread while `threads` others each call `work(thread)`, then renders a few
+// more blocks so everything they did has reached the kernel.  Everyone yields often, so the
+// threads interleave even on a single core.
+template <typename Work>
+static void render_while(Wrapped_kernel& wrapped, size_t threads, Work work)
+{
+    std::atomic<bool> done = {false};
+    std::thread dsp([&] {
+        while (!done.load()) {
+            wrapped.process(Deinterleaved_audio {0, 64, nullptr}, Audio_event_span());
+            std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> workers;
+    for (size_t thread = 0; thread < threads; ++thread) {
+        workers.emplace_back([&work, thread] { work(thread); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    done.store(true);
+    dsp.join();
+    for (int block = 0; block < 2; ++block) {
+        wrapped.process(Deinterleaved_audio {0, 64, nullptr}, Audio_event_span());
+    }
+}
+
+// Each thread sets its own share of the parameters to 1, 2, ... `rounds`, while the last one
+// also resets the kernel, and one more watches them; no parameter should ever go backwards, and
+// each should end up at `rounds`, in both the kernel and what `get_parameter` reports.
+static bool check_set_parameter(const Options& options)
+{
+    const auto registry = make_registry(options.parameters);
+    auto owned_kernel = std::make_unique<Echo_kernel>(registry);
+    const auto& kernel = *owned_kernel;
+    Wrapped_kernel wrapped(std::move(owned_kernel), registry, {}, 48000.);
+
+    std::atomic<size_t> went_back = {0};
+    render_while(wrapped, options.threads + 1, [&](size_t thread) {
+        if (thread == options.threads) {
+            auto seen = registry->default_state();
+            for (size_t round = 1; round <= options.rounds; ++round) {
+                for (size_t index = 0; index < registry->size(); ++index) {
+                    const auto value = wrapped.get_parameter(registry->address(index));
+                    went_back += value < seen[index] ? 1 : 0;
+                    seen[index] = value;
+                }
+                std::this_thread::yield();
+            }
+            return;
+        }
+        for (size_t round = 1; round <= options.rounds; ++round) {
+            for (size_t index = thread; index < registry->size(); index += options.threads) {
+                wrapped.set_parameter(registry->address(index), float(round));
+            }
+            if (thread + 1 == options.threads) {
+                wrapped.reset();
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    size_t lost = 0;
+    for (size_t index = 0; index < registry->size(); ++index) {
+        const auto address = registry->address(index);
+        if (kernel.get_parameter(address) != float(options.rounds)
+            || wrapped.get_parameter(address) != float(options.rounds)) {
+            ++lost;
+        }
+    }
+    const bool ok = lost == 0 && went_back == 0 && kernel.resets > 0;
+    std::printf("%-16s %10zu lost %8zu went back %8zu resets  %s\n",
+                "set_parameter",
+                lost,
+                went_back.load(),
+                kernel.resets,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Each thread sets whole states with every parameter equal, and a different value each time;
+// the kernel should only ever see uniform states, and end up with what `get_parameter` reports.
+static bool check_set_state(const Options& options)
+{
+    const auto registry = make_registry(options.parameters);
+    auto owned_kernel = std::make_unique<Echo_kernel>(registry);
+    owned_kernel->check_uniform = true;
+    const auto& kernel = *owned_kernel;
+    Wrapped_kernel wrapped(std::move(owned_kernel), registry, {}, 48000.);
+
+    render_while(wrapped, options.threads, [&](size_t thread) {
+        Dense_parameter_state state(registry->size());
+        for (size_t round = 1; round <= options.rounds; ++round) {
+            std::fill(begin(state), end(state), float(round * options.threads + thread));
+            wrapped.set_state(state);
+            std::this_thread::yield();
+        }
+    });
+
+    size_t mismatched = 0;
+    for (size_t index = 0; index < registry->size(); ++index) {
+        const auto address = registry->address(index);
+        if (kernel.get_parameter(address) != kernel.values.front()
+            || wrapped.get_parameter(address) != kernel.values.front()) {
+            ++mismatched;
+        }
+    }
+    const bool ok = mismatched == 0 && kernel.torn_blocks == 0;
+    std::printf("%-16s %10zu torn %8zu mismatched  %s\n",
+                "set_state",
+                kernel.torn_blocks,
+                mismatched,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(
+            stderr, "usage: %s [--parameters 64] [--threads 4] [--rounds 20000]\n", argv[0]);
+        return 1;
+    }
+    bool ok = check_set_parameter(options);
+    ok = check_set_state(options) && ok;
+    return ok ? 0 : 1;
+}
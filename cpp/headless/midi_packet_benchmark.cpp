@@ -0,0 +1,203 @@
+// Compares delivering a sysex message to a kernel as one `Midi_packet`, whose bytes stay in
+// the block's payload, with splitting it into three-byte `Midi_message`s for the kernel to
+// put back together, which was the only way to carry it before.  For each `--sizes` byte
+// count, each block pushes one message into an `Audio_event_buffer` and runs it through
+// `Wrapped_kernel::process`; we time both.  Also checks that `Audio_event_buffer::push_ump`
+// splits MIDI 1.0 channel voice messages out of universal MIDI packets.  Doesn't need a
+// kernel.  Exits non-zero if the kernel ever receives different bytes than were sent.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Thread/Wrapped_kernel.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> sizes = {64, 1024, 16384};
+    size_t blocks = 5000;
+};
+
+uint64_t hash_bytes(uint64_t hash, const uint8_t* bytes, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+constexpr uint64_t hash_seed = 0xcbf29ce484222325ull;
+
+// Hashes every sysex message it receives, putting split ones back together first, like a
+// kernel that parses them would have to.
+class Sysex_kernel : public Kernel {
+public:
+    explicit Sysex_kernel(size_t max_size) { reassembled.reserve(max_size); }
+
+    void set_parameter(uint64_t, float) override {}
+    float get_parameter(uint64_t) const override { return 0.f; }
+    void reset() override {}
+    uint64_t get_latency() const override { return 0; }
+
+    void process(Deinterleaved_audio, Audio_event_span events) override
+    {
+        for (const auto& event : events) {
+            std::visit(overload {[](const Parameter_change&) {},
+                                 [](const Ramped_parameter_change&) {},
+                                 [&](const Midi_message& message) {
+                                     reassembled.insert(reassembled.end(),
+                                                        message.data.begin(),
+                                                        message.data.begin()
+                                                            + message.valid_bytes);
+                                     if (message.data[message.valid_bytes - 1] == 0xF7) {
+                                         hash = hash_bytes(
+                                             hash, reassembled.data(), reassembled.size());
+                                         reassembled.clear();
+                                     }
+                                 },
+                                 [&](const Midi_packet& packet) {
+                                     hash = hash_bytes(
+                                         hash, events.payload(packet), packet.size);
+                                 }},
+                       event);
+        }
+    }
+
+    uint64_t hash = hash_seed;
+
+private:
+    std::vector<uint8_t> reassembled;
+};
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--sizes") == 0) {
+            options.sizes = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--blocks") == 0) {
+            options.blocks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// Returns false if the kernel's hash of what it received doesn't match what was sent.
+static bool run(const Options& options, size_t size, bool packet)
+{
+    std::mt19937 random(1);
+    std::vector<uint8_t> sysex(size);
+    sysex.front() = 0xF0;
+    for (size_t i = 1; i + 1 < size; ++i) {
+        sysex[i] = static_cast<uint8_t>(random() & 0x7F);
+    }
+    sysex.back() = 0xF7;
+
+    auto owned_kernel = std::make_unique<Sysex_kernel>(size);
+    const auto& kernel = *owned_kernel;
+    const auto registry
+        = std::make_shared<const Parameter_registry>(std::vector<Parameter_info> {});
+    Wrapped_kernel wrapped(std::move(owned_kernel), registry, {}, 48000.);
+    Audio_event_buffer events((size + 2) / 3, size + 4);
+
+    std::vector<uint64_t> block_ns;
+    block_ns.reserve(options.blocks);
+    uint64_t expected = hash_seed;
+    for (size_t block = 0; block < options.blocks; ++block) {
+        const auto start = std::chrono::steady_clock::now();
+        if (packet) {
+            events.push_midi_packet(0, 0, Midi_packet_format::bytes, sysex.data(), size);
+        } else {
+            for (size_t offset = 0; offset < size; offset += 3) {
+                const auto valid_bytes = static_cast<uint16_t>(std::min<size_t>(3, size - offset));
+                Midi_message message {0, 0, valid_bytes, {}};
+                std::memcpy(message.data.data(), &sysex[offset], valid_bytes);
+                events.push(message);
+            }
+        }
+        wrapped.process(Deinterleaved_audio {0, 64, nullptr}, events.span());
+        events.clear();
+        block_ns.push_back(elapsed_ns(start));
+        expected = hash_bytes(expected, sysex.data(), size);
+    }
+
+    const auto timings = summarize_timings(block_ns);
+    std::printf("%-10s %10zu %12.1f %12llu %12.3f\n",
+                packet ? "packet" : "messages",
+                size,
+                timings.mean_ns,
+                static_cast<unsigned long long>(timings.p99_ns),
+                timings.mean_ns / static_cast<double>(size));
+    return kernel.hash == expected;
+}
+
+// A MIDI 1.0 note on, then a MIDI 2.0 note on and a sysex7 packet, which should stay together.
+static bool check_ump()
+{
+    const uint32_t words[] = {0x20903C64, 0x40903C00, 0xFFFF0000, 0x30010000, 0x7E000000};
+    Audio_event_buffer events;
+    if (!events.push_ump(0, 1, words, std::size(words)) || events.size() != 2) {
+        return false;
+    }
+    const auto span = events.span();
+    const auto* message = std::get_if<Midi_message>(&span[0]);
+    const auto* packet = std::get_if<Midi_packet>(&span[1]);
+    return message && message->cable == 1 && message->valid_bytes == 3
+        && message->data == std::array<uint8_t, 3> {0x90, 0x3C, 0x64} && packet
+        && packet->format == Midi_packet_format::ump && packet->size == 4 * sizeof(uint32_t)
+        && std::memcmp(span.payload(*packet), words + 1, packet->size) == 0;
+}
+
+// Packets that only overflow the payload once aligned are dropped, without growing it.
+static bool check_payload_capacity()
+{
+    const uint8_t bytes[] = {0xF8, 0xF8};
+    Audio_event_buffer events(4, 5);
+    const auto capacity = events.payload_capacity();
+    return events.push_midi_packet(0, 0, Midi_packet_format::bytes, bytes, 1)
+        && !events.push_midi_packet(0, 0, Midi_packet_format::bytes, bytes, 2)
+        && events.push_midi_packet(0, 0, Midi_packet_format::bytes, bytes, 1)
+        && !events.push_midi_packet(0, 0, Midi_packet_format::bytes, bytes, 0)
+        && events.size() == 2 && events.payload_capacity() == capacity;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--sizes 64,1024,...] [--blocks 5000]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = check_ump();
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: push_ump split universal MIDI packets wrongly\n");
+    }
+    if (!check_payload_capacity()) {
+        std::fprintf(stderr, "FAIL: push_midi_packet overran the payload capacity\n");
+        ok = false;
+    }
+
+    std::printf("%-10s %10s %12s %12s %12s\n", "", "bytes", "mean_ns", "p99_ns", "ns/byte");
+    for (auto size : options.sizes) {
+        if (size < 2) {
+            continue;
+        }
+        for (auto packet : {false, true}) {
+            if (!run(options, size, packet)) {
+                std::fprintf(stderr, "FAIL: kernel received different bytes for %zu\n", size);
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
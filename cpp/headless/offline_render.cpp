@@ -0,0 +1,120 @@
+// Runs the kernel exported by the glue library over an audio file, as fast as possible, and
+// reports the throughput.
+//
+// Input is a WAV file, or with `--raw-input CHANNELS,RATE` a file of interleaved 32-bit
+// floats.  Output is a 32-bit float WAV file, or raw floats with `--raw-output`.  Each
+// `--set ADDRESS=VALUE` sets a parameter before rendering.
+
+#include "Brinicle/Glue/Make_kernel_factory.h"
+#include "Brinicle/Headless/Offline_renderer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    Offline_render_options render;
+    bool raw_input = false;
+    Mapped_audio_file::Raw_format raw_format = {2, 48000.};
+    bool raw_output = false;
+    std::string input_path;
+    std::string output_path;
+};
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    int i = 1;
+    for (; i < argc && std::strncmp(argv[i], "--", 2) == 0; ++i) {
+        if (std::strcmp(argv[i], "--raw-output") == 0) {
+            options.raw_output = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        char* end = nullptr;
+        if (std::strcmp(argv[i - 1], "--raw-input") == 0) {
+            options.raw_input = true;
+            options.raw_format.channel_count
+                = static_cast<uint32_t>(std::strtoul(value, &end, 10));
+            if (*end != ',') {
+                return false;
+            }
+            options.raw_format.sample_rate = std::strtod(end + 1, nullptr);
+        } else if (std::strcmp(argv[i - 1], "--block-size") == 0) {
+            options.render.block_size = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(argv[i - 1], "--output-channels") == 0) {
+            options.render.output_channel_count
+                = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(argv[i - 1], "--tail-seconds") == 0) {
+            options.render.tail_seconds = std::strtod(value, nullptr);
+        } else if (std::strcmp(argv[i - 1], "--set") == 0) {
+            const auto address = std::strtoull(value, &end, 10);
+            if (*end != '=') {
+                return false;
+            }
+            options.render.parameters.emplace_back(address, std::strtof(end + 1, nullptr));
+        } else {
+            return false;
+        }
+    }
+    if (argc - i != 2) {
+        return false;
+    }
+    options.input_path = argv[i];
+    options.output_path = argv[i + 1];
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--raw-input CHANNELS,RATE] [--raw-output] [--block-size 4096] "
+                     "[--output-channels N] [--tail-seconds 0] [--set ADDRESS=VALUE ...] "
+                     "INPUT OUTPUT\n",
+                     argv[0]);
+        return 1;
+    }
+
+    try {
+        const auto input = options.raw_input
+            ? std::make_unique<Mapped_audio_file>(options.input_path, options.raw_format)
+            : std::make_unique<Mapped_audio_file>(options.input_path);
+        const auto factory = make_kernel_factory();
+        const auto result = render_offline(*factory,
+                                           *input,
+                                           options.output_path,
+                                           options.raw_output ? Audio_file_writer::Format::raw
+                                                              : Audio_file_writer::Format::wav,
+                                           options.render);
+
+        const auto audio_seconds = static_cast<double>(result.input_frames) / input->sample_rate();
+        const auto input_bytes = static_cast<double>(result.input_frames) * input->channel_count()
+            * sizeof(float);
+        std::printf("frames:          %llu in, %llu out (latency %llu trimmed)\n",
+                    static_cast<unsigned long long>(result.input_frames),
+                    static_cast<unsigned long long>(result.output_frames),
+                    static_cast<unsigned long long>(result.latency_frames));
+        std::printf("time:            %.2fs total (read %.2fs, render %.2fs, write %.2fs)\n",
+                    result.total_seconds,
+                    result.read_seconds,
+                    result.render_seconds,
+                    result.write_seconds);
+        std::printf("speed:           %.1fx real time, %.1f MB/s of float audio\n",
+                    audio_seconds / result.total_seconds,
+                    input_bytes / result.total_seconds / 1e6);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Checks `Oversampler`'s filters at each factor, by running audio up and back down: that DC
+// comes back unchanged, that sines in the passband come back within `passband_ripple` of their
+// level, and that an impulse comes back `latency()` frames later.  Doesn't need a kernel.
+// Exits non-zero on failure.
+
+#include "Brinicle/Kernel/Oversampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+constexpr size_t block_size = 256;
+
+// Frames to let the filters settle before measuring, and frames to measure.
+constexpr size_t settle_frames = 1024;
+constexpr size_t measure_frames = 16384;
+
+// The passband, as a fraction of the base sample rate, and how far from unity gain it may be.
+constexpr double passband_edge = 0.4;
+constexpr double passband_ripple = 0.001;
+constexpr double dc_tolerance = 1e-4;
+}
+
+// Runs `in` through an up and down round trip, a block at a time.
+static std::vector<float> round_trip(uint32_t factor, const std::vector<float>& in)
+{
+    Oversampler oversampler(factor, 1, block_size);
+    std::vector<float> out(in.size());
+    for (size_t start = 0; start < in.size(); start += block_size) {
+        auto frame_count = static_cast<uint32_t>(std::min(block_size, in.size() - start));
+        std::copy(in.begin() + start, in.begin() + start + frame_count, out.begin() + start);
+        float* channel = out.data() + start;
+        const Deinterleaved_audio audio {1, frame_count, &channel};
+        oversampler.upsample(audio);
+        oversampler.downsample(audio);
+    }
+    return out;
+}
+
+// The gain of the round trip for a sine of `cycles` cycles over the measured frames.
+static double sine_gain(uint32_t factor, size_t cycles)
+{
+    const double frequency = static_cast<double>(cycles) / measure_frames;
+    std::vector<float> in(settle_frames + measure_frames);
+    for (size_t t = 0; t < in.size(); ++t) {
+        in[t] = static_cast<float>(std::sin(2. * pi * frequency * static_cast<double>(t)));
+    }
+    const auto out = round_trip(factor, in);
+
+    double sine = 0.;
+    double cosine = 0.;
+    for (size_t t = settle_frames; t < out.size(); ++t) {
+        const auto phase = 2. * pi * frequency * static_cast<double>(t);
+        sine += out[t] * std::sin(phase);
+        cosine += out[t] * std::cos(phase);
+    }
+    return 2. * std::sqrt(sine * sine + cosine * cosine) / measure_frames;
+}
+
+static bool check(uint32_t factor)
+{
+    std::vector<float> ones(settle_frames + measure_frames, 1.f);
+    const auto dc = round_trip(factor, ones);
+    double dc_error = 0.;
+    for (size_t t = settle_frames; t < dc.size(); ++t) {
+        dc_error = std::max(dc_error, std::abs(dc[t] - 1.));
+    }
+
+    // A sine at each multiple of 1/64 of the base rate up to the passband edge, plus the edge.
+    double ripple = 0.;
+    const auto edge_cycles = static_cast<size_t>(passband_edge * measure_frames);
+    const auto step = measure_frames / 64;
+    for (size_t cycles = step; cycles <= edge_cycles; cycles += step) {
+        ripple = std::max(ripple, std::abs(sine_gain(factor, cycles) - 1.));
+    }
+    ripple = std::max(ripple, std::abs(sine_gain(factor, edge_cycles) - 1.));
+
+    std::vector<float> impulse(settle_frames, 0.f);
+    impulse[0] = 1.f;
+    const auto response = round_trip(factor, impulse);
+    size_t peak = 0;
+    for (size_t t = 0; t < response.size(); ++t) {
+        if (std::abs(response[t]) > std::abs(response[peak])) {
+            peak = t;
+        }
+    }
+    const auto latency = Oversampler(factor, 1, block_size).latency();
+
+    const bool ok = dc_error <= dc_tolerance && ripple <= passband_ripple
+        && std::abs(static_cast<double>(peak) - latency) <= 0.5;
+    std::printf("%ux  dc error %9.2e  ripple to %.2f fs %9.2e  "
+                "impulse peak %4zu  latency %6.2f  %s\n",
+                factor,
+                dc_error,
+                passband_edge,
+                ripple,
+                peak,
+                latency,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    for (uint32_t factor : {2u, 4u, 8u}) {
+        ok = check(factor) && ok;
+    }
+    return ok ? 0 : 1;
+}
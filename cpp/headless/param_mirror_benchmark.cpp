@@ -0,0 +1,137 @@
+// Times `Param_mirror` syncs across parameter counts.  Each simulated block, the UI thread
+// changes `--ui-changes` parameters and the DSP side reports `--dsp-changes` parameters as
+// changed; we time the DSP side (draining UI changes and reporting its own) and the UI side
+// (draining DSP changes) separately.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Thread/Param_mirror.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> parameter_counts = {16, 256, 1024, 4096};
+    std::vector<size_t> ui_changes = {0, 1, 16};
+    std::vector<size_t> dsp_changes = {0, 1, 16};
+    size_t blocks = 20000;
+};
+}
+
+// Keeps the sync callbacks from being optimized away.
+static std::atomic<uint64_t> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameter_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--ui-changes") == 0) {
+            options.ui_changes = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--dsp-changes") == 0) {
+            options.dsp_changes = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--blocks") == 0) {
+            options.blocks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+static void run_benchmark(const Options& options,
+                          size_t parameter_count,
+                          size_t ui_changes,
+                          size_t dsp_changes)
+{
+    const auto parameters = make_parameters(parameter_count);
+    Param_mirror mirror(std::make_shared<const Parameter_registry>(parameters));
+    std::mt19937 random(1);
+    std::uniform_int_distribution<size_t> index_distribution(0, parameter_count - 1);
+    std::uniform_real_distribution<float> value_distribution(0.f, 1.f);
+
+    std::vector<uint64_t> dsp_ns;
+    std::vector<uint64_t> ui_ns;
+    dsp_ns.reserve(options.blocks);
+    ui_ns.reserve(options.blocks);
+    std::vector<size_t> changed(dsp_changes);
+    uint64_t sink = 0;
+
+    for (size_t block = 0; block < options.blocks; ++block) {
+        for (size_t i = 0; i < ui_changes; ++i) {
+            mirror.set_from_ui_thread(parameters[index_distribution(random)].address,
+                                      value_distribution(random));
+        }
+        for (auto& index : changed) {
+            index = index_distribution(random);
+        }
+        const float dsp_value = value_distribution(random);
+
+        auto start = std::chrono::steady_clock::now();
+        mirror.sync_from_dsp_thread([&](uint64_t address, float) { sink += address; });
+        for (auto index : changed) {
+            mirror.set_from_dsp_thread(index, dsp_value);
+        }
+        auto end = std::chrono::steady_clock::now();
+        dsp_ns.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+
+        start = std::chrono::steady_clock::now();
+        mirror.sync_from_ui_thread([&](uint64_t address, float) { sink += address; });
+        end = std::chrono::steady_clock::now();
+        ui_ns.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+
+    benchmark_sink += sink;
+    const auto dsp = summarize_timings(dsp_ns);
+    const auto ui = summarize_timings(ui_ns);
+    std::printf("%10zu %10zu %10zu %12.1f %12llu %12llu %12.1f %12llu %12llu\n",
+                parameter_count,
+                ui_changes,
+                dsp_changes,
+                dsp.mean_ns,
+                static_cast<unsigned long long>(dsp.p99_ns),
+                static_cast<unsigned long long>(dsp.max_ns),
+                ui.mean_ns,
+                static_cast<unsigned long long>(ui.p99_ns),
+                static_cast<unsigned long long>(ui.max_ns));
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--parameters 16,256,...] [--ui-changes 0,1,...] "
+                     "[--dsp-changes 0,1,...] [--blocks 20000]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%10s %10s %10s %12s %12s %12s %12s %12s %12s\n",
+                "params",
+                "ui_changes",
+                "dsp_changes",
+                "dsp_mean_ns",
+                "dsp_p99_ns",
+                "dsp_max_ns",
+                "ui_mean_ns",
+                "ui_p99_ns",
+                "ui_max_ns");
+    for (auto parameter_count : options.parameter_counts) {
+        for (auto ui_changes : options.ui_changes) {
+            for (auto dsp_changes : options.dsp_changes) {
+                run_benchmark(options, parameter_count, ui_changes, dsp_changes);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Compares notifying UI subscribers of parameter changes through an `Event_emitter` (one call
+// per change per subscriber) with a `Parameter_change_bus` (one batch per subscriber per
+// frame).  Each simulated UI frame, `--changed` parameters each change `--updates` times, as
+// they would during automation; every subscriber does a little work per change it's told about.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Thread/Event_stream.h"
+#include "Brinicle/Thread/Parameter_change_bus.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> parameter_counts = {1000, 5000};
+    std::vector<size_t> subscriber_counts = {1, 16, 64};
+    std::vector<size_t> changed_counts = {10, 1000};
+    size_t updates = 4;
+    size_t frames = 200;
+};
+
+struct Result {
+    Timing_statistics timings;
+    uint64_t callbacks_per_frame;
+};
+}
+
+// Keeps the subscriber callbacks from being optimized away.
+static std::atomic<uint64_t> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameter_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--subscribers") == 0) {
+            options.subscriber_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--changed") == 0) {
+            options.changed_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--updates") == 0) {
+            options.updates = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--frames") == 0) {
+            options.frames = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// The changes for each frame, as parameter indices; `updates` passes over `changed` distinct
+// parameters.
+static std::vector<std::vector<size_t>> make_frames(const Options& options,
+                                                    size_t parameter_count,
+                                                    size_t changed)
+{
+    std::mt19937 random(1);
+    std::vector<size_t> indices(parameter_count);
+    for (size_t i = 0; i < parameter_count; ++i) {
+        indices[i] = i;
+    }
+    std::vector<std::vector<size_t>> frames(options.frames);
+    for (auto& frame : frames) {
+        std::shuffle(begin(indices), end(indices), random);
+        for (size_t update = 0; update < options.updates; ++update) {
+            frame.insert(end(frame), begin(indices), begin(indices) + changed);
+        }
+    }
+    return frames;
+}
+
+static Result run_emitter(const std::vector<Parameter_info>& parameters,
+                          const std::vector<std::vector<size_t>>& frames,
+                          size_t subscriber_count)
+{
+    auto [stream, emitter] = make_event<uint64_t, float>();
+    uint64_t sink = 0;
+    uint64_t callbacks = 0;
+    std::vector<std::shared_ptr<Event_stream<uint64_t, float>::Token>> tokens;
+    for (size_t i = 0; i < subscriber_count; ++i) {
+        tokens.push_back(stream->subscribe([&](uint64_t address, float value) {
+            sink += address + static_cast<uint64_t>(value * 1000.f);
+            ++callbacks;
+        }));
+    }
+
+    std::vector<uint64_t> ns;
+    ns.reserve(frames.size());
+    float value = 0.f;
+    for (const auto& frame : frames) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto index : frame) {
+            emitter->emit(parameters[index].address, value);
+            value += 1e-3f;
+        }
+        ns.push_back(elapsed_ns(start));
+    }
+    benchmark_sink += sink;
+    return Result {summarize_timings(ns), callbacks / frames.size()};
+}
+
+static Result run_bus(const std::vector<Parameter_info>& parameters,
+                      const std::vector<std::vector<size_t>>& frames,
+                      size_t subscriber_count)
+{
+    const auto registry = std::make_shared<const Parameter_registry>(parameters);
+    auto bus = std::make_shared<Parameter_change_bus>(registry);
+    uint64_t sink = 0;
+    uint64_t callbacks = 0;
+    std::vector<std::shared_ptr<Parameter_change_bus::Subscription>> subscriptions;
+    for (size_t i = 0; i < subscriber_count; ++i) {
+        subscriptions.push_back(bus->subscribe([&](Parameter_change_batch batch) {
+            for (const auto& change : batch) {
+                sink += change.address + static_cast<uint64_t>(change.value * 1000.f);
+            }
+            ++callbacks;
+        }));
+    }
+
+    std::vector<uint64_t> ns;
+    ns.reserve(frames.size());
+    float value = 0.f;
+    for (const auto& frame : frames) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto index : frame) {
+            bus->publish(parameters[index].address, value);
+            value += 1e-3f;
+        }
+        bus->deliver();
+        ns.push_back(elapsed_ns(start));
+    }
+    benchmark_sink += sink;
+    return Result {summarize_timings(ns), callbacks / frames.size()};
+}
+
+static void print_result(const char* name,
+                         size_t parameter_count,
+                         size_t subscriber_count,
+                         size_t changed,
+                         const Result& result)
+{
+    std::printf("%-8s %10zu %12zu %10zu %12.1f %12llu %12llu %12llu\n",
+                name,
+                parameter_count,
+                subscriber_count,
+                changed,
+                result.timings.mean_ns,
+                static_cast<unsigned long long>(result.timings.p99_ns),
+                static_cast<unsigned long long>(result.timings.max_ns),
+                static_cast<unsigned long long>(result.callbacks_per_frame));
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options) || options.frames == 0) {
+        std::fprintf(stderr,
+                     "usage: %s [--parameters 1000,5000,...] [--subscribers 1,16,...] "
+                     "[--changed 10,1000,...] [--updates 4] [--frames 200]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu updates per changed parameter per frame\n", options.updates);
+    std::printf("%-8s %10s %12s %10s %12s %12s %12s %12s\n",
+                "",
+                "params",
+                "subscribers",
+                "changed",
+                "mean_ns",
+                "p99_ns",
+                "max_ns",
+                "callbacks");
+    for (auto parameter_count : options.parameter_counts) {
+        const auto parameters = make_parameters(parameter_count);
+        for (auto changed : options.changed_counts) {
+            changed = std::min(changed, parameter_count);
+            const auto frames = make_frames(options, parameter_count, changed);
+            for (auto subscriber_count : options.subscriber_counts) {
+                print_result("emitter",
+                             parameter_count,
+                             subscriber_count,
+                             changed,
+                             run_emitter(parameters, frames, subscriber_count));
+                print_result("bus",
+                             parameter_count,
+                             subscriber_count,
+                             changed,
+                             run_bus(parameters, frames, subscriber_count));
+            }
+        }
+    }
+    return 0;
+}
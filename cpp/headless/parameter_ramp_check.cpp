@@ -0,0 +1,121 @@
+// Checks `Parameter_ramp` and `Parameter_ramp_set`: that every curve moves steadily towards its
+// target and ends exactly on it, whatever the block size; that a host's start value followed
+// by a ramp starts the ramp from that value rather than smoothing towards it; and that a block
+// longer than `max_frames` is rejected.  Doesn't need a kernel.  Exits non-zero on failure.
+
+#include "Brinicle/Kernel/Parameter_ramp.h"
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace Brinicle;
+
+static const char* curve_name(Ramp_curve curve)
+{
+    switch (curve) {
+    case Ramp_curve::linear:
+        return "linear";
+    case Ramp_curve::exponential:
+        return "exponential";
+    case Ramp_curve::one_pole:
+        return "one_pole";
+    }
+    return "?";
+}
+
+// Ramps from `from` to `to` over `ramp_frames`, rendering `block_size` frames at a time until
+// a block past its end.  Every sample must be between the last one and the target, and the
+// ramp's last sample, and everything after it, must be exactly the target.
+static bool check_curve(
+    Ramp_curve curve, float from, float to, uint32_t ramp_frames, uint32_t block_size)
+{
+    Parameter_ramp ramp({curve, 0}, from);
+    ramp.ramp_to(to, ramp_frames);
+
+    std::vector<float> block(block_size);
+    size_t wrong = 0;
+    float last = from;
+    float last_in_ramp = from;
+    for (uint32_t rendered = 0; rendered <= ramp_frames; rendered += block_size) {
+        ramp.render(block.data(), block_size);
+        for (uint32_t i = 0; i < block_size; ++i) {
+            const auto frame = rendered + i;
+            const auto value = block[i];
+            const bool towards
+                = from < to ? value >= last && value <= to : value <= last && value >= to;
+            if (!towards || (frame >= ramp_frames && value != to)) {
+                ++wrong;
+            }
+            if (frame + 1 == ramp_frames) {
+                last_in_ramp = value;
+            }
+            last = value;
+        }
+    }
+    const bool ok = wrong == 0 && last_in_ramp == to && ramp.value() == to && !ramp.is_ramping();
+    std::printf("%-12s %8g -> %-8g %8u frames in blocks of %-6u %8zu wrong  %s\n",
+                curve_name(curve),
+                from,
+                to,
+                ramp_frames,
+                block_size,
+                wrong,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// A host sends a ramp as its start value, then the ramp, at the same time.  The ramp should
+// start from that value, while a lone change is smoothed.
+static bool check_host_ramp()
+{
+    constexpr uint64_t address = 7;
+    constexpr uint32_t smoothing = 256;
+    constexpr uint32_t ramp_length = 100;
+    Parameter_ramp_set ramps({{address, {Ramp_curve::linear, smoothing}, 0.f}}, 512);
+
+    const Audio_event ramp_events[] = {Parameter_change {0, address, 1.f},
+                                       Ramped_parameter_change {0, address, 2.f, ramp_length}};
+    ramps.process(Audio_event_span(ramp_events, 2), 512);
+    const auto* ramped = ramps.buffer(address);
+    const bool ramp_ok = ramped[0] > 1.f && ramped[0] < 1.f + 2.f / ramp_length
+        && ramped[ramp_length - 1] == 2.f && ramped[511] == 2.f;
+
+    const Audio_event jump_events[] = {Parameter_change {0, address, 1.f}};
+    ramps.process(Audio_event_span(jump_events, 1), 512);
+    const auto* jumped = ramps.buffer(address);
+    const bool jump_ok = jumped[0] < 2.f && jumped[0] > 2.f - 2.f / smoothing
+        && jumped[smoothing - 1] == 1.f && jumped[511] == 1.f;
+
+    const bool ok = ramp_ok && jump_ok;
+    std::printf("%-12s %s\n", "host ramp", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool check_max_frames()
+{
+    Parameter_ramp_set ramps({{1, {Ramp_curve::linear, 16}, 0.f}}, 64);
+    bool ok = false;
+    try {
+        ramps.process(Audio_event_span(), 65);
+    } catch (const std::invalid_argument&) {
+        ok = true;
+    }
+    ramps.process(Audio_event_span(), 64);
+    std::printf("%-12s %s\n", "max_frames", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    for (auto curve : {Ramp_curve::linear, Ramp_curve::exponential, Ramp_curve::one_pole}) {
+        for (uint32_t block_size : {48000u, 512u, 1u}) {
+            ok = check_curve(curve, 1.f, 2.f, 48000, block_size) && ok;
+        }
+        ok = check_curve(curve, 2.f, -0.5f, 1000, 64) && ok;
+        ok = check_curve(curve, 0.001f, 1000.f, 4410, 100) && ok;
+    }
+    ok = check_host_ramp() && ok;
+    ok = check_max_frames() && ok;
+    return ok ? 0 : 1;
+}
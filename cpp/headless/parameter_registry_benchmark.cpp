@@ -0,0 +1,219 @@
+// Compares looking parameters up through a `Parameter_registry` with the `std::map`s and sorted
+// tables it replaced: by address, by identifier string, and when saving and restoring a whole
+// state.  Doesn't need a kernel.  Exits non-zero if the lookups disagree.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> parameter_counts = {16, 256, 4096};
+    size_t lookups = 100000;
+    size_t repetitions = 50;
+};
+
+// Stores values densely, so timing the state functions measures the states, not the set.
+class Dense_parameter_set : public Parameter_set {
+public:
+    explicit Dense_parameter_set(const Parameter_registry& registry_)
+        : registry(registry_), values(registry_.default_state())
+    {
+    }
+
+    void set_parameter(uint64_t address, float value) override
+    {
+        values[registry.index_of(address)] = value;
+    }
+    float get_parameter(uint64_t address) const override
+    {
+        return values[registry.index_of(address)];
+    }
+
+private:
+    const Parameter_registry& registry;
+    Dense_parameter_state values;
+};
+}
+
+// Keeps results from being optimized away.
+static std::atomic<uint64_t> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameter_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--lookups") == 0) {
+            options.lookups = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--repetitions") == 0) {
+            options.repetitions = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// Sparse, unordered addresses, as a plugin that hashes its identifiers would have.
+static std::vector<Parameter_info> make_hashed_parameters(size_t count)
+{
+    std::mt19937_64 random(3);
+    auto parameters = make_parameters(count);
+    for (auto& parameter : parameters) {
+        parameter.address = random() >> 32;
+    }
+    return parameters;
+}
+
+// Runs `f` `repetitions` times, and prints the time per `items`.
+static void time_it(const char* name,
+                    size_t parameter_count,
+                    size_t repetitions,
+                    size_t items,
+                    const std::function<uint64_t()>& f)
+{
+    std::vector<uint64_t> ns;
+    for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+        const auto start = std::chrono::steady_clock::now();
+        benchmark_sink += f();
+        ns.push_back(elapsed_ns(start));
+    }
+    const auto timings = summarize_timings(ns);
+    std::printf("%-24s %10zu %14.2f %14.2f\n",
+                name,
+                parameter_count,
+                timings.mean_ns / items,
+                static_cast<double>(timings.p50_ns) / items);
+}
+
+static bool run(const Options& options, size_t parameter_count)
+{
+    const auto parameters = make_hashed_parameters(parameter_count);
+    const Parameter_registry registry(parameters);
+
+    std::map<uint64_t, size_t> address_map;
+    std::vector<std::pair<uint64_t, size_t>> address_table;
+    std::map<std::string, uint64_t> identifier_map;
+    for (size_t index = 0; index < parameters.size(); ++index) {
+        address_map[parameters[index].address] = index;
+        address_table.emplace_back(parameters[index].address, index);
+        identifier_map[parameters[index].identifier_string] = parameters[index].address;
+    }
+    std::sort(begin(address_table), end(address_table));
+
+    std::mt19937 random(1);
+    std::vector<size_t> order(options.lookups);
+    for (auto& index : order) {
+        index = random() % parameter_count;
+    }
+    std::vector<uint64_t> addresses;
+    std::vector<const char*> identifiers;
+    for (auto index : order) {
+        addresses.push_back(parameters[index].address);
+        identifiers.push_back(parameters[index].identifier_string.c_str());
+    }
+
+    bool ok = true;
+    for (size_t index = 0; index < parameters.size(); ++index) {
+        ok = ok && registry.index_of(parameters[index].address) == index
+            && registry.index_of(parameters[index].identifier_string) == index;
+    }
+    ok = ok && registry.index_of(std::string_view("not a parameter")) == Parameter_registry::npos;
+
+    const auto lookups = options.lookups;
+    const auto repetitions = options.repetitions;
+    time_it("address: map", parameter_count, repetitions, lookups, [&] {
+        uint64_t sum = 0;
+        for (auto address : addresses) {
+            sum += address_map.find(address)->second;
+        }
+        return sum;
+    });
+    time_it("address: sorted table", parameter_count, repetitions, lookups, [&] {
+        uint64_t sum = 0;
+        for (auto address : addresses) {
+            sum += std::lower_bound(begin(address_table),
+                                    end(address_table),
+                                    address,
+                                    [](const auto& entry, uint64_t a) { return entry.first < a; })
+                       ->second;
+        }
+        return sum;
+    });
+    time_it("address: registry", parameter_count, repetitions, lookups, [&] {
+        uint64_t sum = 0;
+        for (auto address : addresses) {
+            sum += registry.index_of(address);
+        }
+        return sum;
+    });
+    time_it("identifier: map", parameter_count, repetitions, lookups, [&] {
+        uint64_t sum = 0;
+        for (auto identifier : identifiers) {
+            sum += identifier_map[std::string(identifier)];
+        }
+        return sum;
+    });
+    time_it("identifier: registry", parameter_count, repetitions, lookups, [&] {
+        uint64_t sum = 0;
+        for (auto identifier : identifiers) {
+            sum += registry.index_of(std::string_view(identifier));
+        }
+        return sum;
+    });
+
+    Dense_parameter_set parameter_set(registry);
+    time_it("state: map", parameter_count, repetitions, parameter_count, [&] {
+        const auto state = get_param_state(parameter_set, parameters);
+        set_param_state(parameter_set, state, parameters);
+        return static_cast<uint64_t>(state.size());
+    });
+    time_it("state: dense", parameter_count, repetitions, parameter_count, [&] {
+        const auto state = registry.get_state(parameter_set);
+        registry.set_state(parameter_set, state);
+        return static_cast<uint64_t>(state.size());
+    });
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options) || options.repetitions == 0
+        || options.lookups == 0) {
+        std::fprintf(stderr,
+                     "usage: %s [--parameters 16,256,...] [--lookups 100000] "
+                     "[--repetitions 50]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%-24s %10s %14s %14s\n", "", "params", "mean_ns/item", "p50_ns/item");
+    bool ok = true;
+    for (auto parameter_count : options.parameter_counts) {
+        if (parameter_count == 0) {
+            continue;
+        }
+        if (!run(options, parameter_count)) {
+            std::fprintf(stderr, "FAIL: registry lookups wrong for %zu parameters\n",
+                         parameter_count);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
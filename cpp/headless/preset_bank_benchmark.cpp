@@ -0,0 +1,175 @@
+// Compares restoring presets the way the AUv2 wrapper's "settings" dictionary does (a string
+// key built and looked up for each parameter) with applying presets from a memory-mapped
+// `Preset_bank`.  Writes a bank of `--presets` random presets of `--parameters` parameters to
+// `--path`, reopens it, then applies `--applies` randomly chosen presets each way.  Exits
+// non-zero if a preset read back from the bank doesn't match what was written.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Preset.h"
+#include "Brinicle/Kernel/Preset_bank.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> preset_counts = {1000, 10000};
+    std::vector<size_t> parameter_counts = {16, 256, 2000};
+    size_t applies = 1000;
+    std::string path = "preset_bank_benchmark.brpb";
+};
+
+// Stands in for a `CFDictionary` of `CFNumber`s keyed by identifier.
+using Dictionary_preset = std::map<std::string, float>;
+}
+
+// Keeps the restored values from being optimized away.
+static std::atomic<float> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--presets") == 0) {
+            options.preset_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--parameters") == 0) {
+            options.parameter_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--applies") == 0) {
+            options.applies = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--path") == 0) {
+            options.path = argv[i + 1];
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+static void print_result(const char* name,
+                         size_t preset_count,
+                         size_t parameter_count,
+                         uint64_t open_ns,
+                         std::vector<uint64_t>& ns)
+{
+    const auto timings = summarize_timings(ns);
+    std::printf("%-10s %8zu %10zu %14llu %12.1f %12llu %12llu\n",
+                name,
+                preset_count,
+                parameter_count,
+                static_cast<unsigned long long>(open_ns),
+                timings.mean_ns,
+                static_cast<unsigned long long>(timings.p99_ns),
+                static_cast<unsigned long long>(timings.max_ns));
+}
+
+// Returns false if the bank doesn't read back what was written.
+static bool run(const Options& options, size_t preset_count, size_t parameter_count)
+{
+    const auto parameters = make_parameters(parameter_count);
+    const Preset_codec codec(parameters);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> value_distribution(0.f, 1.f);
+
+    std::vector<Parameter_state> states(preset_count);
+    std::vector<Dictionary_preset> dictionaries(preset_count);
+    Preset_bank_writer writer;
+    for (size_t index = 0; index < preset_count; ++index) {
+        for (const auto& parameter : parameters) {
+            const auto value = value_distribution(random);
+            states[index][parameter.address] = value;
+            dictionaries[index][parameter.identifier_string] = value;
+        }
+        writer.add("Preset " + std::to_string(index), codec.serialize(states[index]));
+    }
+    writer.write(options.path);
+
+    std::uniform_int_distribution<size_t> preset_distribution(0, preset_count - 1);
+    std::vector<size_t> order(options.applies);
+    for (auto& index : order) {
+        index = preset_distribution(random);
+    }
+
+    auto state = get_default_state(parameters);
+    std::vector<uint64_t> ns;
+    ns.reserve(order.size());
+    for (auto index : order) {
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& parameter : parameters) {
+            const auto key = std::string(parameter.identifier_string);
+            const auto found = dictionaries[index].find(key);
+            if (found != end(dictionaries[index])) {
+                state[parameter.address] = found->second;
+            }
+        }
+        ns.push_back(elapsed_ns(start));
+    }
+    benchmark_sink = benchmark_sink + state.begin()->second;
+    print_result("dictionary", preset_count, parameter_count, 0, ns);
+
+    const auto open_start = std::chrono::steady_clock::now();
+    const Preset_bank bank(options.path);
+    const auto open_ns = elapsed_ns(open_start);
+
+    ns.clear();
+    for (auto index : order) {
+        const auto start = std::chrono::steady_clock::now();
+        codec.apply(bank.preset(index), state);
+        ns.push_back(elapsed_ns(start));
+    }
+    benchmark_sink = benchmark_sink + state.begin()->second;
+    print_result("bank", preset_count, parameter_count, open_ns, ns);
+
+    bool ok = bank.size() == preset_count;
+    for (size_t index = 0; ok && index < preset_count; ++index) {
+        auto read_back = get_default_state(parameters);
+        codec.apply(bank.preset(index), read_back);
+        ok = read_back == states[index] && bank.name(index) == "Preset " + std::to_string(index);
+    }
+    std::remove(options.path.c_str());
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--presets 1000,10000,...] [--parameters 16,256,...] "
+                     "[--applies 1000] [--path preset_bank_benchmark.brpb]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%-10s %8s %10s %14s %12s %12s %12s\n",
+                "",
+                "presets",
+                "params",
+                "open_ns",
+                "mean_ns",
+                "p99_ns",
+                "max_ns");
+    bool ok = true;
+    for (auto preset_count : options.preset_counts) {
+        for (auto parameter_count : options.parameter_counts) {
+            if (preset_count == 0) {
+                continue;
+            }
+            if (!run(options, preset_count, parameter_count)) {
+                std::fprintf(stderr,
+                             "FAIL: bank of %zu presets of %zu parameters didn't read back\n",
+                             preset_count,
+                             parameter_count);
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+// Renders a kernel through the headless host, under every adapter the library provides, and
+// fails if anything on the render path allocates, locks or blocks.
+//
+// Build the library sources with `-DBRINICLE_REALTIME_CHECKS=1`, and link this together with
+// `Realtime_interposer.cpp` and your kernel's static library.  This only detects anything on
+// Linux, where the interposer can replace `malloc` and `pthread_mutex_lock`; a self test at
+// the start fails if the interposer isn't working.
+
+#include "Brinicle/Glue/Make_kernel_factory.h"
+#include "Brinicle/Headless/Headless_host.h"
+#include "Brinicle/Kernel/Oversampling_kernel.h"
+#include "Brinicle/Kernel/Sub_block_kernel.h"
+#include "Brinicle/Thread/Realtime_checks.h"
+#include "Brinicle/Thread/Render_graph.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+constexpr double sample_rate = 48000.;
+constexpr uint32_t max_frames = 1024;
+constexpr size_t blocks_per_scenario = 2000;
+
+struct Scenario {
+    const char* name;
+    std::unique_ptr<KernelFactory> factory;
+    size_t events_per_block;
+    uint32_t channels = 2;
+};
+}
+
+#if !BRINICLE_REALTIME_CHECKS
+#error "realtime_check needs the library built with BRINICLE_REALTIME_CHECKS=1"
+#endif
+
+static bool report(const char* name, size_t blocks)
+{
+    if (blocks == 0) {
+        std::printf("%-32s (skipped: kernel doesn't support the channel count)\n", name);
+        return true;
+    }
+    const auto counts = Realtime_checks::counts();
+    const bool ok = counts.total() == 0;
+    std::printf("%-32s %8zu %12llu %8llu %10llu  %s\n",
+                name,
+                blocks,
+                static_cast<unsigned long long>(counts.allocations),
+                static_cast<unsigned long long>(counts.locks),
+                static_cast<unsigned long long>(counts.blocking_calls),
+                ok ? "ok" : Realtime_checks::first_violation());
+    Realtime_checks::reset();
+    return ok;
+}
+
+// Checks that each kind of violation is actually caught, so a broken interposer can't pass.
+static bool self_test()
+{
+    Realtime_checks::reset();
+    std::mutex mutex;
+    {
+        Realtime_checks::Scope scope;
+        delete new volatile int(0);
+        mutex.lock();
+        mutex.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(1));
+    }
+    // Outside a scope, nothing should be counted.
+    delete new volatile int(0);
+
+    const auto counts = Realtime_checks::counts();
+    Realtime_checks::reset();
+    if (counts.allocations != 2 || counts.locks != 1 || counts.blocking_calls != 1) {
+        std::printf("self test failed: %llu allocations, %llu locks, %llu blocking calls caught "
+                    "(expected 2, 1 and 1) - is Realtime_interposer.cpp linked?\n",
+                    static_cast<unsigned long long>(counts.allocations),
+                    static_cast<unsigned long long>(counts.locks),
+                    static_cast<unsigned long long>(counts.blocking_calls));
+        return false;
+    }
+    return true;
+}
+
+static Audio_event make_event(const KernelFactory::Info& info,
+                              std::mt19937& random,
+                              int64_t time,
+                              bool& note_is_on)
+{
+    const auto choice = random() % 3;
+    if (info.parameters.empty() || choice == 2) {
+        const uint8_t status = note_is_on ? 0x80 : 0x90;
+        note_is_on = !note_is_on;
+        return Midi_message {time, 0, 3, {status, 60, 100}};
+    }
+    const auto& param = info.parameters[random() % info.parameters.size()];
+    const auto value = std::visit(
+        overload {[&](const Numeric_parameter_info& numeric) {
+                      return static_cast<float>(numeric.min
+                                                + (numeric.max - numeric.min)
+                                                    * std::uniform_real_distribution<>()(random));
+                  },
+                  [&](const Indexed_parameter_info& indexed) {
+                      return static_cast<float>(random() % indexed.value_strings.size());
+                  }},
+        param.info);
+    if (choice == 1) {
+        return Ramped_parameter_change {time, param.address, value, 64};
+    }
+    return Parameter_change {time, param.address, value};
+}
+
+// Renders blocks of varying sizes, with events, while another thread plays the UI: moving
+// parameters, restoring states, syncing the mirrors and resetting the kernel.
+static size_t render_with_ui_thread(const Scenario& scenario)
+{
+    const auto info = scenario.factory->info();
+    const bool instrument = info.type == KernelFactory::Type::instrument;
+    const auto channels = scenario.channels;
+    if (!is_allowed_channel_configuration(info, instrument ? 0 : channels, channels)) {
+        return 0;
+    }
+    Headless_host host(*scenario.factory,
+                       Headless_host::Configuration {instrument ? 0 : channels,
+                                                     channels,
+                                                     sample_rate,
+                                                     max_frames,
+                                                     scenario.events_per_block});
+
+    const auto default_state = get_default_state(info.parameters);
+    std::atomic<bool> stop = {false};
+    std::thread ui([&] {
+        std::mt19937 random(2);
+        auto& ui_set = host.kernel().ui_parameter_set();
+        while (!stop) {
+            if (!info.parameters.empty()) {
+                const auto& param = info.parameters[random() % info.parameters.size()];
+                auto grabbed = ui_set.grab_parameter(param.address);
+                grabbed->set_parameter(ui_set.get_parameter(param.address));
+            }
+            if (random() % 16 == 0) {
+                host.kernel().reset();
+            }
+            if (random() % 32 == 0) {
+                host.kernel().set_state(default_state, random() % 2 ? 64 : 0);
+            }
+            host.kernel().sync_from_ui_thread([](uint64_t, float) {});
+            std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 random(1);
+    bool note_is_on = false;
+    const uint32_t block_sizes[] = {1, 15, 64, 256, 333, max_frames};
+    // A universal identity request, so the kernel sees sysex in its payload too.
+    const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+    for (size_t block = 0; block < blocks_per_scenario; ++block) {
+        const auto frame_count = block_sizes[block % std::size(block_sizes)];
+        for (size_t event = 0; event < scenario.events_per_block; ++event) {
+            const auto time = static_cast<int64_t>(random() % frame_count);
+            host.add_event(make_event(info, random, time, note_is_on));
+        }
+        if (scenario.events_per_block && block % 8 == 0) {
+            host.add_midi_packet(0, 0, Midi_packet_format::bytes, sysex, std::size(sysex));
+        }
+        host.render(frame_count);
+    }
+    stop = true;
+    ui.join();
+    return blocks_per_scenario;
+}
+
+// Kernels in a graph run on the pool's threads, so this checks those too.
+static size_t render_graph(const KernelFactory& factory)
+{
+    const auto info = factory.info();
+    const bool instrument = info.type == KernelFactory::Type::instrument;
+    const uint32_t channels = 2;
+    if (!is_allowed_channel_configuration(info, instrument ? 0 : channels, channels)) {
+        return 0;
+    }
+    auto client = std::make_shared<Wrapped_kernel::Host_interface>();
+    Render_graph graph(Render_graph::Configuration {max_frames, 16, 2});
+    const auto input = graph.add_input(channels);
+    const auto output = graph.add_mix(channels);
+    std::vector<Render_graph::Node_id> nodes;
+    for (size_t track = 0; track < 4; ++track) {
+        auto kernel = std::make_shared<Wrapped_kernel>(
+            factory.make_kernel(instrument ? 0 : channels, channels, sample_rate),
+            factory.parameter_registry(),
+            client,
+            sample_rate);
+        const auto node = graph.add_node(std::move(kernel), channels);
+        if (!instrument) {
+            graph.connect(input, node);
+        }
+        graph.connect(node, output);
+        nodes.push_back(node);
+    }
+    graph.prepare();
+
+    for (size_t block = 0; block < blocks_per_scenario; ++block) {
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            std::fill(graph.channel(input, channel), graph.channel(input, channel) + 256, 0.1f);
+        }
+        for (size_t track = 0; track < 4; ++track) {
+            graph.add_event(nodes[track], Parameter_change {0, 0, 0.5f});
+        }
+        graph.render(256);
+    }
+    return blocks_per_scenario;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], "--trap") == 0) {
+        Realtime_checks::set_trap(true);
+    } else if (argc > 1) {
+        std::fprintf(stderr, "usage: %s [--trap]\n", argv[0]);
+        return 1;
+    }
+    if (!self_test()) {
+        return 1;
+    }
+
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({"kernel", make_kernel_factory(), 0});
+    scenarios.push_back({"kernel, events", make_kernel_factory(), 32});
+    scenarios.push_back({"kernel, many events", make_kernel_factory(), 1000});
+    scenarios.push_back({"sub-block kernel, events",
+                         make_sub_block_kernel_factory(make_kernel_factory(),
+                                                       Sub_block_scheduler::Configuration {16, 8}),
+                         32});
+    scenarios.push_back(
+        {"oversampling kernel, events", make_oversampling_kernel_factory(make_kernel_factory(), 4),
+         32});
+    // As many channels as seventh-order ambisonics.
+    scenarios.push_back({"kernel, 64 channels, events", make_kernel_factory(), 32, 64});
+
+    bool ok = true;
+    std::printf("%-32s %8s %12s %8s %10s\n", "scenario", "blocks", "allocations", "locks",
+                "blocking");
+    for (const auto& scenario : scenarios) {
+        Realtime_checks::reset();
+        const auto blocks = render_with_ui_thread(scenario);
+        ok = report(scenario.name, blocks) && ok;
+    }
+    const auto blocks = render_graph(*make_kernel_factory());
+    ok = report("render graph", blocks) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+// Renders the kernel exported by the glue library through the full wrapper stack
+// (`Wrapped_kernel`, parameter mirrors, event delivery and the rust FFI) and reports how long
+// each block took.
+//
+// Every combination of the comma-separated `--block-sizes`, `--channels`, `--sample-rates` and
+// `--events-per-block` values is run and reported as one row.
+//
+// With `--ui-threads N`, N threads hammer the non-audio-thread side of `Wrapped_kernel` for the
+// whole run, so the worst-case block times show whether the render thread ever waits on them.
+// In this mode blocks are paced in real time, like a real audio thread, so the other threads
+// get to run.  For meaningful worst-case numbers, run on a machine with more cores than threads.
+//
+// With `--sub-block-grid` or `--sub-block-min`, the kernel is run through a
+// `Sub_block_scheduler` with that quantization, and the `sub_blocks` column reports the mean
+// number of sub-blocks per block.
+
+#include "Brinicle/Glue/Make_kernel_factory.h"
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Headless_host.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Sub_block_kernel.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<uint32_t> block_sizes = {64, 256, 1024};
+    std::vector<uint32_t> channel_counts = {2};
+    std::vector<double> sample_rates = {48000.};
+    std::vector<double> events_per_block = {0., 8.};
+    double seconds = 10.;
+    double warmup_seconds = 1.;
+    uint32_t seed = 1;
+    uint32_t ui_threads = 0;
+
+    // Zero for both means the kernel isn't split into sub-blocks.
+    uint32_t sub_block_grid = 0;
+    uint32_t sub_block_min = 0;
+};
+
+struct Run {
+    uint32_t block_size;
+    uint32_t channel_count;
+    double sample_rate;
+    double events_per_block;
+};
+}
+
+static void print_usage(const char* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--block-sizes 64,256,...] [--channels 2,...] "
+                 "[--sample-rates 48000,...] [--events-per-block 0,8,...] [--seconds 10] "
+                 "[--warmup-seconds 1] [--seed 1] [--ui-threads 0] [--sub-block-grid 0] "
+                 "[--sub-block-min 0]\n",
+                 name);
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 == argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(argv[i - 1], "--block-sizes") == 0) {
+            options.block_sizes = parse_list<uint32_t>(value);
+        } else if (std::strcmp(argv[i - 1], "--channels") == 0) {
+            options.channel_counts = parse_list<uint32_t>(value);
+        } else if (std::strcmp(argv[i - 1], "--sample-rates") == 0) {
+            options.sample_rates = parse_list<double>(value);
+        } else if (std::strcmp(argv[i - 1], "--events-per-block") == 0) {
+            options.events_per_block = parse_list<double>(value);
+        } else if (std::strcmp(argv[i - 1], "--seconds") == 0) {
+            options.seconds = std::strtod(value, nullptr);
+        } else if (std::strcmp(argv[i - 1], "--warmup-seconds") == 0) {
+            options.warmup_seconds = std::strtod(value, nullptr);
+        } else if (std::strcmp(argv[i - 1], "--seed") == 0) {
+            options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(argv[i - 1], "--ui-threads") == 0) {
+            options.ui_threads = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(argv[i - 1], "--sub-block-grid") == 0) {
+            options.sub_block_grid = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(argv[i - 1], "--sub-block-min") == 0) {
+            options.sub_block_min = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+/// Produces a random, time-sorted set of events for each block.  Parameter changes go to
+/// random parameters; instruments also get note on/off pairs.
+class Synthetic_events {
+public:
+    Synthetic_events(const KernelFactory::Info& info_, double events_per_block_, uint32_t seed)
+        : info(info_), events_per_block(events_per_block_), random(seed)
+    {
+    }
+
+    void schedule(Headless_host& host, uint32_t frame_count)
+    {
+        auto count = static_cast<size_t>(events_per_block);
+        if (std::uniform_real_distribution<double>(0., 1.)(random)
+            < events_per_block - static_cast<double>(count)) {
+            ++count;
+        }
+
+        times.resize(count);
+        std::uniform_int_distribution<int64_t> time_distribution(0, frame_count - 1);
+        for (auto& time : times) {
+            time = time_distribution(random);
+        }
+        std::sort(begin(times), end(times));
+
+        for (auto time : times) {
+            host.add_event(make_event(time));
+        }
+    }
+
+private:
+    Audio_event make_event(int64_t time)
+    {
+        const bool midi = info.type == KernelFactory::Type::instrument
+            && (info.parameters.empty() || (random() & 1u));
+        if (midi) {
+            const uint8_t status = note_is_on ? 0x80 : 0x90;
+            note_is_on = !note_is_on;
+            return Midi_message {time, 0, 3, {status, 60, 100}};
+        }
+
+        const auto& param = info.parameters[std::uniform_int_distribution<size_t>(
+            0, info.parameters.size() - 1)(random)];
+        const auto value = std::visit(
+            overload {[&](const Numeric_parameter_info& numeric) {
+                          return static_cast<float>(
+                              std::uniform_real_distribution<double>(numeric.min,
+                                                                     numeric.max)(random));
+                      },
+                      [&](const Indexed_parameter_info& indexed) {
+                          return static_cast<float>(std::uniform_int_distribution<size_t>(
+                              0, indexed.value_strings.size() - 1)(random));
+                      }},
+            param.info);
+        return Parameter_change {time, param.address, value};
+    }
+
+    const KernelFactory::Info& info;
+    double events_per_block;
+    std::mt19937 random;
+    std::vector<int64_t> times;
+    bool note_is_on = false;
+};
+}
+
+namespace {
+/// Calls every non-audio-thread entry point of a `Wrapped_kernel` in a tight loop, from
+/// several threads at once, for as long as it's alive.
+class Ui_thread_stress {
+public:
+    Ui_thread_stress(Wrapped_kernel& kernel_,
+                     const KernelFactory::Info& info,
+                     uint32_t thread_count,
+                     uint32_t seed)
+        : kernel(kernel_)
+    {
+        for (const auto& param : info.parameters) {
+            addresses.push_back(param.address);
+        }
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([this, thread_seed = seed + i + 1] { run(thread_seed); });
+        }
+    }
+
+    ~Ui_thread_stress() { stop(); }
+
+    void stop()
+    {
+        done = true;
+        for (auto& thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    /// Only complete after `stop`.
+    uint64_t operation_count() const { return operations.load(); }
+
+private:
+    void run(uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> value_distribution(0.f, 1.f);
+        uint64_t local_operations = 0;
+        while (!done) {
+            const auto address = addresses.empty()
+                ? 0
+                : addresses[std::uniform_int_distribution<size_t>(0, addresses.size() - 1)(random)];
+            switch (random() % 6) {
+            case 0:
+                kernel.set_parameter(address, value_distribution(random));
+                break;
+            case 1:
+                kernel.get_parameter(address);
+                break;
+            case 2:
+                kernel.get_latency();
+                break;
+            case 3:
+                kernel.ui_parameter_set().grab_parameter(address)->set_parameter(
+                    value_distribution(random));
+                break;
+            case 4:
+                kernel.ui_parameter_set().get_parameter(address);
+                break;
+            case 5:
+                kernel.sync_from_ui_thread([](uint64_t, float) {});
+                break;
+            }
+            ++local_operations;
+        }
+        operations += local_operations;
+    }
+
+    Wrapped_kernel& kernel;
+    std::vector<uint64_t> addresses;
+    std::atomic<bool> done = {false};
+    std::atomic<uint64_t> operations = {0};
+    std::vector<std::thread> threads;
+};
+}
+
+static void run_benchmark(const KernelFactory& factory,
+                          const Sub_block_statistics* sub_block_statistics,
+                          const Options& options,
+                          const Run& run)
+{
+    const auto& info = factory.info();
+    const uint32_t input_channels = info.type == KernelFactory::Type::instrument
+        ? 0
+        : run.channel_count;
+    if (!is_allowed_channel_configuration(info, input_channels, run.channel_count)) {
+        std::printf("%8u %8u %8.0f %8.2f  (channel configuration not supported by kernel)\n",
+                    run.block_size,
+                    run.channel_count,
+                    run.sample_rate,
+                    run.events_per_block);
+        return;
+    }
+    if (info.parameters.empty() && info.type != KernelFactory::Type::instrument
+        && run.events_per_block > 0.) {
+        std::printf("%8u %8u %8.0f %8.2f  (kernel has no parameters to automate)\n",
+                    run.block_size,
+                    run.channel_count,
+                    run.sample_rate,
+                    run.events_per_block);
+        return;
+    }
+
+    Headless_host host(factory,
+                       Headless_host::Configuration {
+                           input_channels,
+                           run.channel_count,
+                           run.sample_rate,
+                           run.block_size,
+                           static_cast<size_t>(run.events_per_block) + 1,
+                       });
+    Synthetic_events events(info, run.events_per_block, options.seed);
+
+    // Each block starts from the same noise input, so in-place processing can't drift
+    // into denormals or infinities over a long run.
+    std::vector<float> noise(run.block_size);
+    std::mt19937 noise_random(options.seed);
+    std::uniform_real_distribution<float> noise_distribution(-0.5f, 0.5f);
+    std::generate(begin(noise), end(noise), [&] { return noise_distribution(noise_random); });
+
+    auto block_count = [&](double seconds) {
+        return static_cast<size_t>(seconds * run.sample_rate / run.block_size) + 1;
+    };
+    const auto warmup_blocks = block_count(options.warmup_seconds);
+    const auto blocks = block_count(options.seconds);
+    std::vector<uint64_t> block_ns;
+    block_ns.reserve(blocks);
+
+    auto stress = options.ui_threads > 0
+        ? std::make_unique<Ui_thread_stress>(host.kernel(), info, options.ui_threads, options.seed)
+        : nullptr;
+
+    const auto block_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(run.block_size / run.sample_rate));
+    auto next_deadline = std::chrono::steady_clock::now();
+    uint64_t first_blocks = 0;
+    uint64_t first_sub_blocks = 0;
+
+    for (size_t block = 0; block < warmup_blocks + blocks; ++block) {
+        if (block == warmup_blocks && sub_block_statistics) {
+            first_blocks = sub_block_statistics->blocks.load();
+            first_sub_blocks = sub_block_statistics->sub_blocks.load();
+        }
+        if (stress) {
+            next_deadline += block_duration;
+            std::this_thread::sleep_until(next_deadline);
+        }
+        for (uint32_t channel = 0; channel < input_channels; ++channel) {
+            std::copy(begin(noise), end(noise), host.channel(channel));
+        }
+        events.schedule(host, run.block_size);
+
+        const auto start = std::chrono::steady_clock::now();
+        host.render(run.block_size);
+        const auto end = std::chrono::steady_clock::now();
+
+        if (block >= warmup_blocks) {
+            block_ns.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+    }
+
+    uint64_t ui_operations = 0;
+    if (stress) {
+        stress->stop();
+        ui_operations = stress->operation_count();
+    }
+    char sub_blocks[16] = "-";
+    if (sub_block_statistics) {
+        const auto measured_blocks = sub_block_statistics->blocks.load() - first_blocks;
+        const auto measured_sub_blocks = sub_block_statistics->sub_blocks.load() - first_sub_blocks;
+        std::snprintf(sub_blocks,
+                      sizeof(sub_blocks),
+                      "%.2f",
+                      static_cast<double>(measured_sub_blocks)
+                          / static_cast<double>(measured_blocks));
+    }
+    const auto stats = summarize_timings(block_ns);
+    const double budget_ns = 1e9 * run.block_size / run.sample_rate;
+    const double audio_ns = budget_ns * static_cast<double>(stats.count);
+    std::printf(
+        "%8u %8u %8.0f %8.2f %10.0f %10llu %10llu %10llu %10llu %10llu %8.4f %10.1f %10llu %10s\n",
+        run.block_size,
+        run.channel_count,
+        run.sample_rate,
+        run.events_per_block,
+        stats.mean_ns,
+        static_cast<unsigned long long>(stats.p50_ns),
+        static_cast<unsigned long long>(stats.p90_ns),
+        static_cast<unsigned long long>(stats.p99_ns),
+        static_cast<unsigned long long>(stats.p999_ns),
+        static_cast<unsigned long long>(stats.max_ns),
+        static_cast<double>(stats.max_ns) / budget_ns,
+        audio_ns / static_cast<double>(stats.total_ns),
+        static_cast<unsigned long long>(ui_operations),
+        sub_blocks);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<KernelFactory> factory = make_kernel_factory();
+    std::shared_ptr<Sub_block_statistics> sub_block_statistics;
+    if (options.sub_block_grid > 0 || options.sub_block_min > 0) {
+        sub_block_statistics = std::make_shared<Sub_block_statistics>();
+        factory = make_sub_block_kernel_factory(
+            std::move(factory),
+            Sub_block_scheduler::Configuration {std::max(options.sub_block_grid, 1u),
+                                                std::max(options.sub_block_min, 1u)},
+            sub_block_statistics);
+    }
+
+    std::printf("%8s %8s %8s %8s %10s %10s %10s %10s %10s %10s %8s %10s %10s %10s\n",
+                "frames",
+                "channels",
+                "rate",
+                "events",
+                "mean_ns",
+                "p50_ns",
+                "p90_ns",
+                "p99_ns",
+                "p99.9_ns",
+                "max_ns",
+                "max_load",
+                "rt_factor",
+                "ui_ops",
+                "sub_blocks");
+    for (auto block_size : options.block_sizes) {
+        for (auto channel_count : options.channel_counts) {
+            for (auto sample_rate : options.sample_rates) {
+                for (auto events_per_block : options.events_per_block) {
+                    run_benchmark(*factory,
+                                  sub_block_statistics.get(),
+                                  options,
+                                  Run {block_size, channel_count, sample_rate, events_per_block});
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Renders many instances of the kernel exported by the glue library through a `Render_graph`
+// and reports how throughput scales with the number of render threads.
+//
+// The graph is `--tracks` parallel tracks, each a chain of `--chain` kernel instances, all
+// mixed into one output.  Effects are fed from a shared noise input.  Each `--threads` value
+// is run and reported as one row, with its speedup over the first row.  Speedups can only
+// be meaningful up to the number of cores on the machine.
+
+#include "Brinicle/Glue/Make_kernel_factory.h"
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Headless_host.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Thread/Render_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    size_t tracks = 64;
+    size_t chain = 2;
+    uint32_t block_size = 256;
+    uint32_t channel_count = 2;
+    double sample_rate = 48000.;
+    double seconds = 10.;
+    std::vector<size_t> thread_counts;
+};
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--tracks") == 0) {
+            options.tracks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--chain") == 0) {
+            options.chain = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--block-size") == 0) {
+            options.block_size = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--channels") == 0) {
+            options.channel_count = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--sample-rate") == 0) {
+            options.sample_rate = std::strtod(argv[i + 1], nullptr);
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = std::strtod(argv[i + 1], nullptr);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options.thread_counts = parse_list(argv[i + 1]);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// Returns the mean time per block, in nanoseconds.
+static double run_benchmark(const KernelFactory& factory, const Options& options, size_t threads)
+{
+    const auto& info = factory.info();
+    const bool instrument = info.type == KernelFactory::Type::instrument;
+    auto client = std::make_shared<Wrapped_kernel::Host_interface>();
+
+    Render_graph graph(Render_graph::Configuration {options.block_size,
+                                                    Audio_event_buffer::default_capacity,
+                                                    threads});
+    const auto input = graph.add_input(options.channel_count);
+    const auto output = graph.add_mix(options.channel_count);
+    for (size_t track = 0; track < options.tracks; ++track) {
+        auto previous = input;
+        for (size_t link = 0; link < options.chain; ++link) {
+            auto kernel = std::make_shared<Wrapped_kernel>(
+                factory.make_kernel(instrument && link == 0 ? 0 : options.channel_count,
+                                    options.channel_count,
+                                    options.sample_rate),
+                factory.parameter_registry(),
+                client,
+                options.sample_rate);
+            apply_defaults(*kernel, info.parameters);
+            const auto node = graph.add_node(std::move(kernel), options.channel_count);
+            // Instruments start their tracks; they don't take the input.
+            if (link > 0 || !instrument) {
+                graph.connect(previous, node);
+            }
+            previous = node;
+        }
+        graph.connect(previous, output);
+    }
+    graph.prepare();
+
+    std::vector<float> noise(options.block_size);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+    std::generate(begin(noise), end(noise), [&] { return distribution(random); });
+
+    const auto blocks
+        = static_cast<size_t>(options.seconds * options.sample_rate / options.block_size) + 1;
+    std::vector<uint64_t> block_ns;
+    block_ns.reserve(blocks);
+    for (size_t block = 0; block < blocks; ++block) {
+        for (uint32_t channel = 0; channel < options.channel_count; ++channel) {
+            std::copy(begin(noise), end(noise), graph.channel(input, channel));
+        }
+        const auto start = std::chrono::steady_clock::now();
+        graph.render(options.block_size);
+        const auto end = std::chrono::steady_clock::now();
+        block_ns.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+    return summarize_timings(block_ns).mean_ns;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options) || options.chain == 0) {
+        std::fprintf(stderr,
+                     "usage: %s [--tracks 64] [--chain 2] [--block-size 256] [--channels 2] "
+                     "[--sample-rate 48000] [--seconds 10] [--threads 1,2,...]\n",
+                     argv[0]);
+        return 1;
+    }
+    if (options.thread_counts.empty()) {
+        const auto cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        for (size_t threads = 1; threads < cores; threads *= 2) {
+            options.thread_counts.push_back(threads);
+        }
+        options.thread_counts.push_back(cores);
+    }
+
+    const auto factory = make_kernel_factory();
+    const auto& info = factory->info();
+    const uint32_t input_channels
+        = info.type == KernelFactory::Type::instrument ? 0 : options.channel_count;
+    if (!is_allowed_channel_configuration(info, input_channels, options.channel_count)) {
+        std::fprintf(stderr, "channel configuration not supported by kernel\n");
+        return 1;
+    }
+
+    std::printf("%8s %8s %8s %12s %10s %8s\n",
+                "threads",
+                "tracks",
+                "kernels",
+                "mean_ns",
+                "rt_factor",
+                "speedup");
+    const double budget_ns = 1e9 * options.block_size / options.sample_rate;
+    double baseline_ns = 0.;
+    for (auto threads : options.thread_counts) {
+        const auto mean_ns = run_benchmark(*factory, options, threads);
+        if (baseline_ns == 0.) {
+            baseline_ns = mean_ns;
+        }
+        std::printf("%8zu %8zu %8zu %12.0f %10.1f %8.2f\n",
+                    threads,
+                    options.tracks,
+                    options.tracks * options.chain,
+                    mean_ns,
+                    budget_ns / mean_ns,
+                    baseline_ns / mean_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,366 @@
+// Compares rendering a simple polyphonic synth one voice at a time, from an array of voice
+// structs, with rendering it through `Voice_engine` with voice state in structure-of-arrays
+// form, a lane group of 1, 4, 8 or 16 voices at a time.  Each block, one held note is released
+// and a new one started, so about `--voices` voices are always held, plus those releasing.
+// Doesn't need a kernel.  Exits non-zero if the two renderings differ.
+
+#include "Brinicle/Headless/Benchmark_helpers.h"
+#include "Brinicle/Headless/Timing_statistics.h"
+#include "Brinicle/Kernel/Voice_engine.h"
+#include "Brinicle/Kernel/Voice_lanes.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Brinicle;
+
+namespace {
+struct Options {
+    std::vector<size_t> voice_counts = {16, 64, 256};
+    size_t block_size = 256;
+    size_t blocks = 2000;
+};
+
+constexpr float attack_step = 1.f / 256.f;
+constexpr float release_step = -1.f / 4096.f;
+
+float note_increment(uint8_t note)
+{
+    return 440.f / 48000.f * std::exp2((static_cast<float>(note) - 69.f) / 12.f);
+}
+
+// A cheap sine-like wave from a phase in [0, 1).
+float wave(float phase)
+{
+    const auto x = 2.f * phase - 1.f;
+    return 4.f * x * (1.f - std::fabs(x));
+}
+
+// The array-of-structs baseline: each voice is rendered on its own, and found by searching.
+class Struct_voices {
+public:
+    explicit Struct_voices(size_t max_voices) : voices(max_voices) {}
+
+    void note_on(size_t channel, size_t note, uint8_t velocity)
+    {
+        for (auto& voice : voices) {
+            if (!voice.playing) {
+                voice = Voice {true,
+                               false,
+                               channel,
+                               note,
+                               0.f,
+                               note_increment(static_cast<uint8_t>(note)),
+                               0.f,
+                               attack_step,
+                               velocity / 127.f / 16.f};
+                return;
+            }
+        }
+    }
+
+    void note_off(size_t channel, size_t note)
+    {
+        for (auto& voice : voices) {
+            if (voice.playing && !voice.released && voice.channel == channel
+                && voice.note == note) {
+                voice.released = true;
+                voice.envelope_step = release_step;
+            }
+        }
+    }
+
+    void render(float* out, size_t frame_count)
+    {
+        std::fill(out, out + frame_count, 0.f);
+        for (auto& voice : voices) {
+            if (!voice.playing) {
+                continue;
+            }
+            for (size_t i = 0; i < frame_count; ++i) {
+                voice.phase += voice.increment;
+                voice.phase = voice.phase >= 1.f ? voice.phase - 1.f : voice.phase;
+                voice.envelope
+                    = std::min(std::max(voice.envelope + voice.envelope_step, 0.f), 1.f);
+                out[i] += wave(voice.phase) * voice.envelope * voice.gain;
+            }
+            if (voice.released && voice.envelope == 0.f) {
+                voice.playing = false;
+            }
+        }
+    }
+
+private:
+    struct Voice {
+        bool playing = false;
+        bool released = false;
+        size_t channel = 0;
+        size_t note = 0;
+        float phase = 0.f;
+        float increment = 0.f;
+        float envelope = 0.f;
+        float envelope_step = 0.f;
+        float gain = 0.f;
+    };
+
+    std::vector<Voice> voices;
+};
+
+// The same synth as a `Voice_renderer`, rendering each lane group with `Voice_lanes`.
+class Array_voices : public Voice_renderer {
+public:
+    explicit Array_voices(size_t capacity)
+        : phases(capacity)
+        , increments(capacity)
+        , envelopes(capacity)
+        , envelope_steps(capacity)
+        , gains(capacity)
+        , released(capacity)
+    {
+    }
+
+    void start_voice(size_t slot, const Voice_note& note, bool) override
+    {
+        phases[slot] = 0.f;
+        increments[slot] = note_increment(note.note);
+        envelopes[slot] = 0.f;
+        envelope_steps[slot] = attack_step;
+        gains[slot] = note.velocity / 127.f / 16.f;
+        released[slot] = 0;
+    }
+
+    void release_voice(size_t slot, uint8_t) override
+    {
+        envelope_steps[slot] = release_step;
+        released[slot] = 1;
+    }
+
+    void move_voice(size_t from, size_t to) override
+    {
+        phases[to] = phases[from];
+        increments[to] = increments[from];
+        envelopes[to] = envelopes[from];
+        envelope_steps[to] = envelope_steps[from];
+        gains[to] = gains[from];
+        released[to] = released[from];
+    }
+
+    void clear_voice(size_t slot) override
+    {
+        phases[slot] = increments[slot] = envelopes[slot] = envelope_steps[slot] = gains[slot]
+            = 0.f;
+        released[slot] = 0;
+    }
+
+    void render(const Voice_group& group, Deinterleaved_audio audio) override
+    {
+        switch (group.lane_count) {
+        case 1:
+            return render_lanes<1>(group, audio);
+        case 4:
+            return render_lanes<4>(group, audio);
+        case 8:
+            return render_lanes<8>(group, audio);
+        default:
+            return render_lanes<16>(group, audio);
+        }
+    }
+
+private:
+    template <size_t Width> void render_lanes(const Voice_group& group, Deinterleaved_audio audio)
+    {
+        const auto first = group.first_slot;
+        auto phase = load_lanes<Width>(&phases[first]);
+        const auto increment = load_lanes<Width>(&increments[first]);
+        auto envelope = load_lanes<Width>(&envelopes[first]);
+        const auto envelope_step = load_lanes<Width>(&envelope_steps[first]);
+        const auto gain = load_lanes<Width>(&gains[first]);
+        const auto zero = broadcast_lanes<Width>(0.f);
+        const auto one = broadcast_lanes<Width>(1.f);
+
+        auto out = audio.data[0];
+        for (size_t i = 0; i < audio.frame_count; ++i) {
+            phase += increment;
+            phase = select_lanes(phase >= one, phase - one, phase);
+            envelope = min_lanes(max_lanes(envelope + envelope_step, zero), one);
+            const auto x = 2.f * phase - 1.f;
+            out[i] += sum_lanes(4.f * x * (1.f - abs_lanes(x)) * envelope * gain);
+        }
+
+        store_lanes<Width>(&phases[first], phase);
+        store_lanes<Width>(&envelopes[first], envelope);
+        for (size_t lane = 0; lane < group.active_count; ++lane) {
+            group.levels[lane] = envelopes[first + lane];
+            group.finished[lane] = released[first + lane] && envelopes[first + lane] == 0.f;
+        }
+    }
+
+    std::vector<float> phases;
+    std::vector<float> increments;
+    std::vector<float> envelopes;
+    std::vector<float> envelope_steps;
+    std::vector<float> gains;
+    std::vector<uint8_t> released;
+};
+
+// One block's notes: `off` is released, then `on` is started, at the start of the block.
+struct Block_notes {
+    uint16_t off;
+    uint16_t on;
+};
+}
+
+// Keeps the output from being optimized away.
+static std::atomic<float> benchmark_sink;
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--voices") == 0) {
+            options.voice_counts = parse_list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--block-size") == 0) {
+            options.block_size = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--blocks") == 0) {
+            options.blocks = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+static Midi_message note_message(uint8_t status, uint16_t key)
+{
+    return Midi_message {0,
+                         0,
+                         3,
+                         {static_cast<uint8_t>(status | (key / 128)),
+                          static_cast<uint8_t>(key % 128),
+                          static_cast<uint8_t>(100)}};
+}
+
+static void
+print_result(const char* name, size_t voice_count, std::vector<uint64_t>& ns, size_t frames)
+{
+    const auto timings = summarize_timings(ns);
+    std::printf("%-8s %8zu %14.1f %14llu %16.3f\n",
+                name,
+                voice_count,
+                timings.mean_ns,
+                static_cast<unsigned long long>(timings.p99_ns),
+                timings.mean_ns / static_cast<double>(voice_count * frames));
+}
+
+// Returns false if any `Voice_engine` rendering differs from the baseline.
+static bool run(const Options& options, size_t voice_count)
+{
+    // Distinct keys, spread across MIDI channels: note `key % 128` on channel `key / 128`.
+    const size_t key_count = 16 * 128;
+    std::mt19937 random(1);
+    std::vector<uint16_t> held(voice_count);
+    std::vector<uint16_t> free_keys;
+    for (uint16_t key = 0; key < key_count; ++key) {
+        if (key < voice_count) {
+            held[key] = key;
+        } else {
+            free_keys.push_back(key);
+        }
+    }
+    std::vector<Block_notes> notes(options.blocks);
+    for (auto& block : notes) {
+        auto& off = held[random() % held.size()];
+        auto& on = free_keys[random() % free_keys.size()];
+        block = Block_notes {off, on};
+        std::swap(off, on);
+    }
+
+    // Room for the held voices and those still releasing, so neither steals, in whole groups
+    // of the widest lanes.
+    const auto max_voices = (voice_count * 2 + 64 + 15) / 16 * 16;
+    const auto frame_count = options.block_size;
+    std::vector<float> expected(frame_count * options.blocks);
+    std::vector<uint64_t> ns;
+    ns.reserve(options.blocks);
+
+    Struct_voices struct_voices(max_voices);
+    for (size_t key = 0; key < voice_count; ++key) {
+        struct_voices.note_on(key / 128, key % 128, 100);
+    }
+    for (size_t block = 0; block < options.blocks; ++block) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto& block_notes = notes[block];
+        struct_voices.note_off(block_notes.off / 128, block_notes.off % 128);
+        struct_voices.note_on(block_notes.on / 128, block_notes.on % 128, 100);
+        struct_voices.render(&expected[block * frame_count], frame_count);
+        ns.push_back(elapsed_ns(start));
+    }
+    benchmark_sink = benchmark_sink + expected.back();
+    print_result("structs", voice_count, ns, frame_count);
+
+    bool ok = true;
+    std::vector<float> actual(frame_count);
+    for (size_t lane_width : {1, 4, 8, 16}) {
+        Array_voices array_voices(max_voices);
+        Voice_engine engine(
+            Voice_engine::Configuration {max_voices, lane_width, Voice_stealing::oldest},
+            array_voices,
+            1);
+        for (size_t key = 0; key < voice_count; ++key) {
+            engine.handle_midi(note_message(0x90, static_cast<uint16_t>(key)));
+        }
+
+        ns.clear();
+        float error = 0.f;
+        float* channels[] = {actual.data()};
+        for (size_t block = 0; block < options.blocks; ++block) {
+            const std::array<Audio_event, 2> events = {note_message(0x80, notes[block].off),
+                                                       note_message(0x90, notes[block].on)};
+            const auto start = std::chrono::steady_clock::now();
+            engine.process(Deinterleaved_audio {1, frame_count, channels},
+                           Audio_event_span(events.data(), events.size()));
+            ns.push_back(elapsed_ns(start));
+            for (size_t i = 0; i < frame_count; ++i) {
+                error = std::max(error, std::fabs(actual[i] - expected[block * frame_count + i]));
+            }
+        }
+        benchmark_sink = benchmark_sink + actual.back();
+        const auto name = "lanes " + std::to_string(lane_width);
+        print_result(name.c_str(), voice_count, ns, frame_count);
+        // Only the order of the sums differs.
+        ok = ok && error < 1e-3f;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options) || options.block_size == 0 || options.blocks == 0) {
+        std::fprintf(stderr,
+                     "usage: %s [--voices 16,64,256,...] [--block-size 256] [--blocks 2000]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::printf("%-8s %8s %14s %14s %16s\n", "", "voices", "mean_ns", "p99_ns", "ns/voice/frame");
+    bool ok = true;
+    for (auto voice_count : options.voice_counts) {
+        if (voice_count == 0 || voice_count > 1024) {
+            continue;
+        }
+        if (!run(options, voice_count)) {
+            std::fprintf(
+                stderr, "FAIL: voice engine rendering differs with %zu voices\n", voice_count);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
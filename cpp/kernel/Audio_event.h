@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Brinicle/Kernel/Parameter.h"
-#include <AudioToolbox/AudioToolbox.h>
+#include <algorithm>
 #include <array>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <optional>
+#include <variant>
+#include <vector>
 
 namespace Brinicle {
 
@@ -22,26 +24,220 @@ struct Ramped_parameter_change {
     uint32_t ramp_length;
 };
 
+/// A MIDI 1.0 message of at most three bytes.  Longer messages are `Midi_packet`s.
 struct Midi_message {
     int64_t buffer_offset_time;
     uint8_t cable;
-
-    // NOTE - currently, sysex is unsupported and max size of MIDI message is 3.
     uint16_t valid_bytes;
     std::array<uint8_t, 3> data;
 };
 
-using Audio_event = std::variant<Parameter_change, Ramped_parameter_change, Midi_message>;
+enum class Midi_packet_format : uint8_t {
+    /// A MIDI 1.0 byte stream, usually one whole sysex message from 0xF0 to 0xF7.
+    bytes,
+
+    /// MIDI 2.0 universal MIDI packets: whole 32-bit words, in native byte order.
+    ump,
+};
+
+/// MIDI too long for a `Midi_message`: a sysex message, or MIDI 2.0 packets.  The bytes
+/// aren't in the event, but in the block's payload, `size` bytes from `offset`; read them
+/// with `Audio_event_span::payload`.  So these are as cheap to copy and sort as any other
+/// event, however long the message.
+struct Midi_packet {
+    int64_t buffer_offset_time;
+    uint8_t cable;
+    Midi_packet_format format;
+    uint32_t offset;
+    uint32_t size;
+};
+
+using Audio_event
+    = std::variant<Parameter_change, Ramped_parameter_change, Midi_message, Midi_packet>;
+
+/// The number of 32-bit words in the universal MIDI packet starting with `first_word`.
+inline size_t ump_word_count(uint32_t first_word)
+{
+    static constexpr uint8_t counts[16] = {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+    return counts[first_word >> 28];
+}
 
 inline int64_t get_buffer_offset_time(const Audio_event& event)
 {
     return std::visit([](const auto& sub_event) { return sub_event.buffer_offset_time; }, event);
 }
 
-// Since apple provides events as a weird linked list, we can't represent an
-// event list as a span<event>.  Instead, we use a generator idiom.  If we
-// had C++ clients of this code, it's probably best to represent this by a
-// ranges_v3 iterator_range.
-using Audio_event_generator = std::function<std::optional<Audio_event>()>;
+/// A view of a block's events, sorted by `buffer_offset_time`, and of the payload their
+/// `Midi_packet`s refer to.  Both are owned by the host (usually an `Audio_event_buffer`) and
+/// are only valid for the duration of the `process` call.  Code that passes on a copy of the
+/// events, changed or not, should pass on the same `payload()` with them.
+class Audio_event_span {
+public:
+    Audio_event_span() : events_(nullptr), size_(0), payload_(nullptr) {}
+    Audio_event_span(const Audio_event* events, size_t size, const uint8_t* payload = nullptr)
+        : events_(events), size_(size), payload_(payload)
+    {
+    }
+
+    const Audio_event* begin() const { return events_; }
+    const Audio_event* end() const { return events_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Audio_event& operator[](size_t index) const { return events_[index]; }
+
+    const uint8_t* payload() const { return payload_; }
+
+    /// The first of `packet.size` bytes.  For `Midi_packet_format::ump`, these are aligned
+    /// for reading as `uint32_t`s.
+    const uint8_t* payload(const Midi_packet& packet) const { return payload_ + packet.offset; }
+
+private:
+    const Audio_event* events_;
+    size_t size_;
+    const uint8_t* payload_;
+};
+
+/// Fixed-capacity storage for one block's events, and for the payload of its `Midi_packet`s.
+/// The capacities are set when the host is initialized, so nothing here allocates on the
+/// audio thread.  Events are kept sorted by time, and events with equal times stay in the
+/// order they were pushed.
+class Audio_event_buffer {
+public:
+    static constexpr size_t default_capacity = 1024;
+    static constexpr size_t default_payload_capacity = 64 * 1024;
+
+    explicit Audio_event_buffer(size_t capacity = default_capacity,
+                                size_t payload_capacity = default_payload_capacity)
+    {
+        events.reserve(capacity);
+        payload.reserve(payload_capacity);
+    }
+
+    /// Changes the capacity - this allocates, so must not be called on the audio thread.
+    void set_capacity(size_t capacity)
+    {
+        events.clear();
+        events.shrink_to_fit();
+        events.reserve(capacity);
+        payload.clear();
+    }
+
+    /// Changes the payload capacity, in bytes - this allocates, so must not be called on the
+    /// audio thread.
+    void set_payload_capacity(size_t capacity)
+    {
+        events.clear();
+        payload.clear();
+        payload.shrink_to_fit();
+        payload.reserve(capacity);
+    }
+
+    size_t capacity() const { return events.capacity(); }
+    size_t payload_capacity() const { return payload.capacity(); }
+    size_t size() const { return events.size(); }
+    bool full() const { return events.size() == events.capacity(); }
+    void clear()
+    {
+        events.clear();
+        payload.clear();
+    }
+
+    /// Returns false, and drops the event, if the buffer is full.
+    bool push(const Audio_event& event)
+    {
+        if (full()) {
+            return false;
+        }
+        const auto time = get_buffer_offset_time(event);
+        if (events.empty() || get_buffer_offset_time(events.back()) <= time) {
+            events.push_back(event);
+        } else {
+            events.insert(std::upper_bound(events.begin(),
+                                           events.end(),
+                                           time,
+                                           [](int64_t t, const Audio_event& other) {
+                                               return t < get_buffer_offset_time(other);
+                                           }),
+                          event);
+        }
+        return true;
+    }
+
+    /// Copies `size` bytes into the payload, and pushes a `Midi_packet` referring to them.
+    /// Returns false, and drops the packet, if either the events or the payload are full.
+    bool push_midi_packet(int64_t buffer_offset_time,
+                          uint8_t cable,
+                          Midi_packet_format format,
+                          const uint8_t* bytes,
+                          size_t size)
+    {
+        // Keeps universal MIDI packets readable as words.  The padding counts against the
+        // capacity too, so the payload never grows past what was reserved.
+        const auto offset = (payload.size() + 3) & ~size_t(3);
+        if (full() || offset > payload.capacity() || size > payload.capacity() - offset) {
+            return false;
+        }
+        payload.resize(offset);
+        payload.insert(payload.end(), bytes, bytes + size);
+        return push(Midi_packet {buffer_offset_time,
+                                 cable,
+                                 format,
+                                 static_cast<uint32_t>(offset),
+                                 static_cast<uint32_t>(size)});
+    }
+
+    /// Pushes `word_count` words of universal MIDI packets.  MIDI 1.0 channel voice messages
+    /// are pushed as `Midi_message`s, so kernels that only handle those still see them; each
+    /// run of other messages is pushed as one `Midi_packet`.  Returns false if anything was
+    /// dropped because the buffer is full.
+    bool push_ump(int64_t buffer_offset_time,
+                  uint8_t cable,
+                  const uint32_t* words,
+                  size_t word_count)
+    {
+        constexpr uint32_t midi1_channel_voice = 2;
+        bool pushed = true;
+        size_t run_start = 0;
+        auto push_run = [&](size_t run_end) {
+            if (run_end > run_start) {
+                pushed &= push_midi_packet(buffer_offset_time,
+                                           cable,
+                                           Midi_packet_format::ump,
+                                           reinterpret_cast<const uint8_t*>(words + run_start),
+                                           (run_end - run_start) * sizeof(uint32_t));
+            }
+        };
+        for (size_t index = 0; index < word_count;) {
+            const auto word = words[index];
+            const auto count = std::min(ump_word_count(word), word_count - index);
+            if (word >> 28 == midi1_channel_voice) {
+                push_run(index);
+                const auto status = static_cast<uint8_t>(word >> 16);
+                // Program change and channel pressure have one data byte.
+                const auto kind = status & 0xF0;
+                const uint16_t valid_bytes = kind == 0xC0 || kind == 0xD0 ? 2 : 3;
+                pushed &= push(Midi_message {buffer_offset_time,
+                                             cable,
+                                             valid_bytes,
+                                             {status,
+                                              static_cast<uint8_t>(word >> 8 & 0x7F),
+                                              static_cast<uint8_t>(word & 0x7F)}});
+                run_start = index + count;
+            }
+            index += count;
+        }
+        push_run(word_count);
+        return pushed;
+    }
+
+    Audio_event_span span() const
+    {
+        return Audio_event_span(events.data(), events.size(), payload.data());
+    }
+
+private:
+    std::vector<Audio_event> events;
+    std::vector<uint8_t> payload;
+};
 
 }
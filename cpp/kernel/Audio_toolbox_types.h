@@ -0,0 +1,15 @@
+#pragma once
+
+// The kernel vocabulary borrows a couple of plain integer types from AudioToolbox for parameter
+// metadata.  On Apple platforms we use the real thing; elsewhere (e.g. the headless host) we
+// provide layout-compatible definitions so that `kernel/`, `thread/` and `glue/` build without the
+// SDK.
+
+#if defined(__APPLE__)
+#include <AudioToolbox/AudioToolbox.h>
+#else
+#include <cstdint>
+
+using AudioUnitParameterUnit = uint32_t;
+using AudioUnitParameterOptions = uint32_t;
+#endif
@@ -0,0 +1,638 @@
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BRINICLE_BUFFER_OPS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define BRINICLE_BUFFER_OPS_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace Brinicle;
+
+// Copying and clearing are left to libc in every implementation, since its `memcpy` and
+// `memset` are already vectorized for the CPU they run on.
+
+static void copy_scalar(const float* in, float* out, size_t frame_count)
+{
+    std::memcpy(out, in, frame_count * sizeof(float));
+}
+
+static void clear_scalar(float* out, size_t frame_count)
+{
+    std::memset(out, 0, frame_count * sizeof(float));
+}
+
+static void add_scalar(const float* in, float* out, size_t frame_count)
+{
+    for (size_t i = 0; i < frame_count; ++i) {
+        out[i] += in[i];
+    }
+}
+
+static void multiply_add_scalar(const float* in, float gain, float* out, size_t frame_count)
+{
+    for (size_t i = 0; i < frame_count; ++i) {
+        out[i] += gain * in[i];
+    }
+}
+
+static void apply_gain_scalar(float* buffer, float gain, size_t frame_count)
+{
+    for (size_t i = 0; i < frame_count; ++i) {
+        buffer[i] *= gain;
+    }
+}
+
+// Applies gain `start + step * (first + i + 1)` to sample `i`; the SIMD versions use this
+// for the samples left over after their last full vector.
+static void
+apply_gain_steps_scalar(float* buffer, float start, float step, size_t first, size_t frame_count)
+{
+    for (size_t i = 0; i < frame_count; ++i) {
+        buffer[i] *= start + step * static_cast<float>(first + i + 1);
+    }
+}
+
+static float ramp_step(float start, float end, size_t frame_count)
+{
+    return frame_count ? (end - start) / static_cast<float>(frame_count) : 0.f;
+}
+
+static void apply_gain_ramp_scalar(float* buffer, float start, float end, size_t frame_count)
+{
+    apply_gain_steps_scalar(buffer, start, ramp_step(start, end, frame_count), 0, frame_count);
+}
+
+static float peak_scalar(const float* in, size_t frame_count)
+{
+    float peak = 0.f;
+    for (size_t i = 0; i < frame_count; ++i) {
+        peak = std::max(peak, std::fabs(in[i]));
+    }
+    return peak;
+}
+
+static void apply_gains_scalar(float* const* channels,
+                               const float* gains,
+                               size_t channel_count,
+                               size_t frame_count)
+{
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        apply_gain_scalar(channels[channel], gains[channel], frame_count);
+    }
+}
+
+static void peaks_scalar(const float* const* channels,
+                         float* peaks,
+                         size_t channel_count,
+                         size_t frame_count)
+{
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        peaks[channel] = peak_scalar(channels[channel], frame_count);
+    }
+}
+
+namespace {
+const Buffer_ops::Implementation scalar_implementation = {
+    "scalar",
+    copy_scalar,
+    add_scalar,
+    multiply_add_scalar,
+    apply_gain_scalar,
+    apply_gain_ramp_scalar,
+    clear_scalar,
+    peak_scalar,
+    apply_gains_scalar,
+    peaks_scalar,
+};
+}
+
+#if BRINICLE_BUFFER_OPS_X86
+
+static void add_sse2(const float* in, float* out, size_t frame_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+    }
+    add_scalar(in + i, out + i, frame_count - i);
+}
+
+static void multiply_add_sse2(const float* in, float gain, float* out, size_t frame_count)
+{
+    const auto gains = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        _mm_storeu_ps(out + i,
+                      _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(gains, _mm_loadu_ps(in + i))));
+    }
+    multiply_add_scalar(in + i, gain, out + i, frame_count - i);
+}
+
+static void apply_gain_sse2(float* buffer, float gain, size_t frame_count)
+{
+    const auto gains = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), gains));
+    }
+    apply_gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+static void apply_gain_ramp_sse2(float* buffer, float start, float end, size_t frame_count)
+{
+    const auto step = ramp_step(start, end, frame_count);
+    const auto starts = _mm_set1_ps(start);
+    const auto steps = _mm_set1_ps(step);
+    const auto lanes = _mm_setr_ps(1.f, 2.f, 3.f, 4.f);
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        const auto index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+        const auto gains = _mm_add_ps(starts, _mm_mul_ps(steps, index));
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), gains));
+    }
+    apply_gain_steps_scalar(buffer + i, start, step, i, frame_count - i);
+}
+
+static float peak_sse2(const float* in, size_t frame_count)
+{
+    const auto sign = _mm_set1_ps(-0.f);
+    auto peaks = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        peaks = _mm_max_ps(peaks, _mm_andnot_ps(sign, _mm_loadu_ps(in + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, peaks);
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], peak_scalar(in + i, frame_count - i)});
+}
+
+// The channel-batched operations take channels four at a time.  Full vectors of frames are
+// handled a channel at a time, then any frames left over with a lane per channel.
+
+// Applies lane `k` of `gains` to frames `first` onwards of `group[k]`.
+static void
+apply_gains_lanes_sse2(float* const* group, __m128 gains, size_t first, size_t frame_count)
+{
+    for (size_t i = first; i < frame_count; ++i) {
+        float frame[4] = {group[0][i], group[1][i], group[2][i], group[3][i]};
+        _mm_storeu_ps(frame, _mm_mul_ps(_mm_loadu_ps(frame), gains));
+        for (size_t lane = 0; lane < 4; ++lane) {
+            group[lane][i] = frame[lane];
+        }
+    }
+}
+
+static void apply_gains_sse2(float* const* channels,
+                             const float* gains,
+                             size_t channel_count,
+                             size_t frame_count)
+{
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(3);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto buffer = group[lane];
+            const auto lane_gain = _mm_set1_ps(gains[channel + lane]);
+            for (size_t i = 0; i < vector_frames; i += 4) {
+                _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), lane_gain));
+            }
+        }
+        apply_gains_lanes_sse2(group, _mm_loadu_ps(gains + channel), vector_frames, frame_count);
+    }
+    apply_gains_scalar(channels + channel, gains + channel, channel_count - channel, frame_count);
+}
+
+// Folds the absolute values of frames `first` onwards of `group[k]` into lane `k` of `peaks`.
+static __m128
+peaks_lanes_sse2(const float* const* group, __m128 peaks, size_t first, size_t frame_count)
+{
+    const auto sign = _mm_set1_ps(-0.f);
+    for (size_t i = first; i < frame_count; ++i) {
+        const auto frame = _mm_setr_ps(group[0][i], group[1][i], group[2][i], group[3][i]);
+        peaks = _mm_max_ps(peaks, _mm_andnot_ps(sign, frame));
+    }
+    return peaks;
+}
+
+// Given each channel's peaks in `group_peaks[k]`, returns channel `k`'s peak in lane `k`.
+static __m128 transpose_peaks_sse2(__m128 group_peaks[4])
+{
+    _MM_TRANSPOSE4_PS(group_peaks[0], group_peaks[1], group_peaks[2], group_peaks[3]);
+    return _mm_max_ps(_mm_max_ps(group_peaks[0], group_peaks[1]),
+                      _mm_max_ps(group_peaks[2], group_peaks[3]));
+}
+
+static void peaks_sse2(const float* const* channels,
+                       float* peaks,
+                       size_t channel_count,
+                       size_t frame_count)
+{
+    const auto sign = _mm_set1_ps(-0.f);
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(3);
+        __m128 group_peaks[4];
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto in = group[lane];
+            auto lane_peaks = _mm_setzero_ps();
+            for (size_t i = 0; i < vector_frames; i += 4) {
+                lane_peaks = _mm_max_ps(lane_peaks, _mm_andnot_ps(sign, _mm_loadu_ps(in + i)));
+            }
+            group_peaks[lane] = lane_peaks;
+        }
+        _mm_storeu_ps(
+            peaks + channel,
+            peaks_lanes_sse2(group, transpose_peaks_sse2(group_peaks), vector_frames, frame_count));
+    }
+    peaks_scalar(channels + channel, peaks + channel, channel_count - channel, frame_count);
+}
+
+#define BRINICLE_AVX2 __attribute__((target("avx2")))
+
+BRINICLE_AVX2 static void add_avx2(const float* in, float* out, size_t frame_count)
+{
+    size_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        _mm256_storeu_ps(out + i,
+                         _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i)));
+    }
+    add_scalar(in + i, out + i, frame_count - i);
+}
+
+BRINICLE_AVX2 static void
+multiply_add_avx2(const float* in, float gain, float* out, size_t frame_count)
+{
+    const auto gains = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        _mm256_storeu_ps(
+            out + i,
+            _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(gains, _mm256_loadu_ps(in + i))));
+    }
+    multiply_add_scalar(in + i, gain, out + i, frame_count - i);
+}
+
+BRINICLE_AVX2 static void apply_gain_avx2(float* buffer, float gain, size_t frame_count)
+{
+    const auto gains = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), gains));
+    }
+    apply_gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+BRINICLE_AVX2 static void
+apply_gain_ramp_avx2(float* buffer, float start, float end, size_t frame_count)
+{
+    const auto step = ramp_step(start, end, frame_count);
+    const auto starts = _mm256_set1_ps(start);
+    const auto steps = _mm256_set1_ps(step);
+    const auto lanes = _mm256_setr_ps(1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f);
+    size_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        const auto index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+        const auto gains = _mm256_add_ps(starts, _mm256_mul_ps(steps, index));
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), gains));
+    }
+    apply_gain_steps_scalar(buffer + i, start, step, i, frame_count - i);
+}
+
+BRINICLE_AVX2 static float peak_avx2(const float* in, size_t frame_count)
+{
+    const auto sign = _mm256_set1_ps(-0.f);
+    auto peaks = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= frame_count; i += 8) {
+        peaks = _mm256_max_ps(peaks, _mm256_andnot_ps(sign, _mm256_loadu_ps(in + i)));
+    }
+    const auto halves = _mm_max_ps(_mm256_castps256_ps128(peaks), _mm256_extractf128_ps(peaks, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, halves);
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], peak_scalar(in + i, frame_count - i)});
+}
+
+BRINICLE_AVX2 static void apply_gains_avx2(float* const* channels,
+                                           const float* gains,
+                                           size_t channel_count,
+                                           size_t frame_count)
+{
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(7);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto buffer = group[lane];
+            const auto lane_gain = _mm256_set1_ps(gains[channel + lane]);
+            for (size_t i = 0; i < vector_frames; i += 8) {
+                _mm256_storeu_ps(buffer + i,
+                                 _mm256_mul_ps(_mm256_loadu_ps(buffer + i), lane_gain));
+            }
+        }
+        apply_gains_lanes_sse2(group, _mm_loadu_ps(gains + channel), vector_frames, frame_count);
+    }
+    apply_gains_scalar(channels + channel, gains + channel, channel_count - channel, frame_count);
+}
+
+BRINICLE_AVX2 static void peaks_avx2(const float* const* channels,
+                                     float* peaks,
+                                     size_t channel_count,
+                                     size_t frame_count)
+{
+    const auto sign = _mm256_set1_ps(-0.f);
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(7);
+        __m128 group_peaks[4];
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto in = group[lane];
+            auto lane_peaks = _mm256_setzero_ps();
+            for (size_t i = 0; i < vector_frames; i += 8) {
+                lane_peaks
+                    = _mm256_max_ps(lane_peaks, _mm256_andnot_ps(sign, _mm256_loadu_ps(in + i)));
+            }
+            group_peaks[lane] = _mm_max_ps(_mm256_castps256_ps128(lane_peaks),
+                                           _mm256_extractf128_ps(lane_peaks, 1));
+        }
+        _mm_storeu_ps(
+            peaks + channel,
+            peaks_lanes_sse2(group, transpose_peaks_sse2(group_peaks), vector_frames, frame_count));
+    }
+    peaks_scalar(channels + channel, peaks + channel, channel_count - channel, frame_count);
+}
+
+#undef BRINICLE_AVX2
+
+namespace {
+const Buffer_ops::Implementation sse2_implementation = {
+    "sse2",
+    copy_scalar,
+    add_sse2,
+    multiply_add_sse2,
+    apply_gain_sse2,
+    apply_gain_ramp_sse2,
+    clear_scalar,
+    peak_sse2,
+    apply_gains_sse2,
+    peaks_sse2,
+};
+
+const Buffer_ops::Implementation avx2_implementation = {
+    "avx2",
+    copy_scalar,
+    add_avx2,
+    multiply_add_avx2,
+    apply_gain_avx2,
+    apply_gain_ramp_avx2,
+    clear_scalar,
+    peak_avx2,
+    apply_gains_avx2,
+    peaks_avx2,
+};
+}
+
+#elif BRINICLE_BUFFER_OPS_NEON
+
+static void add_neon(const float* in, float* out, size_t frame_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vld1q_f32(in + i)));
+    }
+    add_scalar(in + i, out + i, frame_count - i);
+}
+
+static void multiply_add_neon(const float* in, float gain, float* out, size_t frame_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vmulq_n_f32(vld1q_f32(in + i), gain)));
+    }
+    multiply_add_scalar(in + i, gain, out + i, frame_count - i);
+}
+
+static void apply_gain_neon(float* buffer, float gain, size_t frame_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        vst1q_f32(buffer + i, vmulq_n_f32(vld1q_f32(buffer + i), gain));
+    }
+    apply_gain_scalar(buffer + i, gain, frame_count - i);
+}
+
+static void apply_gain_ramp_neon(float* buffer, float start, float end, size_t frame_count)
+{
+    const auto step = ramp_step(start, end, frame_count);
+    const float lane_values[4] = {1.f, 2.f, 3.f, 4.f};
+    const auto lanes = vld1q_f32(lane_values);
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        const auto index = vaddq_f32(vdupq_n_f32(static_cast<float>(i)), lanes);
+        const auto gains = vaddq_f32(vdupq_n_f32(start), vmulq_n_f32(index, step));
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), gains));
+    }
+    apply_gain_steps_scalar(buffer + i, start, step, i, frame_count - i);
+}
+
+static float peak_neon(const float* in, size_t frame_count)
+{
+    auto peaks = vdupq_n_f32(0.f);
+    size_t i = 0;
+    for (; i + 4 <= frame_count; i += 4) {
+        peaks = vmaxq_f32(peaks, vabsq_f32(vld1q_f32(in + i)));
+    }
+    return std::max(vmaxvq_f32(peaks), peak_scalar(in + i, frame_count - i));
+}
+
+// The channel-batched operations take channels four at a time.  Full vectors of frames are
+// handled a channel at a time, then any frames left over with a lane per channel.
+
+static void apply_gains_neon(float* const* channels,
+                             const float* gains,
+                             size_t channel_count,
+                             size_t frame_count)
+{
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(3);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto buffer = group[lane];
+            const auto lane_gain = gains[channel + lane];
+            for (size_t i = 0; i < vector_frames; i += 4) {
+                vst1q_f32(buffer + i, vmulq_n_f32(vld1q_f32(buffer + i), lane_gain));
+            }
+        }
+        const auto lane_gains = vld1q_f32(gains + channel);
+        for (auto i = vector_frames; i < frame_count; ++i) {
+            float frame[4] = {group[0][i], group[1][i], group[2][i], group[3][i]};
+            vst1q_f32(frame, vmulq_f32(vld1q_f32(frame), lane_gains));
+            for (size_t lane = 0; lane < 4; ++lane) {
+                group[lane][i] = frame[lane];
+            }
+        }
+    }
+    apply_gains_scalar(channels + channel, gains + channel, channel_count - channel, frame_count);
+}
+
+static void peaks_neon(const float* const* channels,
+                       float* peaks,
+                       size_t channel_count,
+                       size_t frame_count)
+{
+    size_t channel = 0;
+    for (; channel + 4 <= channel_count; channel += 4) {
+        const auto group = channels + channel;
+        const auto vector_frames = frame_count & ~size_t(3);
+        float lane_values[4];
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const auto in = group[lane];
+            auto lane_peaks = vdupq_n_f32(0.f);
+            for (size_t i = 0; i < vector_frames; i += 4) {
+                lane_peaks = vmaxq_f32(lane_peaks, vabsq_f32(vld1q_f32(in + i)));
+            }
+            lane_values[lane] = vmaxvq_f32(lane_peaks);
+        }
+        auto lane_peaks = vld1q_f32(lane_values);
+        for (auto i = vector_frames; i < frame_count; ++i) {
+            const float frame[4] = {group[0][i], group[1][i], group[2][i], group[3][i]};
+            lane_peaks = vmaxq_f32(lane_peaks, vabsq_f32(vld1q_f32(frame)));
+        }
+        vst1q_f32(peaks + channel, lane_peaks);
+    }
+    peaks_scalar(channels + channel, peaks + channel, channel_count - channel, frame_count);
+}
+
+namespace {
+const Buffer_ops::Implementation neon_implementation = {
+    "neon",
+    copy_scalar,
+    add_neon,
+    multiply_add_neon,
+    apply_gain_neon,
+    apply_gain_ramp_neon,
+    clear_scalar,
+    peak_neon,
+    apply_gains_neon,
+    peaks_neon,
+};
+}
+
+#endif
+
+static const Buffer_ops::Implementation& best_implementation()
+{
+#if BRINICLE_BUFFER_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2_implementation;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return sse2_implementation;
+    }
+#elif BRINICLE_BUFFER_OPS_NEON
+    return neon_implementation;
+#endif
+    return scalar_implementation;
+}
+
+const Buffer_ops::Implementation& Buffer_ops::implementation()
+{
+    // Doesn't allocate, so it's fine if this first happens on the audio thread.
+    static const Implementation& chosen = best_implementation();
+    return chosen;
+}
+
+std::vector<const Buffer_ops::Implementation*> Buffer_ops::supported_implementations()
+{
+    std::vector<const Implementation*> implementations = {&scalar_implementation};
+#if BRINICLE_BUFFER_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        implementations.push_back(&sse2_implementation);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        implementations.push_back(&avx2_implementation);
+    }
+#elif BRINICLE_BUFFER_OPS_NEON
+    implementations.push_back(&neon_implementation);
+#endif
+    return implementations;
+}
+
+void Buffer_ops::copy(Deinterleaved_audio from, Deinterleaved_audio to)
+{
+    const auto channel_count = std::min(from.channel_count, to.channel_count);
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        copy(from.data[channel], to.data[channel], from.frame_count);
+    }
+}
+
+void Buffer_ops::add(Deinterleaved_audio from, Deinterleaved_audio to)
+{
+    const auto channel_count = std::min(from.channel_count, to.channel_count);
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        add(from.data[channel], to.data[channel], from.frame_count);
+    }
+}
+
+void Buffer_ops::multiply_add(Deinterleaved_audio from, float gain, Deinterleaved_audio to)
+{
+    const auto channel_count = std::min(from.channel_count, to.channel_count);
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        multiply_add(from.data[channel], gain, to.data[channel], from.frame_count);
+    }
+}
+
+void Buffer_ops::apply_gain(Deinterleaved_audio audio, float gain)
+{
+    for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+        apply_gain(audio.data[channel], gain, audio.frame_count);
+    }
+}
+
+void Buffer_ops::apply_gain_ramp(Deinterleaved_audio audio, float start, float end)
+{
+    for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+        apply_gain_ramp(audio.data[channel], start, end, audio.frame_count);
+    }
+}
+
+void Buffer_ops::clear(Deinterleaved_audio audio)
+{
+    for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+        clear(audio.data[channel], audio.frame_count);
+    }
+}
+
+float Buffer_ops::peak(Deinterleaved_audio audio)
+{
+    float result = 0.f;
+    for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+        result = std::max(result, peak(audio.data[channel], audio.frame_count));
+    }
+    return result;
+}
+
+bool Buffer_ops::is_silent(Deinterleaved_audio audio, float threshold)
+{
+    return peak(audio) <= threshold;
+}
+
+void Buffer_ops::apply_gains(Deinterleaved_audio audio, const float* gains)
+{
+    implementation().apply_gains(audio.data, gains, audio.channel_count, audio.frame_count);
+}
+
+void Buffer_ops::peaks(Deinterleaved_audio audio, float* peaks)
+{
+    implementation().peaks(audio.data, peaks, audio.channel_count, audio.frame_count);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Brinicle/Kernel/Deinterleaved_audio.h"
+#include <cstddef>
+#include <vector>
+
+namespace Brinicle {
+
+/// Vectorized operations on audio buffers, for the wrappers' render paths.
+///
+/// Each operation has SSE2, AVX2, NEON and scalar versions; the fastest one the CPU supports
+/// is picked the first time any of them is used.  Buffers may not overlap unless noted.
+namespace Buffer_ops {
+
+    struct Implementation {
+        const char* name;
+
+        void (*copy)(const float* in, float* out, size_t frame_count);
+        void (*add)(const float* in, float* out, size_t frame_count);
+        void (*multiply_add)(const float* in, float gain, float* out, size_t frame_count);
+
+        /// In place.
+        void (*apply_gain)(float* buffer, float gain, size_t frame_count);
+
+        /// In place.  Like `Parameter_ramp`, sample `i` gets the gain `i + 1` frames into a
+        /// linear ramp from `start` to `end`, so the last sample gets exactly `end`.
+        void (*apply_gain_ramp)(float* buffer, float start, float end, size_t frame_count);
+
+        void (*clear)(float* out, size_t frame_count);
+
+        /// The largest absolute value.
+        float (*peak)(const float* in, size_t frame_count);
+
+        /// Channel-batched: in place, multiplies channel `i` by `gains[i]`.
+        void (*apply_gains)(float* const* channels,
+                            const float* gains,
+                            size_t channel_count,
+                            size_t frame_count);
+
+        /// Channel-batched: the largest absolute value of channel `i` goes in `peaks[i]`.
+        void (*peaks)(const float* const* channels,
+                      float* peaks,
+                      size_t channel_count,
+                      size_t frame_count);
+    };
+
+    /// The implementation in use.
+    const Implementation& implementation();
+
+    /// Every implementation this CPU can run, scalar first.  For benchmarks and tests.
+    std::vector<const Implementation*> supported_implementations();
+
+    inline void copy(const float* in, float* out, size_t frame_count)
+    {
+        implementation().copy(in, out, frame_count);
+    }
+
+    inline void add(const float* in, float* out, size_t frame_count)
+    {
+        implementation().add(in, out, frame_count);
+    }
+
+    inline void multiply_add(const float* in, float gain, float* out, size_t frame_count)
+    {
+        implementation().multiply_add(in, gain, out, frame_count);
+    }
+
+    inline void apply_gain(float* buffer, float gain, size_t frame_count)
+    {
+        implementation().apply_gain(buffer, gain, frame_count);
+    }
+
+    inline void apply_gain_ramp(float* buffer, float start, float end, size_t frame_count)
+    {
+        implementation().apply_gain_ramp(buffer, start, end, frame_count);
+    }
+
+    inline void clear(float* out, size_t frame_count) { implementation().clear(out, frame_count); }
+
+    inline float peak(const float* in, size_t frame_count)
+    {
+        return implementation().peak(in, frame_count);
+    }
+
+    /// True if no sample's absolute value is above `threshold`.
+    inline bool is_silent(const float* in, size_t frame_count, float threshold = 0.f)
+    {
+        return peak(in, frame_count) <= threshold;
+    }
+
+    // Multichannel versions.  Those taking two buffers use the first `from.frame_count` frames of
+    // as many channels as both have.
+
+    void copy(Deinterleaved_audio from, Deinterleaved_audio to);
+    void add(Deinterleaved_audio from, Deinterleaved_audio to);
+    void multiply_add(Deinterleaved_audio from, float gain, Deinterleaved_audio to);
+    void apply_gain(Deinterleaved_audio audio, float gain);
+    void apply_gain_ramp(Deinterleaved_audio audio, float start, float end);
+    void clear(Deinterleaved_audio audio);
+    float peak(Deinterleaved_audio audio);
+    bool is_silent(Deinterleaved_audio audio, float threshold = 0.f);
+
+    // Channel-batched versions, taking a value per channel, for formats with many channels
+    // like ambisonics or immersive speaker layouts.  The SIMD implementations run four
+    // channels at a time, with a lane per channel for frames that don't fill a vector, so short
+    // blocks don't pay a call and a scalar tail for every channel.
+
+    /// In place, multiplies channel `i` by `gains[i]`.
+    void apply_gains(Deinterleaved_audio audio, const float* gains);
+
+    /// The largest absolute value of channel `i` goes in `peaks[i]`.
+    void peaks(Deinterleaved_audio audio, float* peaks);
+
+}
+}
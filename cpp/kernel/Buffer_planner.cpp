@@ -0,0 +1,72 @@
+#include "Brinicle/Kernel/Buffer_planner.h"
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include <algorithm>
+
+using namespace Brinicle;
+
+Buffer_planner::Buffer_planner(float* const* scratch_,
+                               uint32_t scratch_channel_count,
+                               uint32_t max_channel_count)
+    : scratch(scratch_, scratch_ + scratch_channel_count)
+    , render(max_channel_count)
+    , copies_(max_channel_count)
+{
+}
+
+bool Buffer_planner::plan(const Request& request)
+{
+    const auto input_count = request.input == Input::none ? 0u : request.input_channel_count;
+    const auto output_count = request.output_channel_count;
+    render_channel_count_ = std::max(input_count, output_count);
+    copy_count_ = 0;
+    if (render_channel_count_ > render.size()) {
+        return false;
+    }
+
+    for (uint32_t channel = 0; channel < render_channel_count_; ++channel) {
+        float* host = channel < output_count && request.host_output
+            ? request.host_output[channel]
+            : nullptr;
+        if (request.input == Input::supplied && channel < input_count) {
+            float* input = request.supplied_input[channel];
+            const bool in_place = request.channel_in_place ? request.channel_in_place[channel]
+                                                           : request.process_in_place;
+            if (host == input && !in_place) {
+                host = nullptr;
+            }
+            if (!host && in_place) {
+                // Render where the input already is.
+                render[channel] = input;
+                continue;
+            }
+            if (!host) {
+                if (channel >= scratch.size()) {
+                    return false;
+                }
+                host = scratch[channel];
+            }
+            if (host != input) {
+                copies_[copy_count_++] = Copy {input, host};
+            }
+            render[channel] = host;
+            continue;
+        }
+
+        // Nothing to keep, so render in the host's buffer if there is one.
+        if (!host) {
+            if (channel >= scratch.size()) {
+                return false;
+            }
+            host = scratch[channel];
+        }
+        render[channel] = host;
+    }
+    return true;
+}
+
+void Buffer_planner::copy_input(uint32_t frame_count) const
+{
+    for (size_t index = 0; index < copy_count_; ++index) {
+        Buffer_ops::copy(copies_[index].from, copies_[index].to, frame_count);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Decides, for each block, which buffers a wrapper runs its kernel's in-place `process` on,
+/// so that as little audio as possible is copied.  The kernel renders straight into the host's
+/// output buffers where there are some, pulled input goes straight into the buffers the
+/// kernel will render in, and supplied input is rendered where it lies if processing in place
+/// is allowed.  The only copies left are of supplied input into an output buffer the host also
+/// supplied, or into scratch when the input mustn't be overwritten - at most one per channel,
+/// made before `process`.
+///
+/// Portable, so every combination can be checked without an audio unit host.  Nothing here
+/// allocates after construction.
+class Buffer_planner {
+public:
+    enum class Input {
+        /// The kernel takes no input.
+        none,
+
+        /// The wrapper picks the buffers the host renders input into, as for an AUv2 render
+        /// callback or an AUv3 pull.
+        pulled,
+
+        /// The host hands over buffers already holding the input, as for an AUv2 connection
+        /// or `AudioUnitProcess`.
+        supplied,
+    };
+
+    struct Request {
+        Input input;
+        uint32_t input_channel_count;
+        uint32_t output_channel_count;
+
+        /// For `Input::supplied`, the `input_channel_count` channels holding the input.
+        float* const* supplied_input;
+
+        /// The `output_channel_count` channels the host wants output in, or null if it will
+        /// take output wherever the plan puts it.  Single channels may be null too.  Each
+        /// channel must either be the same buffer as that channel's supplied input, which then
+        /// counts as overwriting it, or not overlap the supplied input at all.
+        float* const* host_output;
+
+        /// Whether supplied input may be overwritten.
+        bool process_in_place;
+
+        /// If not null, whether each channel of supplied input may be overwritten, instead of
+        /// `process_in_place` for all of them.  A channel that may be overwritten and is also
+        /// where the host wants that channel's output is rendered where it lies, without a
+        /// copy - as for pulled input the host left in the buffers we gave it.
+        const bool* channel_in_place = nullptr;
+    };
+
+    struct Copy {
+        const float* from;
+        float* to;
+    };
+
+    /// `scratch` is `scratch_channel_count` channels of at least the longest block, which a
+    /// plan uses for channel `i` when it can't use any of the host's buffers.  Requests may
+    /// have up to `max_channel_count` channels.
+    Buffer_planner(float* const* scratch,
+                   uint32_t scratch_channel_count,
+                   uint32_t max_channel_count);
+
+    /// Plans a block.  Returns false, leaving no usable plan, if it has too many channels or
+    /// would need scratch this doesn't have.
+    bool plan(const Request& request);
+
+    /// The channels to process in place: the input in the first `input_channel_count` of
+    /// them (pulled input should be rendered into these), and the output in the first
+    /// `output_channel_count` once the kernel is done.
+    uint32_t render_channel_count() const { return render_channel_count_; }
+    float* const* render_channels() const { return render.data(); }
+
+    /// Copies of supplied input, to make with `copy_input` before processing.
+    size_t copy_count() const { return copy_count_; }
+    const Copy* copies() const { return copies_.data(); }
+
+    void copy_input(uint32_t frame_count) const;
+
+private:
+    std::vector<float*> scratch;
+    std::vector<float*> render;
+    std::vector<Copy> copies_;
+    uint32_t render_channel_count_ = 0;
+    size_t copy_count_ = 0;
+};
+
+}
@@ -13,8 +13,21 @@ public:
 
     virtual void reset() = 0;
 
-    virtual void process(Deinterleaved_audio interleaved_audio, Audio_event_generator events) = 0;
+    /// `events` are sorted by time, and are only valid during this call.
+    virtual void process(Deinterleaved_audio interleaved_audio, Audio_event_span events) = 0;
 
     virtual uint64_t get_latency() const = 0;
+
+    /// Return true to promise that `take_changes` reports every parameter this kernel changes
+    /// by itself.  Wrappers then only look at those after each block, rather than polling
+    /// every parameter.
+    virtual bool reports_changes() const { return false; }
+
+    /// Calls `changed(context, address)` for each parameter this kernel has changed by itself
+    /// since the last call.  A parameter set through `set_parameter` or a parameter event needn't
+    /// be reported, unless `get_parameter` follows a ramp over later blocks.  Returns whether
+    /// the latency may have changed.  Only called after `process`, and only if
+    /// `reports_changes()` is true.
+    virtual bool take_changes(void* context, void (*changed)(void* context, uint64_t address));
 };
 }
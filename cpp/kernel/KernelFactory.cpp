@@ -1,3 +1,12 @@
 #include "Brinicle/Kernel/KernelFactory.h"
 
 Brinicle::KernelFactory::~KernelFactory() {}
+
+std::shared_ptr<const Brinicle::Parameter_registry>
+Brinicle::KernelFactory::parameter_registry() const
+{
+    std::call_once(registry_once, [this] {
+        registry = std::make_shared<const Parameter_registry>(info().parameters);
+    });
+    return registry;
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include "Brinicle/Kernel/Kernel.h"
 #include "Brinicle/Kernel/Parameter.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace Brinicle {
@@ -36,6 +40,14 @@ public:
     virtual std::unique_ptr<Kernel> make_kernel(uint32_t input_channel_count,
                                                 uint32_t output_channel_count,
                                                 double sample_rate) const = 0;
+
+    /// Indexes `info().parameters`.  Built the first time it's asked for, from any thread, and
+    /// shared by everything that wraps kernels from this factory.
+    std::shared_ptr<const Parameter_registry> parameter_registry() const;
+
+private:
+    mutable std::once_flag registry_once;
+    mutable std::shared_ptr<const Parameter_registry> registry;
 };
 
 }
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+namespace Brinicle {
+
+/// Reading and writing little-endian integers at any alignment, for file formats.
+namespace Little_endian {
+
+    inline uint16_t read_u16(const uint8_t* data)
+    {
+        return static_cast<uint16_t>(data[0] | data[1] << 8);
+    }
+
+    inline uint32_t read_u32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8
+            | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+    }
+
+    inline uint64_t read_u64(const uint8_t* data)
+    {
+        return static_cast<uint64_t>(read_u32(data))
+            | static_cast<uint64_t>(read_u32(data + 4)) << 32;
+    }
+
+    inline void write_u16(uint8_t* data, uint16_t value)
+    {
+        data[0] = static_cast<uint8_t>(value);
+        data[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    inline void write_u32(uint8_t* data, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) {
+            data[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    inline void write_u64(uint8_t* data, uint64_t value)
+    {
+        write_u32(data, static_cast<uint32_t>(value));
+        write_u32(data + 4, static_cast<uint32_t>(value >> 32));
+    }
+
+}
+
+}
@@ -0,0 +1,225 @@
+#include "Brinicle/Kernel/Oversampler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+
+// About 80dB of stopband attenuation.
+constexpr double kaiser_beta = 8.;
+
+// Per-stage filter lengths, starting from the stage nearest the base rate.  That stage has to
+// keep the base rate's passband up to about 0.43 of its sample rate; later stages only have
+// to reject images far above the audio.
+constexpr size_t stage_half_lengths[] = {20, 8, 6};
+}
+
+// Zeroth-order modified Bessel function of the first kind.
+static double bessel_i0(double x)
+{
+    double sum = 1.;
+    double term = 1.;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2. * k)) * (x / (2. * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// out[t] = sum(coefficients[i] * (x[t - i] + x[t - (2 * K - 1 - i)])), where
+// K = coefficients.size(), and `x` has 2 * K - 1 samples of history before it.
+static void symmetric_fir(
+    const float* x, size_t frame_count, const std::vector<float>& coefficients, float* out)
+{
+    const auto last = 2 * coefficients.size() - 1;
+    std::fill(out, out + frame_count, 0.f);
+    for (size_t i = 0; i < coefficients.size(); ++i) {
+        const auto coefficient = coefficients[i];
+        const float* newer = x - i;
+        const float* older = x - (last - i);
+        for (size_t t = 0; t < frame_count; ++t) {
+            out[t] += coefficient * (newer[t] + older[t]);
+        }
+    }
+}
+
+std::vector<float> Brinicle::design_half_band(size_t half_length)
+{
+    // The full filter has 4 * half_length - 1 taps, centered on `center`.  Taps at an even
+    // distance from the center are zero, except the center itself, which is 0.5; we return
+    // the first half of the ones at odd distances.
+    const auto center = static_cast<double>(2 * half_length - 1);
+    std::vector<double> taps(half_length);
+    double sum = 0.;
+    for (size_t i = 0; i < half_length; ++i) {
+        const auto distance = 2. * static_cast<double>(i) - center;
+        const auto phase = pi * distance / 2.;
+        const auto ratio = distance / center;
+        const auto window = bessel_i0(kaiser_beta * std::sqrt(std::max(0., 1. - ratio * ratio)))
+            / bessel_i0(kaiser_beta);
+        taps[i] = 0.5 * std::sin(phase) / phase * window;
+        sum += 2. * taps[i];
+    }
+
+    // Normalize so the filter has exactly unity gain at DC.
+    std::vector<float> coefficients(half_length);
+    for (size_t i = 0; i < half_length; ++i) {
+        coefficients[i] = static_cast<float>(taps[i] * 0.5 / sum);
+    }
+    return coefficients;
+}
+
+Half_band_upsampler::Half_band_upsampler(const std::vector<float>& coefficients_,
+                                         size_t max_input_frames)
+    : coefficients(coefficients_)
+    , input(2 * coefficients_.size() - 1 + max_input_frames)
+    , filtered(max_input_frames)
+{
+}
+
+void Half_band_upsampler::reset() { std::fill(begin(input), end(input), 0.f); }
+
+void Half_band_upsampler::process(const float* in, size_t frame_count, float* out)
+{
+    const auto history = 2 * coefficients.size() - 1;
+    std::copy(in, in + frame_count, input.data() + history);
+    const float* x = input.data() + history;
+
+    symmetric_fir(x, frame_count, coefficients, filtered.data());
+    const float* delayed = x - (coefficients.size() - 1);
+    for (size_t t = 0; t < frame_count; ++t) {
+        out[2 * t] = 2.f * filtered[t];
+        out[2 * t + 1] = delayed[t];
+    }
+
+    std::copy(input.data() + frame_count, input.data() + frame_count + history, input.data());
+}
+
+Half_band_downsampler::Half_band_downsampler(const std::vector<float>& coefficients_,
+                                             size_t max_output_frames)
+    : coefficients(coefficients_)
+    , even(2 * coefficients_.size() - 1 + max_output_frames)
+    , odd(coefficients_.size() + max_output_frames)
+{
+}
+
+void Half_band_downsampler::reset()
+{
+    std::fill(begin(even), end(even), 0.f);
+    std::fill(begin(odd), end(odd), 0.f);
+}
+
+void Half_band_downsampler::process(const float* in, size_t frame_count, float* out)
+{
+    const auto even_history = 2 * coefficients.size() - 1;
+    const auto odd_history = coefficients.size();
+    float* e = even.data() + even_history;
+    float* o = odd.data() + odd_history;
+    for (size_t t = 0; t < frame_count; ++t) {
+        e[t] = in[2 * t];
+        o[t] = in[2 * t + 1];
+    }
+
+    symmetric_fir(e, frame_count, coefficients, out);
+    const float* delayed = o - odd_history;
+    for (size_t t = 0; t < frame_count; ++t) {
+        out[t] += 0.5f * delayed[t];
+    }
+
+    std::copy(even.data() + frame_count, even.data() + frame_count + even_history, even.data());
+    std::copy(odd.data() + frame_count, odd.data() + frame_count + odd_history, odd.data());
+}
+
+Oversampler::Oversampler(uint32_t factor, size_t channel_count, size_t max_frames_)
+    : factor_(factor), stage_count(0), max_frames(max_frames_)
+{
+    switch (factor) {
+    case 2:
+        stage_count = 1;
+        break;
+    case 4:
+        stage_count = 2;
+        break;
+    case 8:
+        stage_count = 3;
+        break;
+    default:
+        throw std::invalid_argument("Oversampler: factor must be 2, 4 or 8");
+    }
+
+    std::vector<std::vector<float>> coefficients;
+    for (size_t stage = 0; stage < stage_count; ++stage) {
+        coefficients.push_back(design_half_band(stage_half_lengths[stage]));
+    }
+
+    channels.resize(channel_count);
+    for (auto& channel : channels) {
+        for (size_t stage = 0; stage < stage_count; ++stage) {
+            const auto input_frames = max_frames << stage;
+            channel.upsamplers.emplace_back(coefficients[stage], input_frames);
+            channel.downsamplers.emplace_back(coefficients[stage], input_frames);
+            channel.buffers.emplace_back(2 * input_frames);
+        }
+    }
+    oversampled.resize(channel_count);
+}
+
+Deinterleaved_audio Oversampler::upsample(Deinterleaved_audio audio)
+{
+    if (audio.frame_count > max_frames || audio.channel_count > channels.size()) {
+        throw std::invalid_argument("Oversampler: block is larger than its buffers");
+    }
+    frame_count = audio.frame_count;
+    for (size_t index = 0; index < audio.channel_count; ++index) {
+        auto& channel = channels[index];
+        const float* in = audio.data[index];
+        for (size_t stage = 0; stage < stage_count; ++stage) {
+            channel.upsamplers[stage].process(
+                in, frame_count << stage, channel.buffers[stage].data());
+            in = channel.buffers[stage].data();
+        }
+        oversampled[index] = channel.buffers[stage_count - 1].data();
+    }
+    return Deinterleaved_audio {audio.channel_count, frame_count * factor_, oversampled.data()};
+}
+
+void Oversampler::downsample(Deinterleaved_audio audio)
+{
+    for (size_t index = 0; index < audio.channel_count; ++index) {
+        auto& channel = channels[index];
+        for (size_t stage = stage_count; stage-- > 0;) {
+            float* out = stage > 0 ? channel.buffers[stage - 1].data() : audio.data[index];
+            channel.downsamplers[stage].process(
+                channel.buffers[stage].data(), frame_count << stage, out);
+        }
+    }
+}
+
+void Oversampler::reset()
+{
+    for (auto& channel : channels) {
+        for (auto& upsampler : channel.upsamplers) {
+            upsampler.reset();
+        }
+        for (auto& downsampler : channel.downsamplers) {
+            downsampler.reset();
+        }
+    }
+}
+
+double Oversampler::latency() const
+{
+    double latency = 0.;
+    for (size_t stage = 0; stage < stage_count; ++stage) {
+        // Each direction delays by one less than the branch length, at the higher rate.
+        const auto round_trip = 2. * static_cast<double>(2 * stage_half_lengths[stage] - 1);
+        latency += round_trip / static_cast<double>(size_t(2) << stage);
+    }
+    return latency;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "Brinicle/Kernel/Deinterleaved_audio.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Doubles the sample rate of one channel with a linear-phase half-band FIR filter.
+///
+/// Half of a half-band filter's taps are zero, so it's run as two polyphase branches: one
+/// output phase is a symmetric FIR over the input, and the other is just the input, delayed.
+/// The inner loops run over whole blocks, tap by tap, so the compiler can vectorize them.
+class Half_band_upsampler {
+public:
+    /// `coefficients` is the first half of the non-trivial branch; see `design_half_band`.
+    Half_band_upsampler(const std::vector<float>& coefficients, size_t max_input_frames);
+
+    /// Writes `2 * frame_count` samples to `out`.
+    void process(const float* in, size_t frame_count, float* out);
+
+    void reset();
+
+    /// In output samples.
+    size_t latency() const { return 2 * coefficients.size() - 1; }
+
+private:
+    std::vector<float> coefficients;
+    std::vector<float> input;
+    std::vector<float> filtered;
+};
+
+/// Halves the sample rate of one channel; the inverse of `Half_band_upsampler`.
+class Half_band_downsampler {
+public:
+    Half_band_downsampler(const std::vector<float>& coefficients, size_t max_output_frames);
+
+    /// Reads `2 * frame_count` samples from `in`.
+    void process(const float* in, size_t frame_count, float* out);
+
+    void reset();
+
+    /// In input samples.
+    size_t latency() const { return 2 * coefficients.size() - 1; }
+
+private:
+    std::vector<float> coefficients;
+    std::vector<float> even;
+    std::vector<float> odd;
+};
+
+/// Designs a Kaiser-windowed half-band lowpass with `2 * half_length` taps in its non-trivial
+/// branch, returning the first `half_length` of them (the rest are mirrored).  Longer filters
+/// have a sharper transition around a quarter of the (higher) sample rate.
+std::vector<float> design_half_band(size_t half_length);
+
+/// Changes the sample rate of multichannel audio by 2, 4 or 8, with a cascade of half-band
+/// filters.  Each stage only needs to be as sharp as the audio it sees, so stages further
+/// from the base rate use shorter filters.  All buffers are allocated up front.
+class Oversampler {
+public:
+    Oversampler(uint32_t factor, size_t channel_count, size_t max_frames);
+
+    uint32_t factor() const { return factor_; }
+
+    /// Upsamples `audio` into internal buffers, and returns them.  The result stays valid until
+    /// the next call, and may be processed in place before passing it to `downsample`.
+    Deinterleaved_audio upsample(Deinterleaved_audio audio);
+
+    /// Downsamples the audio returned by `upsample` back into `audio`.
+    void downsample(Deinterleaved_audio audio);
+
+    void reset();
+
+    /// The delay of an `upsample`/`downsample` round trip, in base-rate frames.  This isn't
+    /// always a whole number of frames.
+    double latency() const;
+
+private:
+    struct Channel {
+        std::vector<Half_band_upsampler> upsamplers;
+        std::vector<Half_band_downsampler> downsamplers;
+
+        // `buffers[stage]` holds audio at `2^(stage + 1)` times the base rate.
+        std::vector<std::vector<float>> buffers;
+    };
+
+    uint32_t factor_;
+    size_t stage_count;
+    size_t max_frames;
+    size_t frame_count = 0;
+    std::vector<Channel> channels;
+    std::vector<float*> oversampled;
+};
+
+}
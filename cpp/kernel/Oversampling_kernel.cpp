@@ -0,0 +1,157 @@
+#include "Brinicle/Kernel/Oversampling_kernel.h"
+#include "Brinicle/Kernel/Oversampler.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Brinicle;
+
+namespace {
+class Oversampling_kernel : public Kernel {
+public:
+    Oversampling_kernel(std::unique_ptr<Kernel> inner_,
+                        uint32_t factor,
+                        size_t channel_count,
+                        uint32_t max_frames_per_block_)
+        : inner(std::move(inner_))
+        , oversampler(factor, channel_count, max_frames_per_block_)
+        , max_frames_per_block(max_frames_per_block_)
+        , chunk_pointers(channel_count)
+    {
+        scaled_events.reserve(Audio_event_buffer::default_capacity);
+    }
+
+    void set_parameter(uint64_t address, float value) override
+    {
+        inner->set_parameter(address, value);
+    }
+
+    float get_parameter(uint64_t address) const override { return inner->get_parameter(address); }
+
+    void reset() override
+    {
+        oversampler.reset();
+        inner->reset();
+    }
+
+    void process(Deinterleaved_audio audio, Audio_event_span events) override
+    {
+        const auto factor = static_cast<int64_t>(oversampler.factor());
+        size_t event_index = 0;
+        size_t start = 0;
+        do {
+            const auto frame_count = std::min<size_t>(audio.frame_count - start,
+                                                      max_frames_per_block);
+            const auto end = start + frame_count;
+            const bool last_chunk = end == audio.frame_count;
+
+            scaled_events.clear();
+            for (; event_index < events.size(); ++event_index) {
+                const auto& event = events[event_index];
+                const auto time = get_buffer_offset_time(event);
+                if (!last_chunk && time >= static_cast<int64_t>(end)) {
+                    break;
+                }
+                if (scaled_events.size() == scaled_events.capacity()) {
+                    // Like the wrappers, if there are too many events, apply parameter changes
+                    // right away and drop the rest.
+                    std::visit(overload {[&](const Parameter_change& change) {
+                                             inner->set_parameter(change.address, change.value);
+                                         },
+                                         [&](const Ramped_parameter_change& change) {
+                                             inner->set_parameter(change.address, change.value);
+                                         },
+                                         [](const Midi_message&) {},
+                                         [](const Midi_packet&) {}},
+                               event);
+                    continue;
+                }
+
+                const auto last_frame = std::max<int64_t>(frame_count, 1) - 1;
+                const auto scaled_time
+                    = std::clamp<int64_t>(time - static_cast<int64_t>(start), 0, last_frame)
+                    * factor;
+                scaled_events.push_back(event);
+                std::visit(overload {[&](Ramped_parameter_change& change) {
+                                         change.buffer_offset_time = scaled_time;
+                                         change.ramp_length *= static_cast<uint32_t>(factor);
+                                     },
+                                     [&](auto& other) { other.buffer_offset_time = scaled_time; }},
+                           scaled_events.back());
+            }
+
+            for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+                chunk_pointers[channel] = audio.data[channel] + start;
+            }
+            const Deinterleaved_audio chunk {
+                audio.channel_count, frame_count, chunk_pointers.data()};
+            inner->process(oversampler.upsample(chunk),
+                           Audio_event_span(
+                               scaled_events.data(), scaled_events.size(), events.payload()));
+            oversampler.downsample(chunk);
+            start = end;
+        } while (start < audio.frame_count);
+    }
+
+    uint64_t get_latency() const override
+    {
+        return static_cast<uint64_t>(std::lround(
+            static_cast<double>(inner->get_latency()) / oversampler.factor()
+            + oversampler.latency()));
+    }
+
+    bool reports_changes() const override { return inner->reports_changes(); }
+
+    bool take_changes(void* context, void (*changed)(void* context, uint64_t address)) override
+    {
+        return inner->take_changes(context, changed);
+    }
+
+private:
+    std::unique_ptr<Kernel> inner;
+    Oversampler oversampler;
+    uint32_t max_frames_per_block;
+    std::vector<float*> chunk_pointers;
+    std::vector<Audio_event> scaled_events;
+};
+
+class Oversampling_kernel_factory : public KernelFactory {
+public:
+    Oversampling_kernel_factory(std::unique_ptr<KernelFactory> inner_,
+                                uint32_t factor_,
+                                uint32_t max_frames_per_block_)
+        : inner(std::move(inner_)), factor(factor_), max_frames_per_block(max_frames_per_block_)
+    {
+    }
+
+    const Info& info() const override { return inner->info(); }
+
+    std::unique_ptr<Kernel> make_kernel(uint32_t input_channel_count,
+                                        uint32_t output_channel_count,
+                                        double sample_rate) const override
+    {
+        auto kernel = inner->make_kernel(
+            input_channel_count, output_channel_count, sample_rate * factor);
+        if (!kernel) {
+            return nullptr;
+        }
+        return std::make_unique<Oversampling_kernel>(
+            std::move(kernel),
+            factor,
+            std::max(input_channel_count, output_channel_count),
+            max_frames_per_block);
+    }
+
+private:
+    std::unique_ptr<KernelFactory> inner;
+    uint32_t factor;
+    uint32_t max_frames_per_block;
+};
+}
+
+std::unique_ptr<KernelFactory> Brinicle::make_oversampling_kernel_factory(
+    std::unique_ptr<KernelFactory> factory, uint32_t factor, uint32_t max_frames_per_block)
+{
+    return std::make_unique<Oversampling_kernel_factory>(
+        std::move(factory), factor, max_frames_per_block);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Brinicle/Kernel/KernelFactory.h"
+#include <memory>
+
+namespace Brinicle {
+
+/// Wraps `factory` so that each kernel it makes runs at `factor` (2, 4 or 8) times the host's
+/// sample rate, with the audio resampled through `Oversampler`.  This is mainly useful for
+/// nonlinear kernels, which would otherwise alias.
+///
+/// Event times and ramp lengths are scaled to the higher rate, and the filters' delay is added
+/// to the kernel's latency.  Blocks longer than `max_frames_per_block` are split up, so that
+/// all buffers can be allocated when the kernel is made.
+std::unique_ptr<KernelFactory> make_oversampling_kernel_factory(
+    std::unique_ptr<KernelFactory> factory, uint32_t factor, uint32_t max_frames_per_block = 4096);
+
+}
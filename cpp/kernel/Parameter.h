@@ -1,6 +1,6 @@
 #pragma once
 
-#include <AudioToolbox/AudioToolbox.h>
+#include "Brinicle/Kernel/Audio_toolbox_types.h"
 #include <map>
 #include <string>
 #include <variant>
@@ -46,6 +46,10 @@ public:
 void apply_defaults(Parameter_set& parameter_set, const std::vector<Parameter_info>& parameters);
 
 using Parameter_state = std::map<uint64_t, float>;
+
+/// A value for every parameter, in the order of the `Parameter_info` list.  See
+/// `Parameter_registry`.
+using Dense_parameter_state = std::vector<float>;
 Parameter_state get_param_state(const Parameter_set& parameter_set,
                                 const std::vector<Parameter_info>& parameters);
 
@@ -0,0 +1,260 @@
+#include "Brinicle/Kernel/Parameter_ramp.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+// One-pole ramps are considered finished once they're this close to the target.
+constexpr float one_pole_settled = 1e-4f;
+constexpr size_t geometric_chunk = 8;
+}
+
+static void fill_constant(float* out, uint32_t frame_count, float value)
+{
+    std::fill(out, out + frame_count, value);
+}
+
+// out[i] = start + step * (first + i)
+static void fill_linear(float* out, uint32_t frame_count, float start, float step, uint32_t first)
+{
+    const float base = start + step * static_cast<float>(first);
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        out[i] = base + step * static_cast<float>(i);
+    }
+}
+
+// out[i] = offset + scale * ratio^(first + i)
+static void fill_geometric(
+    float* out, uint32_t frame_count, float offset, float scale, double ratio, uint32_t first)
+{
+    float powers[geometric_chunk];
+    for (size_t k = 0; k < geometric_chunk; ++k) {
+        powers[k] = static_cast<float>(std::pow(ratio, static_cast<double>(k)));
+    }
+    const double chunk_ratio = std::pow(ratio, static_cast<double>(geometric_chunk));
+
+    double chunk_scale = scale * std::pow(ratio, static_cast<double>(first));
+    uint32_t i = 0;
+    for (; i + geometric_chunk <= frame_count; i += geometric_chunk) {
+        const auto s = static_cast<float>(chunk_scale);
+        for (size_t k = 0; k < geometric_chunk; ++k) {
+            out[i + k] = offset + s * powers[k];
+        }
+        chunk_scale *= chunk_ratio;
+    }
+    const auto s = static_cast<float>(chunk_scale);
+    for (size_t k = 0; i < frame_count; ++i, ++k) {
+        out[i] = offset + s * powers[k];
+    }
+}
+
+Parameter_ramp::Parameter_ramp(Configuration configuration_, float initial_value)
+    : configuration(configuration_), current(initial_value), target_(initial_value)
+{
+}
+
+void Parameter_ramp::reset(float value)
+{
+    current = value;
+    target_ = value;
+    remaining_frames = 0;
+}
+
+void Parameter_ramp::ramp_to(float target, uint32_t ramp_frames)
+{
+    if (ramp_frames == 0 || target == current) {
+        reset(target);
+        return;
+    }
+
+    target_ = target;
+    remaining_frames = ramp_frames;
+    elapsed_frames = 0;
+    const auto frames = static_cast<double>(ramp_frames);
+
+    switch (configuration.curve) {
+    case Ramp_curve::exponential:
+        if ((current > 0.f && target > 0.f) || (current < 0.f && target < 0.f)) {
+            geometric = true;
+            offset = 0.f;
+            scale = current;
+            ratio = std::pow(static_cast<double>(target) / current, 1. / frames);
+            return;
+        }
+        break;
+    case Ramp_curve::one_pole:
+        geometric = true;
+        offset = target;
+        scale = current - target;
+        ratio = std::pow(static_cast<double>(one_pole_settled), 1. / frames);
+        return;
+    case Ramp_curve::linear:
+        break;
+    }
+
+    geometric = false;
+    start = current;
+    step = static_cast<float>((static_cast<double>(target) - current) / frames);
+}
+
+void Parameter_ramp::render(float* out, uint32_t frame_count)
+{
+    if (!is_ramping()) {
+        fill_constant(out, frame_count, current);
+        return;
+    }
+
+    // Sample `i` of the ramp holds the value `i + 1` frames in.  Rounding leaves that a little
+    // short of the target at the end of the ramp, so the last sample is the target itself.
+    const auto ramp_frames = std::min(frame_count, remaining_frames);
+    if (geometric) {
+        fill_geometric(out, ramp_frames, offset, scale, ratio, elapsed_frames + 1);
+    } else {
+        fill_linear(out, ramp_frames, start, step, elapsed_frames + 1);
+    }
+    advance(ramp_frames);
+    if (!is_ramping()) {
+        out[ramp_frames - 1] = current;
+    }
+    if (ramp_frames < frame_count) {
+        fill_constant(out + ramp_frames, frame_count - ramp_frames, current);
+    }
+}
+
+void Parameter_ramp::advance(uint32_t frame_count)
+{
+    if (!is_ramping()) {
+        return;
+    }
+    if (frame_count >= remaining_frames) {
+        reset(target_);
+        return;
+    }
+    remaining_frames -= frame_count;
+    elapsed_frames += frame_count;
+    current = geometric
+        ? offset + scale * static_cast<float>(std::pow(ratio, static_cast<double>(elapsed_frames)))
+        : start + step * static_cast<float>(elapsed_frames);
+}
+
+Parameter_ramp_set::Parameter_ramp_set(const std::vector<Parameter>& parameters,
+                                       uint32_t max_frames_)
+    : max_frames(max_frames_)
+    , buffers(parameters.size() * max_frames_)
+    , rendered_frames(parameters.size())
+{
+    for (const auto& parameter : parameters) {
+        address_index.emplace_back(parameter.address, ramps.size());
+        ramps.emplace_back(parameter.configuration, parameter.initial_value);
+    }
+    std::sort(begin(address_index), end(address_index));
+}
+
+size_t Parameter_ramp_set::index_of(uint64_t address) const
+{
+    auto it = std::lower_bound(begin(address_index),
+                               end(address_index),
+                               address,
+                               [](const auto& entry, uint64_t a) { return entry.first < a; });
+    if (it == end(address_index) || it->first != address) {
+        return ramps.size();
+    }
+    return it->second;
+}
+
+bool Parameter_ramp_set::contains(uint64_t address) const
+{
+    return index_of(address) != ramps.size();
+}
+
+void Parameter_ramp_set::process(Audio_event_span events, uint32_t frame_count)
+{
+    if (frame_count > max_frames) {
+        throw std::invalid_argument("Parameter_ramp_set: block is larger than max_frames");
+    }
+    std::fill(begin(rendered_frames), end(rendered_frames), 0u);
+    auto render_until = [&](size_t index, int64_t time) {
+        const auto until = static_cast<uint32_t>(std::clamp<int64_t>(time, 0, frame_count));
+        if (until > rendered_frames[index]) {
+            ramps[index].render(buffers.data() + index * max_frames + rendered_frames[index],
+                                until - rendered_frames[index]);
+            rendered_frames[index] = until;
+        }
+    };
+
+    for (size_t event_index = 0; event_index < events.size(); ++event_index) {
+        std::visit(
+            overload {[&](const Parameter_change& change) {
+                          const auto index = index_of(change.address);
+                          if (index == ramps.size()) {
+                              return;
+                          }
+                          render_until(index, change.buffer_offset_time);
+
+                          // Hosts send a ramp as its start value followed by the ramp itself;
+                          // the start value shouldn't be smoothed.
+                          const auto next = event_index + 1 < events.size()
+                              ? std::get_if<Ramped_parameter_change>(&events[event_index + 1])
+                              : nullptr;
+                          if (next && next->address == change.address
+                              && next->buffer_offset_time == change.buffer_offset_time) {
+                              ramps[index].reset(change.value);
+                          } else {
+                              ramps[index].jump_to(change.value);
+                          }
+                      },
+                      [&](const Ramped_parameter_change& change) {
+                          const auto index = index_of(change.address);
+                          if (index == ramps.size()) {
+                              return;
+                          }
+                          render_until(index, change.buffer_offset_time);
+                          ramps[index].ramp_to(change.value, change.ramp_length);
+                      },
+                      [](const Midi_message&) {},
+                      [](const Midi_packet&) {}},
+            events[event_index]);
+    }
+
+    for (size_t index = 0; index < ramps.size(); ++index) {
+        render_until(index, frame_count);
+    }
+}
+
+void Parameter_ramp_set::set_parameter(uint64_t address, float value)
+{
+    const auto index = index_of(address);
+    if (index != ramps.size()) {
+        ramps[index].jump_to(value);
+    }
+}
+
+const float* Parameter_ramp_set::buffer(uint64_t address) const
+{
+    const auto index = index_of(address);
+    if (index == ramps.size()) {
+        throw std::out_of_range("Parameter_ramp_set: unknown parameter address");
+    }
+    return buffers.data() + index * max_frames;
+}
+
+float Parameter_ramp_set::value(uint64_t address) const
+{
+    const auto index = index_of(address);
+    if (index == ramps.size()) {
+        throw std::out_of_range("Parameter_ramp_set: unknown parameter address");
+    }
+    return ramps[index].value();
+}
+
+float Parameter_ramp_set::target(uint64_t address) const
+{
+    const auto index = index_of(address);
+    if (index == ramps.size()) {
+        throw std::out_of_range("Parameter_ramp_set: unknown parameter address");
+    }
+    return ramps[index].target();
+}
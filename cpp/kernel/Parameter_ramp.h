@@ -0,0 +1,117 @@
+#pragma once
+#include "Brinicle/Kernel/Audio_event.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Brinicle {
+
+enum class Ramp_curve {
+    /// Straight line from the current value to the target.
+    linear,
+
+    /// Constant ratio per frame from the current value to the target.  Falls back to linear
+    /// when the two aren't both non-zero with the same sign.
+    exponential,
+
+    /// Exponential approach to the target, like a one-pole lowpass on the parameter.  The
+    /// ramp length is the time to get within 80dB of the target.
+    one_pole,
+};
+
+/// Smooths a single parameter, rendering its value as a control signal.
+///
+/// Each ramp segment is rendered in closed form, so there's no per-sample branching, and the
+/// inner loops are simple enough for the compiler to vectorize.
+class Parameter_ramp {
+public:
+    struct Configuration {
+        Ramp_curve curve;
+
+        /// Jumps (un-ramped parameter changes) are smoothed over this many frames.  Zero
+        /// means jumps take effect immediately.
+        uint32_t smoothing_frames;
+    };
+
+    Parameter_ramp(Configuration configuration, float initial_value);
+
+    /// Start moving towards `target`, arriving `ramp_frames` frames from now.
+    void ramp_to(float target, uint32_t ramp_frames);
+
+    /// Move towards `target` over the configured smoothing time.
+    void jump_to(float target) { ramp_to(target, configuration.smoothing_frames); }
+
+    /// Set the value immediately, cancelling any ramp in progress.
+    void reset(float value);
+
+    /// Write the next `frame_count` values to `out`.
+    void render(float* out, uint32_t frame_count);
+
+    /// Skip ahead `frame_count` frames without rendering them.
+    void advance(uint32_t frame_count);
+
+    float value() const { return current; }
+    float target() const { return target_; }
+    bool is_ramping() const { return remaining_frames != 0; }
+
+private:
+    Configuration configuration;
+    float current;
+    float target_;
+    uint32_t remaining_frames = 0;
+    uint32_t elapsed_frames = 0;
+
+    // Segments are rendered as either `start + step * i`, or `offset + scale * ratio^i`.
+    bool geometric = false;
+    float start = 0.f;
+    float step = 0.f;
+    float offset = 0.f;
+    float scale = 0.f;
+    double ratio = 1.;
+};
+
+/// Smooths a set of parameters of a kernel.  Each block, pass the block's events to `process`
+/// and read back either an audio-rate control buffer or a block-rate value for each
+/// parameter.  All buffers are allocated up front.
+class Parameter_ramp_set {
+public:
+    struct Parameter {
+        uint64_t address;
+        Parameter_ramp::Configuration configuration;
+        float initial_value;
+    };
+
+    Parameter_ramp_set(const std::vector<Parameter>& parameters, uint32_t max_frames);
+
+    /// Render this block's control buffers, applying any parameter changes in `events`
+    /// at their times.  Events for other parameters are ignored.  Throws
+    /// `std::invalid_argument` if `frame_count` is more than the constructor's `max_frames`.
+    void process(Audio_event_span events, uint32_t frame_count);
+
+    /// Apply a change from outside the event stream, e.g. `Kernel::set_parameter`.  This is
+    /// smoothed like an event at the start of the next block.
+    void set_parameter(uint64_t address, float value);
+
+    bool contains(uint64_t address) const;
+
+    /// The audio-rate control signal for the last processed block.
+    const float* buffer(uint64_t address) const;
+
+    /// The value at the end of the last processed block, for block-rate use.
+    float value(uint64_t address) const;
+
+    /// The value the parameter is heading to.
+    float target(uint64_t address) const;
+
+private:
+    size_t index_of(uint64_t address) const;
+
+    uint32_t max_frames;
+    std::vector<Parameter_ramp> ramps;
+    // (address, index) pairs, sorted by address.
+    std::vector<std::pair<uint64_t, size_t>> address_index;
+    std::vector<float> buffers;
+    std::vector<uint32_t> rendered_frames;
+};
+
+}
@@ -0,0 +1,142 @@
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+constexpr uint64_t fnv_offset_basis = 0xcbf29ce484222325ull;
+constexpr uint64_t fnv_prime = 0x100000001b3ull;
+
+// Fibonacci hashing: spreads sequential addresses across the table.
+constexpr uint64_t golden_ratio = 0x9e3779b97f4a7c15ull;
+}
+
+uint64_t Brinicle::hash_identifier(std::string_view identifier)
+{
+    auto hash = fnv_offset_basis;
+    for (auto c : identifier) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+
+Parameter_registry::Parameter_registry(std::vector<Parameter_info> parameters)
+    : parameters_(std::move(parameters))
+{
+    if (parameters_.size() >= empty) {
+        throw std::length_error("Parameter_registry: too many parameters");
+    }
+    size_t capacity = 2;
+    int bits = 1;
+    while (capacity < 2 * parameters_.size()) {
+        capacity *= 2;
+        ++bits;
+    }
+    shift = 64 - bits;
+    address_table.assign(capacity, Slot {0, empty});
+    identifier_table.assign(capacity, Slot {0, empty});
+
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        if (index_of(parameters_[index].address) != npos) {
+            throw std::logic_error("Parameter_registry: two parameters have the same address");
+        }
+        if (index_of(parameters_[index].identifier_string) != npos) {
+            throw std::logic_error(
+                "Parameter_registry: two parameters have the same identifier");
+        }
+        insert(address_table, parameters_[index].address, index);
+        insert(identifier_table, hash_identifier(parameters_[index].identifier_string), index);
+    }
+}
+
+size_t Parameter_registry::first_slot(uint64_t key) const
+{
+    return static_cast<size_t>((key * golden_ratio) >> shift);
+}
+
+void Parameter_registry::insert(std::vector<Slot>& table, uint64_t key, size_t index)
+{
+    const auto mask = table.size() - 1;
+    auto slot = first_slot(key);
+    while (table[slot].index != empty) {
+        slot = (slot + 1) & mask;
+    }
+    table[slot] = Slot {key, static_cast<uint32_t>(index)};
+}
+
+size_t Parameter_registry::index_of(uint64_t address) const
+{
+    const auto mask = address_table.size() - 1;
+    for (auto slot = first_slot(address); address_table[slot].index != empty;
+         slot = (slot + 1) & mask) {
+        if (address_table[slot].key == address) {
+            return address_table[slot].index;
+        }
+    }
+    return npos;
+}
+
+size_t Parameter_registry::index_of(std::string_view identifier) const
+{
+    const auto hash = hash_identifier(identifier);
+    const auto mask = identifier_table.size() - 1;
+    for (auto slot = first_slot(hash); identifier_table[slot].index != empty;
+         slot = (slot + 1) & mask) {
+        // Different identifiers may share a hash, so check the string too.
+        const auto& found = identifier_table[slot];
+        if (found.key == hash && parameters_[found.index].identifier_string == identifier) {
+            return found.index;
+        }
+    }
+    return npos;
+}
+
+Dense_parameter_state Parameter_registry::default_state() const
+{
+    auto get_default = [](const auto& info) -> float { return info.default_value; };
+
+    Dense_parameter_state ret(parameters_.size());
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        ret[index] = std::visit(get_default, parameters_[index].info);
+    }
+    return ret;
+}
+
+Dense_parameter_state Parameter_registry::get_state(const Parameter_set& parameter_set) const
+{
+    Dense_parameter_state ret(parameters_.size());
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        ret[index] = parameter_set.get_parameter(parameters_[index].address);
+    }
+    return ret;
+}
+
+void Parameter_registry::set_state(Parameter_set& parameter_set,
+                                   const Dense_parameter_state& state) const
+{
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        parameter_set.set_parameter(parameters_[index].address, state[index]);
+    }
+}
+
+Dense_parameter_state Parameter_registry::from_parameter_state(const Parameter_state& state) const
+{
+    auto ret = default_state();
+    for (const auto& [address, value] : state) {
+        const auto index = index_of(address);
+        if (index != npos) {
+            ret[index] = value;
+        }
+    }
+    return ret;
+}
+
+Parameter_state Parameter_registry::to_parameter_state(const Dense_parameter_state& state) const
+{
+    Parameter_state ret;
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        ret[parameters_[index].address] = state[index];
+    }
+    return ret;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Brinicle/Kernel/Parameter.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Brinicle {
+
+/// 64-bit FNV-1a hash of a parameter's `identifier_string`.
+uint64_t hash_identifier(std::string_view identifier);
+
+/// Maps parameter addresses and identifiers to dense indices, in the order of the
+/// `Parameter_info` list, so parameters can be stored in plain arrays.
+///
+/// Lookups are open-addressed hash tables at most half full, so they take constant time and
+/// never allocate.  Build one once, when the parameters are known; `KernelFactory` keeps one
+/// for its `info().parameters`.
+class Parameter_registry {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit Parameter_registry(std::vector<Parameter_info> parameters);
+
+    size_t size() const { return parameters_.size(); }
+    const std::vector<Parameter_info>& parameters() const { return parameters_; }
+
+    /// `npos` if there's no parameter at `address`.
+    size_t index_of(uint64_t address) const;
+
+    /// `npos` if no parameter has this `identifier_string`.
+    size_t index_of(std::string_view identifier) const;
+
+    const Parameter_info& info(size_t index) const { return parameters_[index]; }
+    uint64_t address(size_t index) const { return parameters_[index].address; }
+    const std::string& identifier(size_t index) const
+    {
+        return parameters_[index].identifier_string;
+    }
+
+    Dense_parameter_state default_state() const;
+    Dense_parameter_state get_state(const Parameter_set& parameter_set) const;
+    void set_state(Parameter_set& parameter_set, const Dense_parameter_state& state) const;
+
+    /// Parameters missing from `state` keep their default values, and unknown addresses are
+    /// ignored.
+    Dense_parameter_state from_parameter_state(const Parameter_state& state) const;
+    Parameter_state to_parameter_state(const Dense_parameter_state& state) const;
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t index;
+    };
+    static constexpr uint32_t empty = static_cast<uint32_t>(-1);
+
+    size_t first_slot(uint64_t key) const;
+    void insert(std::vector<Slot>& table, uint64_t key, size_t index);
+
+    std::vector<Parameter_info> parameters_;
+
+    // Keyed by address, and by identifier hash; the same size, a power of two.
+    std::vector<Slot> address_table;
+    std::vector<Slot> identifier_table;
+    int shift;
+};
+
+}
@@ -0,0 +1,97 @@
+#include "Brinicle/Kernel/Preset.h"
+#include "Brinicle/Kernel/Little_endian.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Brinicle;
+using namespace Brinicle::Little_endian;
+
+namespace {
+constexpr uint8_t preset_magic[4] = {'B', 'R', 'P', 'S'};
+}
+
+std::optional<Preset_view> Preset_view::parse(const void* data, size_t size)
+{
+    const auto bytes = static_cast<const uint8_t*>(data);
+    if (size < header_size || std::memcmp(bytes, preset_magic, sizeof(preset_magic)) != 0
+        || read_u16(bytes + 4) != version) {
+        return std::nullopt;
+    }
+    const size_t count = read_u32(bytes + 8);
+    if (byte_size(count) > size) {
+        return std::nullopt;
+    }
+    const auto hashes = bytes + header_size;
+    return Preset_view(hashes, hashes + count * sizeof(uint64_t), count);
+}
+
+uint64_t Preset_view::identifier_hash(size_t index) const
+{
+    return read_u64(hashes + index * sizeof(uint64_t));
+}
+
+float Preset_view::value(size_t index) const
+{
+    const auto bits = read_u32(values + index * sizeof(float));
+    float ret;
+    std::memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
+
+Preset_codec::Preset_codec(const std::vector<Parameter_info>& parameters_)
+{
+    for (size_t index = 0; index < parameters_.size(); ++index) {
+        parameters.push_back(Entry {hash_identifier(parameters_[index].identifier_string),
+                                    parameters_[index].address,
+                                    index});
+    }
+    std::sort(begin(parameters), end(parameters), [](const Entry& a, const Entry& b) {
+        return a.hash < b.hash;
+    });
+    const auto collision = std::adjacent_find(
+        begin(parameters), end(parameters), [](const Entry& a, const Entry& b) {
+            return a.hash == b.hash;
+        });
+    if (collision != end(parameters)) {
+        throw std::logic_error("Preset_codec: two parameter identifiers have the same hash");
+    }
+}
+
+std::vector<uint8_t> Preset_codec::serialize(const Parameter_state& state) const
+{
+    std::vector<std::pair<uint64_t, float>> entries;
+    for (const auto& parameter : parameters) {
+        const auto found = state.find(parameter.address);
+        if (found != end(state)) {
+            entries.emplace_back(parameter.hash, found->second);
+        }
+    }
+    return write(entries);
+}
+
+std::vector<uint8_t> Preset_codec::serialize(const Dense_parameter_state& state) const
+{
+    std::vector<std::pair<uint64_t, float>> entries;
+    for (const auto& parameter : parameters) {
+        entries.emplace_back(parameter.hash, state[parameter.index]);
+    }
+    return write(entries);
+}
+
+std::vector<uint8_t> Preset_codec::write(const std::vector<std::pair<uint64_t, float>>& entries)
+{
+    std::vector<uint8_t> ret(Preset_view::byte_size(entries.size()));
+    std::memcpy(ret.data(), preset_magic, sizeof(preset_magic));
+    write_u16(ret.data() + 4, Preset_view::version);
+    write_u32(ret.data() + 8, static_cast<uint32_t>(entries.size()));
+    auto hashes = ret.data() + Preset_view::header_size;
+    auto values = hashes + entries.size() * sizeof(uint64_t);
+    for (size_t index = 0; index < entries.size(); ++index) {
+        write_u64(hashes + index * sizeof(uint64_t), entries[index].first);
+        uint32_t bits;
+        std::memcpy(&bits, &entries[index].second, sizeof(bits));
+        write_u32(values + index * sizeof(float), bits);
+    }
+    return ret;
+}
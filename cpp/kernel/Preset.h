@@ -0,0 +1,123 @@
+#pragma once
+#include "Brinicle/Kernel/Parameter.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Brinicle {
+
+/// A preset in brinicle's compact binary format, which doesn't own its memory.
+///
+/// Presets identify parameters by `hash_identifier`, so they don't depend on addresses and
+/// don't need to store strings.  The format is a 16-byte header (magic `"BRPS"`, a version,
+/// and a parameter count), then that many identifier hashes in increasing order, then the
+/// same number of float values in the same order, all little-endian.  Presets start on 8-byte
+/// boundaries in preset banks, but may be anywhere in memory.
+class Preset_view {
+public:
+    static constexpr size_t header_size = 16;
+    static constexpr uint16_t version = 1;
+
+    /// Checks the header and size, but not the values; returns `std::nullopt` if `data` isn't a
+    /// preset in a version we can read.  Takes constant time, and doesn't allocate.
+    static std::optional<Preset_view> parse(const void* data, size_t size);
+
+    /// Bytes taken by a preset of `parameter_count` parameters.
+    static size_t byte_size(size_t parameter_count)
+    {
+        return header_size + parameter_count * (sizeof(uint64_t) + sizeof(float));
+    }
+
+    size_t size() const { return size_; }
+    uint64_t identifier_hash(size_t index) const;
+    float value(size_t index) const;
+
+private:
+    Preset_view(const uint8_t* hashes_, const uint8_t* values_, size_t size)
+        : hashes(hashes_), values(values_), size_(size)
+    {
+    }
+
+    const uint8_t* hashes;
+    const uint8_t* values;
+    size_t size_;
+};
+
+/// Converts between parameter states and binary presets for one set of parameters.
+///
+/// Build this once, when the parameters are known; reading a preset then just walks the
+/// preset and our parameters, both sorted by hash, side by side.  Throws `std::logic_error` if
+/// two identifiers hash to the same value.
+class Preset_codec {
+public:
+    explicit Preset_codec(const std::vector<Parameter_info>& parameters);
+
+    /// Writes the parameters in `state`; any that are missing from it are left out.
+    std::vector<uint8_t> serialize(const Parameter_state& state) const;
+
+    /// Writes every parameter; `state` is in the order of the `Parameter_info` list.
+    std::vector<uint8_t> serialize(const Dense_parameter_state& state) const;
+
+    /// Calls `f(address, value)` for each parameter that is in both the preset and our set, in
+    /// hash order.  Presets saved by other versions of a plugin may have parameters we don't,
+    /// which are skipped, or be missing some of ours.
+    template <typename F> void read(const Preset_view& preset, F f) const
+    {
+        walk(preset, [&](const Entry& entry, float value) { f(entry.address, value); });
+    }
+
+    /// As `read`, but calls `f(index, value)` with the index in the `Parameter_info` list.
+    template <typename F> void read_indexed(const Preset_view& preset, F f) const
+    {
+        walk(preset, [&](const Entry& entry, float value) { f(entry.index, value); });
+    }
+
+    /// Overwrites the entries of `state` for the parameters in `preset`.  Doesn't allocate if
+    /// `state` already has an entry for each of our parameters.
+    void apply(const Preset_view& preset, Parameter_state& state) const
+    {
+        read(preset, [&](uint64_t address, float value) { state[address] = value; });
+    }
+
+    /// Overwrites the values in `state` for the parameters in `preset`.  Never allocates.
+    void apply(const Preset_view& preset, Dense_parameter_state& state) const
+    {
+        read_indexed(preset, [&](size_t index, float value) { state[index] = value; });
+    }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint64_t address;
+        size_t index;
+    };
+
+    template <typename F> void walk(const Preset_view& preset, F f) const
+    {
+        size_t ours = 0;
+        size_t theirs = 0;
+        while (ours < parameters.size() && theirs < preset.size()) {
+            const auto hash = preset.identifier_hash(theirs);
+            if (parameters[ours].hash < hash) {
+                ++ours;
+            } else if (hash < parameters[ours].hash) {
+                ++theirs;
+            } else {
+                f(parameters[ours], preset.value(theirs));
+                ++ours;
+                ++theirs;
+            }
+        }
+    }
+
+    static std::vector<uint8_t> write(const std::vector<std::pair<uint64_t, float>>& entries);
+
+    // Sorted by hash.
+    std::vector<Entry> parameters;
+};
+
+}
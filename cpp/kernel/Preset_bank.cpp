@@ -0,0 +1,143 @@
+#include "Brinicle/Kernel/Preset_bank.h"
+#include "Brinicle/Kernel/Little_endian.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Brinicle;
+using namespace Brinicle::Little_endian;
+
+namespace {
+constexpr uint8_t bank_magic[4] = {'B', 'R', 'P', 'B'};
+constexpr size_t preset_alignment = 8;
+}
+
+static std::runtime_error file_error(const std::string& path, const std::string& what)
+{
+    return std::runtime_error(path + ": " + what);
+}
+
+static bool in_bounds(uint64_t offset, uint64_t size, size_t total)
+{
+    return offset <= total && size <= total - offset;
+}
+
+Preset_bank::Preset_bank(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw file_error(path, std::strerror(errno));
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        const auto error = errno;
+        close(fd);
+        throw file_error(path, std::strerror(error));
+    }
+    mapping_size = static_cast<size_t>(status.st_size);
+    if (mapping_size < header_size) {
+        close(fd);
+        throw file_error(path, "not a preset bank");
+    }
+    void* address = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto error = errno;
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw file_error(path, std::strerror(error));
+    }
+    mapping = static_cast<const uint8_t*>(address);
+
+    try {
+        if (std::memcmp(mapping, bank_magic, sizeof(bank_magic)) != 0
+            || read_u16(mapping + 4) != version) {
+            throw file_error(path, "not a preset bank, or from a newer version");
+        }
+        size_ = read_u32(mapping + 8);
+        if (!in_bounds(header_size, uint64_t(size_) * entry_size, mapping_size)) {
+            throw file_error(path, "truncated preset table");
+        }
+        // Just the bounds and preset headers; the presets themselves are only read when used.
+        for (size_t index = 0; index < size_; ++index) {
+            const auto found = entry(index);
+            if (!in_bounds(found.name_offset, found.name_size, mapping_size)
+                || !in_bounds(found.preset_offset, found.preset_size, mapping_size)
+                || !Preset_view::parse(mapping + found.preset_offset, found.preset_size)) {
+                throw file_error(path, "bad preset " + std::to_string(index));
+            }
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(mapping), mapping_size);
+        throw;
+    }
+}
+
+Preset_bank::~Preset_bank() { munmap(const_cast<uint8_t*>(mapping), mapping_size); }
+
+Preset_bank::Entry Preset_bank::entry(size_t index) const
+{
+    const auto data = mapping + header_size + index * entry_size;
+    return Entry {read_u64(data), read_u64(data + 8), read_u32(data + 16), read_u32(data + 20)};
+}
+
+std::string_view Preset_bank::name(size_t index) const
+{
+    if (index >= size_) {
+        throw std::out_of_range("Preset_bank: no such preset");
+    }
+    const auto found = entry(index);
+    return std::string_view(reinterpret_cast<const char*>(mapping + found.name_offset),
+                            found.name_size);
+}
+
+Preset_view Preset_bank::preset(size_t index) const
+{
+    if (index >= size_) {
+        throw std::out_of_range("Preset_bank: no such preset");
+    }
+    const auto found = entry(index);
+    // Checked when the bank was opened.
+    return *Preset_view::parse(mapping + found.preset_offset, found.preset_size);
+}
+
+void Preset_bank_writer::add(std::string name, std::vector<uint8_t> preset)
+{
+    presets.emplace_back(std::move(name), std::move(preset));
+}
+
+void Preset_bank_writer::write(const std::string& path) const
+{
+    // Header, then the table, then each preset (aligned) followed by its name.
+    std::vector<uint8_t> data(Preset_bank::header_size + presets.size() * Preset_bank::entry_size);
+    std::memcpy(data.data(), bank_magic, sizeof(bank_magic));
+    write_u16(data.data() + 4, Preset_bank::version);
+    write_u32(data.data() + 8, static_cast<uint32_t>(presets.size()));
+    for (size_t index = 0; index < presets.size(); ++index) {
+        const auto& [name, preset] = presets[index];
+        data.resize((data.size() + preset_alignment - 1) / preset_alignment * preset_alignment);
+        const auto preset_offset = data.size();
+        data.insert(end(data), begin(preset), end(preset));
+        const auto name_offset = data.size();
+        data.insert(end(data), begin(name), end(name));
+
+        const auto table_entry = data.data() + Preset_bank::header_size
+            + index * Preset_bank::entry_size;
+        write_u64(table_entry, name_offset);
+        write_u64(table_entry + 8, preset_offset);
+        write_u32(table_entry + 16, static_cast<uint32_t>(name.size()));
+        write_u32(table_entry + 20, static_cast<uint32_t>(preset.size()));
+    }
+
+    auto file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw file_error(path, std::strerror(errno));
+    }
+    const auto written = std::fwrite(data.data(), 1, data.size(), file);
+    if (std::fclose(file) != 0 || written != data.size()) {
+        throw file_error(path, "couldn't write preset bank");
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Brinicle/Kernel/Preset.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Brinicle {
+
+/// A read-only file of named presets, memory-mapped so that browsing the names in a bank of
+/// thousands of presets and applying one doesn't parse, copy or allocate anything.
+///
+/// The file is a 16-byte header (magic `"BRPB"`, a version and a preset count), then a table
+/// of 24-byte entries, each holding the offset of the preset's name, the offset of the preset
+/// (see `Preset_view`), and their sizes.  Opening the bank checks that the table and every
+/// preset header lie within the file, and throws `std::runtime_error` if not.
+class Preset_bank {
+public:
+    static constexpr size_t header_size = 16;
+    static constexpr size_t entry_size = 24;
+    static constexpr uint16_t version = 1;
+
+    explicit Preset_bank(const std::string& path);
+    ~Preset_bank();
+
+    Preset_bank(const Preset_bank&) = delete;
+    Preset_bank& operator=(const Preset_bank&) = delete;
+
+    size_t size() const { return size_; }
+
+    /// UTF-8.  Throws `std::out_of_range` if `index` isn't less than `size()`.
+    std::string_view name(size_t index) const;
+
+    /// Throws `std::out_of_range` if `index` isn't less than `size()`.
+    Preset_view preset(size_t index) const;
+
+private:
+    struct Entry {
+        uint64_t name_offset;
+        uint64_t preset_offset;
+        uint32_t name_size;
+        uint32_t preset_size;
+    };
+
+    Entry entry(size_t index) const;
+
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    size_t size_ = 0;
+};
+
+/// Collects presets, and writes them out as a file `Preset_bank` can read.
+class Preset_bank_writer {
+public:
+    void add(std::string name, std::vector<uint8_t> preset);
+
+    /// Throws `std::runtime_error` if the file can't be written.
+    void write(const std::string& path) const;
+
+private:
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> presets;
+};
+
+}
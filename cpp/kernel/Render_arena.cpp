@@ -0,0 +1,66 @@
+#include "Brinicle/Kernel/Render_arena.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace Brinicle;
+
+static size_t round_up(size_t size, size_t multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+size_t Render_arena::Layout::reserve(size_t size)
+{
+    const auto offset = size_;
+    size_ += round_up(size, alignment);
+    return offset;
+}
+
+Render_arena::Bytes Render_arena::Layout::reserve_bytes(size_t size)
+{
+    return Bytes {reserve(size), size};
+}
+
+Render_arena::Channels Render_arena::Layout::reserve_channels(uint32_t channel_count,
+                                                              uint32_t frame_count)
+{
+    const auto stride = round_up(frame_count * sizeof(float), alignment);
+    return Channels {reserve(stride * channel_count), stride, channel_count, frame_count};
+}
+
+Render_arena::~Render_arena() { clear(); }
+
+void Render_arena::allocate(const Layout& layout, bool lock_memory)
+{
+    clear();
+    if (layout.size() == 0) {
+        return;
+    }
+
+    // Whole pages, so locking doesn't pin our neighbours' memory too.
+    const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const auto size = round_up(layout.size(), page_size);
+    void* memory = nullptr;
+    if (posix_memalign(&memory, page_size, size) != 0) {
+        throw std::bad_alloc();
+    }
+    base = static_cast<uint8_t*>(memory);
+    size_ = size;
+
+    std::memset(base, 0, size_);
+    locked_ = lock_memory && mlock(base, size_) == 0;
+}
+
+void Render_arena::clear()
+{
+    if (locked_) {
+        munlock(base, size_);
+    }
+    std::free(base);
+    base = nullptr;
+    size_ = 0;
+    locked_ = false;
+}
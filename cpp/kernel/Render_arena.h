@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Set to 1 to have render arenas `mlock` their memory by default, so it can't be paged out.
+#ifndef BRINICLE_LOCK_RENDER_MEMORY
+#define BRINICLE_LOCK_RENDER_MEMORY 0
+#endif
+
+namespace Brinicle {
+
+/// A single allocation holding all of an instance's render scratch memory.
+///
+/// Regions are reserved in a `Layout` up front, then the whole arena is allocated at once,
+/// when the host initializes us.  The memory is zeroed, which also faults in every page, so
+/// the first render doesn't page fault, and every region starts on a cache line, so kernels
+/// can use aligned vector loads on each channel.
+class Render_arena {
+public:
+    static constexpr size_t alignment = 64;
+
+    /// Raw bytes, e.g. for an `AudioBufferList`.
+    struct Bytes {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    /// `channel_count` buffers of `frame_count` floats each.  Each one is `alignment`-aligned.
+    struct Channels {
+        size_t offset = 0;
+        size_t stride = 0;
+        uint32_t channel_count = 0;
+        uint32_t frame_count = 0;
+    };
+
+    class Layout {
+    public:
+        Bytes reserve_bytes(size_t size);
+        Channels reserve_channels(uint32_t channel_count, uint32_t frame_count);
+
+        size_t size() const { return size_; }
+
+    private:
+        size_t reserve(size_t size);
+
+        size_t size_ = 0;
+    };
+
+    Render_arena() = default;
+    ~Render_arena();
+
+    Render_arena(const Render_arena&) = delete;
+    Render_arena& operator=(const Render_arena&) = delete;
+
+    /// Frees any previous allocation, invalidating pointers into it, and allocates `layout`.
+    /// If `lock_memory` is set, this also tries to `mlock` it; see `locked`.  Throws
+    /// `std::bad_alloc` if the allocation fails.
+    void allocate(const Layout& layout, bool lock_memory = BRINICLE_LOCK_RENDER_MEMORY);
+
+    void clear();
+
+    void* bytes(Bytes region) const { return base + region.offset; }
+
+    template <typename T> T* as(Bytes region) const { return reinterpret_cast<T*>(bytes(region)); }
+
+    float* channel(Channels region, uint32_t index) const
+    {
+        return reinterpret_cast<float*>(base + region.offset + region.stride * index);
+    }
+
+    size_t size() const { return size_; }
+
+    /// True if the memory was successfully locked.  Locking can fail if it would go over the
+    /// process's limit, in which case the arena works as usual, but may be paged out.
+    bool locked() const { return locked_; }
+
+private:
+    uint8_t* base = nullptr;
+    size_t size_ = 0;
+    bool locked_ = false;
+};
+
+}
@@ -0,0 +1,104 @@
+#include "Brinicle/Kernel/Sub_block_kernel.h"
+#include <algorithm>
+
+using namespace Brinicle;
+
+namespace {
+class Sub_block_kernel : public Kernel {
+public:
+    Sub_block_kernel(std::unique_ptr<Kernel> inner_,
+                     Sub_block_scheduler::Configuration configuration,
+                     size_t max_channels,
+                     std::shared_ptr<Sub_block_statistics> statistics_)
+        : inner(std::move(inner_))
+        , scheduler(configuration, max_channels)
+        , statistics(std::move(statistics_))
+    {
+    }
+
+    void set_parameter(uint64_t address, float value) override
+    {
+        inner->set_parameter(address, value);
+    }
+
+    float get_parameter(uint64_t address) const override { return inner->get_parameter(address); }
+
+    void reset() override { inner->reset(); }
+
+    void process(Deinterleaved_audio audio, Audio_event_span events) override
+    {
+        const auto count = scheduler.run(
+            audio, events, [this](Deinterleaved_audio sub_block, Audio_event_span sub_events) {
+                inner->process(sub_block, sub_events);
+            });
+        if (statistics) {
+            statistics->blocks.fetch_add(1, std::memory_order_relaxed);
+            statistics->sub_blocks.fetch_add(count, std::memory_order_relaxed);
+            statistics->last_block_sub_blocks.store(count, std::memory_order_relaxed);
+            // Several kernels may share the statistics, so the max needs a CAS.
+            auto max = statistics->max_block_sub_blocks.load(std::memory_order_relaxed);
+            while (count > max
+                   && !statistics->max_block_sub_blocks.compare_exchange_weak(
+                       max, count, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    uint64_t get_latency() const override { return inner->get_latency(); }
+
+    bool reports_changes() const override { return inner->reports_changes(); }
+
+    bool take_changes(void* context, void (*changed)(void* context, uint64_t address)) override
+    {
+        return inner->take_changes(context, changed);
+    }
+
+private:
+    std::unique_ptr<Kernel> inner;
+    Sub_block_scheduler scheduler;
+    std::shared_ptr<Sub_block_statistics> statistics;
+};
+
+class Sub_block_kernel_factory : public KernelFactory {
+public:
+    Sub_block_kernel_factory(std::unique_ptr<KernelFactory> inner_,
+                             Sub_block_scheduler::Configuration configuration_,
+                             std::shared_ptr<Sub_block_statistics> statistics_)
+        : inner(std::move(inner_))
+        , configuration(configuration_)
+        , statistics(std::move(statistics_))
+    {
+    }
+
+    const Info& info() const override { return inner->info(); }
+
+    std::unique_ptr<Kernel> make_kernel(uint32_t input_channel_count,
+                                        uint32_t output_channel_count,
+                                        double sample_rate) const override
+    {
+        auto kernel = inner->make_kernel(input_channel_count, output_channel_count, sample_rate);
+        if (!kernel) {
+            return nullptr;
+        }
+        return std::make_unique<Sub_block_kernel>(std::move(kernel),
+                                                  configuration,
+                                                  std::max(input_channel_count,
+                                                           output_channel_count),
+                                                  statistics);
+    }
+
+private:
+    std::unique_ptr<KernelFactory> inner;
+    Sub_block_scheduler::Configuration configuration;
+    std::shared_ptr<Sub_block_statistics> statistics;
+};
+}
+
+std::unique_ptr<KernelFactory>
+Brinicle::make_sub_block_kernel_factory(std::unique_ptr<KernelFactory> factory,
+                                        Sub_block_scheduler::Configuration configuration,
+                                        std::shared_ptr<Sub_block_statistics> statistics)
+{
+    return std::make_unique<Sub_block_kernel_factory>(
+        std::move(factory), configuration, std::move(statistics));
+}
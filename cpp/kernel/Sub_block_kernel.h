@@ -0,0 +1,29 @@
+#pragma once
+#include "Brinicle/Kernel/KernelFactory.h"
+#include "Brinicle/Kernel/Sub_block_scheduler.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Brinicle {
+
+/// Running counts of how kernels split their blocks.  Written from the audio thread, safe to
+/// read from any thread.
+struct Sub_block_statistics {
+    std::atomic<uint64_t> blocks {0};
+    std::atomic<uint64_t> sub_blocks {0};
+    std::atomic<uint64_t> last_block_sub_blocks {0};
+    std::atomic<uint64_t> max_block_sub_blocks {0};
+};
+
+/// Wraps `factory` so that each kernel it makes only ever sees events at the start of its
+/// `process` calls - see `Sub_block_scheduler`.  This is opt-in per plugin: it trades extra
+/// `process` calls (and, with quantization, event timing precision) for simpler kernels.
+///
+/// If `statistics` is given, every kernel made by the factory adds to it.
+std::unique_ptr<KernelFactory>
+make_sub_block_kernel_factory(std::unique_ptr<KernelFactory> factory,
+                              Sub_block_scheduler::Configuration configuration,
+                              std::shared_ptr<Sub_block_statistics> statistics = nullptr);
+
+}
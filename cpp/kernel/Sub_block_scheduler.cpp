@@ -0,0 +1,13 @@
+#include "Brinicle/Kernel/Sub_block_scheduler.h"
+
+using namespace Brinicle;
+
+Sub_block_scheduler::Sub_block_scheduler(Configuration configuration,
+                                         size_t max_channels,
+                                         size_t max_events)
+    : configuration_(configuration), channels(max_channels)
+{
+    configuration_.grid_frames = std::max(configuration_.grid_frames, 1u);
+    configuration_.min_frames = std::max(configuration_.min_frames, 1u);
+    rebased.reserve(std::max<size_t>(max_events, 1));
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Brinicle/Kernel/Audio_event.h"
+#include "Brinicle/Kernel/Deinterleaved_audio.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Splits a block into sub-blocks at its event times, so that every event lands at the very
+/// start of a sub-block.  Each sub-block gets its own events, rebased to time 0.
+///
+/// To limit the fixed overhead of tiny sub-blocks, event times can be quantized: they are
+/// rounded down to a multiple of `grid_frames`, and a split less than `min_frames` after the
+/// previous one is merged into it (its events move earlier).  With the defaults, splitting is
+/// sample accurate.  Nothing here allocates after construction.
+class Sub_block_scheduler {
+public:
+    struct Configuration {
+        /// Zero is treated as one.
+        uint32_t grid_frames = 1;
+
+        /// The last sub-block of a block may still be shorter than this.
+        uint32_t min_frames = 1;
+    };
+
+    Sub_block_scheduler(Configuration configuration,
+                        size_t max_channels,
+                        size_t max_events = Audio_event_buffer::default_capacity);
+
+    const Configuration& configuration() const { return configuration_; }
+
+    /// Calls `process(Deinterleaved_audio, Audio_event_span)` for each sub-block, in order,
+    /// and returns how many sub-blocks there were.  A sub-block is only ever empty if
+    /// more than `max_events` events land on the same split.
+    template <typename Process>
+    size_t run(Deinterleaved_audio audio, Audio_event_span events, Process&& process)
+    {
+        size_t sub_block_count = 0;
+        auto emit = [&](size_t start, size_t frame_count) {
+            for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+                channels[channel] = audio.data[channel] + start;
+            }
+            process(Deinterleaved_audio {audio.channel_count, frame_count, channels.data()},
+                    Audio_event_span(rebased.data(), rebased.size(), events.payload()));
+            rebased.clear();
+            ++sub_block_count;
+        };
+
+        size_t start = 0;
+        size_t event_index = 0;
+        do {
+            while (event_index < events.size()
+                   && split_point(events[event_index], start, audio.frame_count) == start) {
+                if (rebased.size() == rebased.capacity()) {
+                    emit(start, 0);
+                }
+                rebased.push_back(events[event_index++]);
+                std::visit([](auto& event) { event.buffer_offset_time = 0; }, rebased.back());
+            }
+            const auto end = event_index < events.size()
+                ? split_point(events[event_index], start, audio.frame_count)
+                : audio.frame_count;
+            emit(start, end - start);
+            start = end;
+        } while (start < audio.frame_count);
+        return sub_block_count;
+    }
+
+private:
+    size_t split_point(const Audio_event& event, size_t start, size_t frame_count) const
+    {
+        // Events past the end of the block belong on its last frame.
+        const auto last_frame = static_cast<int64_t>(frame_count) - 1;
+        const auto time = static_cast<size_t>(std::clamp<int64_t>(
+            get_buffer_offset_time(event), 0, std::max<int64_t>(last_frame, 0)));
+        const auto quantized = time - time % configuration_.grid_frames;
+        return quantized < start + configuration_.min_frames ? start : quantized;
+    }
+
+    Configuration configuration_;
+    std::vector<float*> channels;
+    std::vector<Audio_event> rebased;
+};
+
+}
@@ -0,0 +1,273 @@
+#include "Brinicle/Kernel/Voice_engine.h"
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+namespace {
+constexpr uint8_t note_off_status = 0x80;
+constexpr uint8_t note_on_status = 0x90;
+constexpr uint8_t control_change_status = 0xB0;
+
+constexpr uint8_t sustain_controller = 64;
+constexpr uint8_t all_sound_off_controller = 120;
+constexpr uint8_t all_notes_off_controller = 123;
+}
+
+Voice_renderer::~Voice_renderer() {}
+
+Voice_engine::Voice_engine(Configuration configuration_,
+                           Voice_renderer& renderer_,
+                           size_t max_channels)
+    : configuration(configuration_)
+    , renderer(renderer_)
+    , channel_pointers(max_channels)
+    , held_slots(midi_channel_count * midi_note_count, no_slot)
+{
+    const auto width = configuration.lane_width;
+    if (width != 1 && width != 4 && width != 8 && width != 16) {
+        throw std::invalid_argument("Voice_engine: lane width must be 1, 4, 8 or 16");
+    }
+    if (configuration.max_voices == 0 || configuration.max_voices >= no_slot) {
+        throw std::invalid_argument("Voice_engine: bad voice count");
+    }
+    const auto slot_count = (configuration.max_voices + width - 1) / width * width;
+    channels.resize(slot_count);
+    note_numbers.resize(slot_count);
+    velocities.resize(slot_count);
+    start_orders.resize(slot_count);
+    released.resize(slot_count);
+    sustained.resize(slot_count);
+    levels.resize(slot_count);
+    finished.resize(slot_count);
+}
+
+void Voice_engine::process(Deinterleaved_audio audio, Audio_event_span events)
+{
+    if (audio.channel_count > channel_pointers.size()) {
+        throw std::invalid_argument("Voice_engine: more channels than it was made for");
+    }
+    Buffer_ops::clear(audio);
+
+    // Events past the end of the block are handled on its last frame.
+    const auto last_frame = static_cast<int64_t>(audio.frame_count) - 1;
+    size_t start = 0;
+    for (const auto& event : events) {
+        const auto* message = std::get_if<Midi_message>(&event);
+        if (!message) {
+            continue;
+        }
+        const auto time = static_cast<size_t>(std::clamp<int64_t>(
+            message->buffer_offset_time, 0, std::max<int64_t>(last_frame, 0)));
+        if (time > start) {
+            render(audio, start, time);
+            start = time;
+        }
+        handle_midi(*message);
+    }
+    if (start < audio.frame_count) {
+        render(audio, start, audio.frame_count);
+    }
+}
+
+void Voice_engine::handle_midi(const Midi_message& message)
+{
+    if (message.valid_bytes < 3) {
+        return;
+    }
+    const auto status = static_cast<uint8_t>(message.data[0] & 0xF0);
+    const auto channel = static_cast<uint8_t>(message.data[0] & 0x0F);
+    const auto data1 = static_cast<uint8_t>(message.data[1] & 0x7F);
+    const auto data2 = static_cast<uint8_t>(message.data[2] & 0x7F);
+    if (status == note_on_status && data2 != 0) {
+        note_on(Voice_note {channel, data1, data2});
+    } else if (status == note_off_status || status == note_on_status) {
+        note_off(channel, data1, data2);
+    } else if (status == control_change_status) {
+        if (data1 == sustain_controller) {
+            set_sustain(channel, data2 >= 64);
+        } else if (data1 == all_notes_off_controller) {
+            release_channel(channel);
+        } else if (data1 == all_sound_off_controller) {
+            stop_channel(channel);
+        }
+    }
+}
+
+void Voice_engine::reset()
+{
+    while (active_count) {
+        remove(active_count - 1);
+    }
+    sustain_pedals = {};
+}
+
+void Voice_engine::note_on(Voice_note note)
+{
+    const auto note_key = key(note.channel, note.note);
+    if (held_slots[note_key] != no_slot) {
+        release(held_slots[note_key], 0);
+    }
+
+    size_t slot;
+    bool stolen = false;
+    if (active_count < capacity()) {
+        slot = active_count++;
+    } else {
+        slot = choose_victim();
+        if (slot == no_slot) {
+            return;
+        }
+        forget_key(slot);
+        stolen = true;
+    }
+
+    channels[slot] = note.channel;
+    note_numbers[slot] = note.note;
+    velocities[slot] = note.velocity;
+    start_orders[slot] = next_start_order++;
+    released[slot] = 0;
+    sustained[slot] = 0;
+    levels[slot] = 0.f;
+    finished[slot] = 0;
+    held_slots[note_key] = static_cast<uint32_t>(slot);
+    renderer.start_voice(slot, note, stolen);
+}
+
+void Voice_engine::note_off(uint8_t channel, uint8_t note, uint8_t velocity)
+{
+    const auto slot = held_slots[key(channel, note)];
+    if (slot == no_slot || sustained[slot]) {
+        return;
+    }
+    if (sustain_pedals[channel]) {
+        // Keeps the key, so playing the note again restarts it.
+        sustained[slot] = 1;
+        return;
+    }
+    release(slot, velocity);
+}
+
+void Voice_engine::set_sustain(uint8_t channel, bool on)
+{
+    sustain_pedals[channel] = on;
+    if (on) {
+        return;
+    }
+    for (size_t slot = 0; slot < active_count; ++slot) {
+        if (sustained[slot] && channels[slot] == channel) {
+            release(slot, 0);
+        }
+    }
+}
+
+void Voice_engine::release_channel(uint8_t channel)
+{
+    for (size_t slot = 0; slot < active_count; ++slot) {
+        if (!released[slot] && channels[slot] == channel) {
+            release(slot, 0);
+        }
+    }
+}
+
+void Voice_engine::stop_channel(uint8_t channel)
+{
+    // Backwards, so each voice moved into a removed one's slot has already been looked at.
+    for (size_t slot = active_count; slot-- > 0;) {
+        if (channels[slot] == channel) {
+            remove(slot);
+        }
+    }
+}
+
+void Voice_engine::release(size_t slot, uint8_t velocity)
+{
+    forget_key(slot);
+    released[slot] = 1;
+    sustained[slot] = 0;
+    renderer.release_voice(slot, velocity);
+}
+
+size_t Voice_engine::choose_victim() const
+{
+    if (configuration.stealing == Voice_stealing::none) {
+        return no_slot;
+    }
+
+    // True if the voice in `a` should be stolen before the one in `b`.
+    auto before = [this](size_t a, size_t b) {
+        if (released[a] != released[b]) {
+            return released[a] > released[b];
+        }
+        switch (configuration.stealing) {
+        case Voice_stealing::quietest:
+            return levels[a] < levels[b];
+        case Voice_stealing::lowest_note:
+            return note_numbers[a] < note_numbers[b];
+        case Voice_stealing::highest_note:
+            return note_numbers[a] > note_numbers[b];
+        default:
+            return start_orders[a] < start_orders[b];
+        }
+    };
+    size_t victim = 0;
+    for (size_t slot = 1; slot < active_count; ++slot) {
+        if (before(slot, victim)) {
+            victim = slot;
+        }
+    }
+    return victim;
+}
+
+void Voice_engine::forget_key(size_t slot)
+{
+    auto& held = held_slots[key(channels[slot], note_numbers[slot])];
+    if (held == slot) {
+        held = no_slot;
+    }
+}
+
+void Voice_engine::remove(size_t slot)
+{
+    forget_key(slot);
+    const auto last = --active_count;
+    if (slot != last) {
+        renderer.move_voice(last, slot);
+        channels[slot] = channels[last];
+        note_numbers[slot] = note_numbers[last];
+        velocities[slot] = velocities[last];
+        start_orders[slot] = start_orders[last];
+        released[slot] = released[last];
+        sustained[slot] = sustained[last];
+        levels[slot] = levels[last];
+        finished[slot] = finished[last];
+        auto& held = held_slots[key(channels[slot], note_numbers[slot])];
+        if (held == last) {
+            held = static_cast<uint32_t>(slot);
+        }
+    }
+    renderer.clear_voice(last);
+}
+
+void Voice_engine::render(Deinterleaved_audio audio, size_t start, size_t end)
+{
+    for (size_t channel = 0; channel < audio.channel_count; ++channel) {
+        channel_pointers[channel] = audio.data[channel] + start;
+    }
+    const auto segment
+        = Deinterleaved_audio {audio.channel_count, end - start, channel_pointers.data()};
+    const auto width = configuration.lane_width;
+    for (size_t first = 0; first < active_count; first += width) {
+        const auto group = Voice_group {
+            first, width, std::min(width, active_count - first), &levels[first], &finished[first]};
+        renderer.render(group, segment);
+    }
+
+    // Backwards, so each voice moved into a finished one's slot has already been looked at.
+    for (size_t slot = active_count; slot-- > 0;) {
+        if (finished[slot]) {
+            remove(slot);
+        }
+    }
+}
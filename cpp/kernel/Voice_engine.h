@@ -0,0 +1,160 @@
+#pragma once
+#include "Brinicle/Kernel/Audio_event.h"
+#include "Brinicle/Kernel/Deinterleaved_audio.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// Which voice a note takes when every voice is busy.  Voices that have been released are
+/// always stolen before held ones.
+enum class Voice_stealing {
+    /// The new note is dropped.
+    none,
+
+    /// The voice that started longest ago.
+    oldest,
+
+    /// The voice with the lowest level, as last reported by the renderer.
+    quietest,
+
+    lowest_note,
+    highest_note,
+};
+
+struct Voice_note {
+    uint8_t channel;
+    uint8_t note;
+    uint8_t velocity;
+};
+
+/// `lane_count` consecutive voice slots, rendered together.  Only the first `active_count`
+/// lanes are playing, but the rest are idle slots that a renderer may run through the same
+/// code, so its loops over lanes can always be the full width.  `levels` and `finished` are
+/// indexed by lane.
+struct Voice_group {
+    size_t first_slot;
+    size_t lane_count;
+    size_t active_count;
+
+    /// The renderer may set each voice's current level, for `Voice_stealing::quietest`.
+    float* levels;
+
+    /// The renderer sets a voice's entry non-zero once it's silent for good, usually at the
+    /// end of its release.  The engine then compacts it out of the active voices.
+    uint8_t* finished;
+};
+
+/// Holds the state of every voice of a `Voice_engine`, and renders them.
+///
+/// State should be kept as structure-of-arrays indexed by slot, sized to the engine's
+/// `capacity()`, so that `render` can process a group's lanes with fixed-width loops the
+/// compiler vectorizes.  Every slot starts out idle, and idle slots must render silence.
+class Voice_renderer {
+public:
+    virtual ~Voice_renderer();
+
+    /// Start playing `note` in `slot`.  If `stolen`, the slot was playing another voice.
+    virtual void start_voice(size_t slot, const Voice_note& note, bool stolen) = 0;
+
+    /// The voice in `slot` has had its note off.
+    virtual void release_voice(size_t slot, uint8_t velocity) = 0;
+
+    /// Move the voice in slot `from` to slot `to`, which is idle or finished.
+    virtual void move_voice(size_t from, size_t to) = 0;
+
+    /// Make `slot` idle.
+    virtual void clear_voice(size_t slot) = 0;
+
+    /// Add `audio.frame_count` frames of the voices in `group` to `audio`.
+    virtual void render(const Voice_group& group, Deinterleaved_audio audio) = 0;
+};
+
+/// Allocates voices for an instrument kernel from the MIDI messages in its event stream, and
+/// renders them a lane group at a time through a `Voice_renderer`.
+///
+/// The playing voices always occupy the first `active_voice_count()` slots: when a voice
+/// finishes, the last playing voice is moved into its slot.  So rendering costs the same per
+/// playing voice however many slots there are, and finding the voice for a note off takes
+/// constant time.  A held note played again is released first, so each key holds at most
+/// one voice.  Handles note on and off, the sustain pedal, all notes off and all sound off.
+/// Nothing here allocates after construction.
+class Voice_engine {
+public:
+    struct Configuration {
+        /// Rounded up to a whole number of lane groups.
+        size_t max_voices = 256;
+
+        /// Voices rendered together; 1, 4, 8 or 16.  Four fills an SSE or NEON register, eight
+        /// an AVX one and sixteen an AVX-512 one.  `Voice_lanes` renders groups wider than the
+        /// CPU's vectors a vector at a time, so they cost no more per voice than those that fit.
+        size_t lane_width = 4;
+
+        Voice_stealing stealing = Voice_stealing::oldest;
+    };
+
+    Voice_engine(Configuration configuration, Voice_renderer& renderer, size_t max_channels);
+
+    size_t capacity() const { return channels.size(); }
+    size_t lane_width() const { return configuration.lane_width; }
+    size_t active_voice_count() const { return active_count; }
+
+    Voice_note note(size_t slot) const
+    {
+        return Voice_note {channels[slot], note_numbers[slot], velocities[slot]};
+    }
+    bool is_released(size_t slot) const { return released[slot] != 0; }
+
+    /// Replaces `audio` with the playing voices, starting and releasing them at the times of
+    /// the MIDI messages in `events`.  Other events are ignored.
+    void process(Deinterleaved_audio audio, Audio_event_span events);
+
+    /// Handles a MIDI message straight away, rather than at a time within a block.
+    void handle_midi(const Midi_message& message);
+
+    /// Stops every voice immediately.
+    void reset();
+
+private:
+    static constexpr uint32_t no_slot = static_cast<uint32_t>(-1);
+    static constexpr size_t midi_channel_count = 16;
+    static constexpr size_t midi_note_count = 128;
+
+    static size_t key(uint8_t channel, uint8_t note) { return channel * midi_note_count + note; }
+
+    void note_on(Voice_note note);
+    void note_off(uint8_t channel, uint8_t note, uint8_t velocity);
+    void set_sustain(uint8_t channel, bool on);
+    void release_channel(uint8_t channel);
+    void stop_channel(uint8_t channel);
+    void release(size_t slot, uint8_t velocity);
+    size_t choose_victim() const;
+    void forget_key(size_t slot);
+    void remove(size_t slot);
+    void render(Deinterleaved_audio audio, size_t start, size_t end);
+
+    Configuration configuration;
+    Voice_renderer& renderer;
+    std::vector<float*> channel_pointers;
+
+    size_t active_count = 0;
+    uint64_t next_start_order = 0;
+
+    // Per slot.  The first `active_count` slots are playing.
+    std::vector<uint8_t> channels;
+    std::vector<uint8_t> note_numbers;
+    std::vector<uint8_t> velocities;
+    std::vector<uint64_t> start_orders;
+    std::vector<uint8_t> released;
+    std::vector<uint8_t> sustained;
+    std::vector<float> levels;
+    std::vector<uint8_t> finished;
+
+    // The slot holding each channel and note's unreleased voice, or `no_slot`.
+    std::vector<uint32_t> held_slots;
+    std::array<bool, midi_channel_count> sustain_pedals = {};
+};
+
+}
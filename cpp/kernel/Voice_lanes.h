@@ -0,0 +1,145 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Brinicle {
+
+namespace Voice_lanes_detail {
+// The most floats the target's vector registers hold.  GCC lowers vector types wider than
+// that badly, often a lane at a time through memory, so wider lanes are built from halves.
+#if defined(__AVX512F__)
+    constexpr size_t native_width = 16;
+#elif defined(__AVX__)
+    constexpr size_t native_width = 8;
+#else
+    constexpr size_t native_width = 4;
+#endif
+
+    /// Lanes wider than the target's vectors, as two halves that each operator works on in
+    /// turn.
+    template <typename Half> struct Split {
+        Half low;
+        Half high;
+    };
+
+#define BRINICLE_SPLIT_LANES_OPERATOR(op)                                                          \
+    template <typename Half> auto operator op(Split<Half> a, Split<Half> b)                        \
+    {                                                                                              \
+        return Split<decltype(a.low op b.low)> {a.low op b.low, a.high op b.high};                 \
+    }
+
+#define BRINICLE_SPLIT_LANES_ARITHMETIC(op)                                                        \
+    BRINICLE_SPLIT_LANES_OPERATOR(op)                                                              \
+    template <typename Half> Split<Half> operator op(Split<Half> a, float b)                       \
+    {                                                                                              \
+        return {a.low op b, a.high op b};                                                          \
+    }                                                                                              \
+    template <typename Half> Split<Half> operator op(float a, Split<Half> b)                       \
+    {                                                                                              \
+        return {a op b.low, a op b.high};                                                          \
+    }                                                                                              \
+    template <typename Half, typename Other> Split<Half>& operator op##=(Split<Half>& a, Other b)  \
+    {                                                                                              \
+        return a = a op b;                                                                         \
+    }
+
+    BRINICLE_SPLIT_LANES_ARITHMETIC(+)
+    BRINICLE_SPLIT_LANES_ARITHMETIC(-)
+    BRINICLE_SPLIT_LANES_ARITHMETIC(*)
+    BRINICLE_SPLIT_LANES_ARITHMETIC(/)
+    BRINICLE_SPLIT_LANES_OPERATOR(<)
+    BRINICLE_SPLIT_LANES_OPERATOR(>)
+    BRINICLE_SPLIT_LANES_OPERATOR(<=)
+    BRINICLE_SPLIT_LANES_OPERATOR(>=)
+    BRINICLE_SPLIT_LANES_OPERATOR(==)
+    BRINICLE_SPLIT_LANES_OPERATOR(!=)
+    BRINICLE_SPLIT_LANES_OPERATOR(&)
+    BRINICLE_SPLIT_LANES_OPERATOR(|)
+    BRINICLE_SPLIT_LANES_OPERATOR(^)
+
+#undef BRINICLE_SPLIT_LANES_ARITHMETIC
+#undef BRINICLE_SPLIT_LANES_OPERATOR
+
+    template <typename Half> Split<Half> operator-(Split<Half> a) { return {-a.low, -a.high}; }
+    template <typename Half> Split<Half> operator~(Split<Half> a) { return {~a.low, ~a.high}; }
+
+    template <size_t Width, bool Native = Width <= native_width> struct Types {
+        typedef float Lanes __attribute__((vector_size(Width * sizeof(float))));
+        typedef int32_t Mask __attribute__((vector_size(Width * sizeof(float))));
+    };
+
+    template <size_t Width> struct Types<Width, false> {
+        typedef Split<typename Types<Width / 2>::Lanes> Lanes;
+        typedef Split<typename Types<Width / 2>::Mask> Mask;
+    };
+
+    // A single lane is just a float, so it costs no more than scalar code.
+    template <> struct Types<1, true> {
+        typedef float Lanes;
+        typedef bool Mask;
+    };
+}
+
+/// One float for each voice of a `Voice_group`, for writing a `Voice_renderer` that handles a
+/// group's voices at once.  Apart from a single lane, which is a plain float, these are GCC and
+/// clang vector types: arithmetic works lane by lane and compiles to SIMD instructions, and
+/// comparisons give a `Voice_mask` of all-ones or zero lanes.  Lanes wider than the target's
+/// vectors are a pair of narrower ones with the same operators, so they cost no more per
+/// voice, but they can't be indexed.  `Width` must be a power of two.
+template <size_t Width> using Voice_lanes = typename Voice_lanes_detail::Types<Width>::Lanes;
+template <size_t Width> using Voice_mask = typename Voice_lanes_detail::Types<Width>::Mask;
+
+/// Reads `Width` floats, which needn't be aligned.
+template <size_t Width> Voice_lanes<Width> load_lanes(const float* in)
+{
+    Voice_lanes<Width> lanes;
+    std::memcpy(&lanes, in, sizeof(lanes));
+    return lanes;
+}
+
+template <size_t Width> void store_lanes(float* out, Voice_lanes<Width> lanes)
+{
+    std::memcpy(out, &lanes, sizeof(lanes));
+}
+
+template <size_t Width> Voice_lanes<Width> broadcast_lanes(float value)
+{
+    return Voice_lanes<Width> {} + value;
+}
+
+/// Lanes of `a` where `mask` is set, and of `b` elsewhere.
+template <typename Lanes, typename Mask> Lanes select_lanes(Mask mask, Lanes a, Lanes b)
+{
+    return (Lanes)((mask & (Mask)a) | (~mask & (Mask)b));
+}
+
+inline float select_lanes(bool mask, float a, float b) { return mask ? a : b; }
+
+template <typename Lanes, typename Mask>
+Voice_lanes_detail::Split<Lanes> select_lanes(Voice_lanes_detail::Split<Mask> mask,
+                                              Voice_lanes_detail::Split<Lanes> a,
+                                              Voice_lanes_detail::Split<Lanes> b)
+{
+    return {select_lanes(mask.low, a.low, b.low), select_lanes(mask.high, a.high, b.high)};
+}
+
+template <typename Lanes> Lanes min_lanes(Lanes a, Lanes b) { return select_lanes(a < b, a, b); }
+
+template <typename Lanes> Lanes max_lanes(Lanes a, Lanes b) { return select_lanes(a > b, a, b); }
+
+template <typename Lanes> Lanes abs_lanes(Lanes a) { return select_lanes(a < Lanes {}, -a, a); }
+
+/// The sum of every lane, for mixing a group's voices down.  Adds halves together, so it's
+/// a vector add per halving.
+inline float sum_lanes(float lanes) { return lanes; }
+
+template <typename Lanes> float sum_lanes(Lanes lanes)
+{
+    using Half = Voice_lanes<sizeof(Lanes) / sizeof(float) / 2>;
+    Half halves[2];
+    std::memcpy(halves, &lanes, sizeof(lanes));
+    return sum_lanes(halves[0] + halves[1]);
+}
+
+}
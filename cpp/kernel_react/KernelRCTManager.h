@@ -4,7 +4,9 @@
 
 #include "TargetConditionals.h"
 
+#include "Brinicle/Kernel/Parameter_registry.h"
 #include "Brinicle/React/Kernel_ui_interface.h"
+#include "Brinicle/Thread/Parameter_change_set.h"
 #include "Brinicle/Utilities/Macro_join.h"
 #include "ObjC_prefix.h"
 #import <React/RCTEventEmitter.h>
@@ -22,8 +24,11 @@
 @interface KernelRCTManager : RCTEventEmitter {
     Brinicle::Kernel_ui_interface _ui_interface;
     std::optional<std::any> _listener_token;
-    std::map<std::string, uint64_t> _audioUnitIdentifierToAddressMap;
-    std::map<uint64_t, std::string> _addressToAudioUnitIdentifierMap;
+    std::shared_ptr<const Brinicle::Parameter_registry> _registry;
+    // Identifiers in the order of `_ui_interface.parameters`.
+    NSArray<NSString*>* _identifiers;
+    // Changes not yet sent to javascript; we send at most one batch per display frame.
+    std::unique_ptr<Brinicle::Parameter_change_set> _changes;
     std::map<uint64_t, std::unique_ptr<Brinicle::Grabbed_parameter>> _grabs;
     NSDictionary<NSString*, id>* _parameterInfo;
 }
@@ -106,6 +106,9 @@ static NSDictionary* create_info_dict_for_param(const Parameter_info& info)
         info.info);
 }
 
+// How long to collect parameter changes before sending them on; about one display frame.
+static const int64_t send_interval_ns = NSEC_PER_SEC / 60;
+
 @implementation KernelRCTManager
 
 + (NSString*)moduleName
@@ -116,27 +119,27 @@ static NSDictionary* create_info_dict_for_param(const Parameter_info& info)
 RCT_EXPORT_METHOD(sendAllParams)
 {
     dispatch_async(dispatch_get_main_queue(), ^() {
-        auto params = get_param_state(*_ui_interface.parameter_set, _ui_interface.parameters);
-        for (auto& param : params) {
-            [self sendEventWithName:@"AURCTParamChanged"
-                               body:@ {
-                                   @"identifier" : [NSString
-                                       stringWithUTF8String:
-                                           _addressToAudioUnitIdentifierMap[param.first].c_str()],
-                                   @"value" : [NSNumber numberWithFloat:param.second]
-                               }];
+        _changes->resend_all();
+        for (const auto& param :
+             get_param_state(*_ui_interface.parameter_set, _ui_interface.parameters)) {
+            _changes->record(param.first, param.second);
         }
+        [self sendParameterChanges];
     });
 }
 
 RCT_EXPORT_METHOD(grabParameter
                   : (nonnull NSString*)name resolver
                   : (RCTPromiseResolveBlock)resolve rejecter
-                  : (RCTPromiseRejectBlock)__unused reject)
+                  : (RCTPromiseRejectBlock)reject)
 {
     dispatch_async(dispatch_get_main_queue(), ^() {
-        std::string identifier([name UTF8String]);
-        auto address = _audioUnitIdentifierToAddressMap[identifier];
+        const auto index = _registry->index_of(std::string_view([name UTF8String]));
+        if (index == Parameter_registry::npos) {
+            reject(@"Bad parameter", @"Bad parameter", nil);
+            return;
+        }
+        const auto address = _registry->address(index);
 
         uint64_t gesture_identifier = _grabs.size() == 0 ? 0u : _grabs.rbegin()->first + 1;
 
@@ -181,9 +184,11 @@ RCT_EXPORT_METHOD(ungrabParameter
 RCT_EXPORT_METHOD(setParameter : (nonnull NSString*)name value : (float)value)
 {
     dispatch_async(dispatch_get_main_queue(), ^() {
-        std::string identifier([name UTF8String]);
-        _ui_interface.parameter_set->grab_parameter(_audioUnitIdentifierToAddressMap[identifier])
-            ->set_parameter(value);
+        const auto index = _registry->index_of(std::string_view([name UTF8String]));
+        if (index != Parameter_registry::npos) {
+            _ui_interface.parameter_set->grab_parameter(_registry->address(index))
+                ->set_parameter(value);
+        }
     });
 }
 
@@ -192,23 +197,41 @@ RCT_EXPORT_METHOD(setParameter : (nonnull NSString*)name value : (float)value)
     _ui_interface = std::move(interface);
 
     const auto& parameters = _ui_interface.parameters;
+    _registry = std::make_shared<const Parameter_registry>(parameters);
     auto parameterInfo = [NSMutableDictionary new];
+    auto identifiers = [NSMutableArray new];
     for (const auto& parameter : parameters) {
-        _audioUnitIdentifierToAddressMap[parameter.identifier_string] = parameter.address;
-        _addressToAudioUnitIdentifierMap[parameter.address] = parameter.identifier_string;
-
-        [parameterInfo
-            setObject:create_info_dict_for_param(parameter)
-               forKey:[NSString stringWithUTF8String:parameter.identifier_string.c_str()]];
+        auto identifier = [NSString stringWithUTF8String:parameter.identifier_string.c_str()];
+        [identifiers addObject:identifier];
+        [parameterInfo setObject:create_info_dict_for_param(parameter) forKey:identifier];
     }
 
+    _identifiers = identifiers;
+    _changes = std::make_unique<Parameter_change_set>(_registry);
     _parameterInfo = parameterInfo;
     return self;
 }
 
+/// Sends everything that changed since the last batch as a single event.  Main thread only.
+- (void)sendParameterChanges
+{
+    auto values = [NSMutableDictionary new];
+    _changes->take([&](size_t index, float value) {
+        [values setObject:[NSNumber numberWithFloat:value] forKey:_identifiers[index]];
+    });
+    if (values.count == 0) {
+        return;
+    }
+    [self sendEventWithName:@"AURCTParamsChanged"
+                       body:@ {
+                           @"version" : [NSNumber numberWithUnsignedLongLong:_changes->version()],
+                           @"values" : values,
+                       }];
+}
+
 - (NSArray<NSString*>*)supportedEvents
 {
-    return @[ @"AURCTParamChanged" ];
+    return @[ @"AURCTParamsChanged" ];
 }
 
 - (void)startObserving
@@ -218,18 +241,15 @@ RCT_EXPORT_METHOD(setParameter : (nonnull NSString*)name value : (float)value)
         _listener_token = _ui_interface.subscribe_to_parameter_changes(
             [weakSelf](uint64_t address, float value) {
                 __strong auto strongSelf = weakSelf;
-                if (!strongSelf) {
+                if (!strongSelf || !strongSelf->_changes->record(address, value)) {
                     return;
                 }
-                [strongSelf
-                    sendEventWithName:@"AURCTParamChanged"
-                                 body:@ {
-                                     @"identifier" : [NSString
-                                         stringWithUTF8String:
-                                             strongSelf->_addressToAudioUnitIdentifierMap[address]
-                                                 .c_str()],
-                                     @"value" : [NSNumber numberWithFloat:value],
-                                 }];
+                // First change since the last batch; send the batch a frame from now.
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, send_interval_ns),
+                               dispatch_get_main_queue(),
+                               ^() {
+                                   [weakSelf sendParameterChanges];
+                               });
             });
     });
 }
@@ -12,6 +12,7 @@ class KernelManager extends EventEmitter {
     this.parameterInfo = KernelRCTManager.parameterInfo;
     this.grabs = {};
     this.parameters = {};
+    this.version = 0;
     this.loaded = false;
     this.onLoadedListeners = [];
 
@@ -23,10 +24,14 @@ class KernelManager extends EventEmitter {
       }
       return true;
     };
-    KernelRCTEvents.addListener('AURCTParamChanged', (event) => {
-      const identifier = event.identifier;
-      const value = event.value;
-      this.parameters[identifier] = value;
+    // Changes arrive in batches, at most one per display frame, holding the latest value of
+    // each parameter that changed.
+    KernelRCTEvents.addListener('AURCTParamsChanged', (event) => {
+      if (event.version <= this.version) {
+        return;
+      }
+      this.version = event.version;
+      Object.assign(this.parameters, event.values);
       const wasLoaded = this.loaded;
       this.loaded = checkLoaded();
       if (this.loaded && !wasLoaded) {
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Brinicle {
+
+/// A fixed-size set of indices that any number of threads can mark, and that a single thread
+/// drains.  Marking and draining are both wait-free, and draining costs time proportional to
+/// the number of marked indices (plus one word per 4096 indices).
+///
+/// Anything written before `mark` is visible to the draining thread when it sees the index.
+class Dirty_set {
+public:
+    explicit Dirty_set(size_t size)
+        : words((size + bits_per_word - 1) / bits_per_word)
+        , summary((words.size() + bits_per_word - 1) / bits_per_word)
+    {
+    }
+
+    Dirty_set(const Dirty_set&) = delete;
+    Dirty_set& operator=(const Dirty_set&) = delete;
+
+    void mark(size_t index)
+    {
+        const auto word = index / bits_per_word;
+        words[word].fetch_or(bit(index), std::memory_order_release);
+        summary[word / bits_per_word].fetch_or(bit(word), std::memory_order_release);
+    }
+
+    /// Calls `f(index)` once for each marked index, in increasing order, and unmarks it.
+    template <typename F> void drain(F f)
+    {
+        for (size_t summary_index = 0; summary_index < summary.size(); ++summary_index) {
+            auto dirty_words = summary[summary_index].exchange(0, std::memory_order_acquire);
+            while (dirty_words) {
+                const auto word = summary_index * bits_per_word + lowest_bit(dirty_words);
+                dirty_words &= dirty_words - 1;
+
+                auto dirty = words[word].exchange(0, std::memory_order_acquire);
+                while (dirty) {
+                    f(word * bits_per_word + lowest_bit(dirty));
+                    dirty &= dirty - 1;
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr size_t bits_per_word = 64;
+
+    static uint64_t bit(size_t index) { return uint64_t(1) << (index % bits_per_word); }
+    static size_t lowest_bit(uint64_t word) { return static_cast<size_t>(__builtin_ctzll(word)); }
+
+    std::vector<std::atomic<uint64_t>> words;
+    std::vector<std::atomic<uint64_t>> summary;
+};
+
+}
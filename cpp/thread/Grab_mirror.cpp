@@ -2,15 +2,21 @@
 
 using namespace Brinicle;
 
-Grab_mirror::Grab_mirror(const std::vector<Parameter_info>& params)
+Grab_mirror::Grab_mirror(std::shared_ptr<const Parameter_registry> registry_)
+    : registry(std::move(registry_)), dsp_grab_count(registry->size(), 0u), pending_gestures(64)
 {
-    for (const auto& param : params) {
-        dsp_grab_count[param.address] = 0u;
-        atomic_pending_grabs[param.address].store(0u);
-        atomic_pending_ungrabs[param.address].store(0u);
-    }
 }
 
-void Grab_mirror::grab_from_ui_thread(uint64_t address) { ++atomic_pending_grabs[address]; }
+void Grab_mirror::grab_from_ui_thread(uint64_t address) { enqueue(address, true); }
+
+void Grab_mirror::ungrab_from_ui_thread(uint64_t address) { enqueue(address, false); }
 
-void Grab_mirror::ungrab_from_ui_thread(uint64_t address) { ++atomic_pending_ungrabs[address]; }
+void Grab_mirror::enqueue(uint64_t address, bool is_grab)
+{
+    const auto index = registry->index_of(address);
+    if (index == Parameter_registry::npos) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(ui_lock);
+    pending_gestures.enqueue(Gesture {index, is_grab});
+}
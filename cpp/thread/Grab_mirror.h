@@ -1,48 +1,61 @@
 #pragma once
 
-#include "Brinicle/Kernel/Parameter.h"
-#include <atomic>
-#include <map>
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "readerwriterqueue.h"
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Brinicle {
+
+/// Hands gesture begin/end ("grab"/"ungrab") notifications from UI threads to the DSP thread,
+/// in the order they happened.
 class Grab_mirror {
 public:
-    Grab_mirror(const std::vector<Parameter_info>& params);
+    Grab_mirror(std::shared_ptr<const Parameter_registry> registry);
 
+    /// Gestures on unknown addresses are ignored.
     void grab_from_ui_thread(uint64_t address);
     void ungrab_from_ui_thread(uint64_t address);
 
-    template <typename Grab> void check_pending_grabs_from_dsp_thread(Grab grab)
-    {
-        for (auto& g : atomic_pending_grabs) {
-            auto grab_count = g.second.exchange(0u);
-            bool was_grabbed = dsp_grab_count.at(g.first) != 0;
-            dsp_grab_count[g.first] += grab_count;
-            auto is_grabbed = dsp_grab_count.at(g.first) != 0u;
-            if (is_grabbed != was_grabbed) {
-                grab(g.first);
-            }
-        }
-    }
-
-    template <typename Ungrab> void check_pending_ungrabs_from_dsp_thread(Ungrab ungrab)
+    /// Calls `grab` when a parameter goes from not grabbed to grabbed, and `ungrab` when it
+    /// goes back, in the order the UI did so.  Costs nothing when there are no pending
+    /// gestures.
+    template <typename Grab, typename Ungrab>
+    void check_pending_gestures_from_dsp_thread(Grab grab, Ungrab ungrab)
     {
-        for (auto& g : atomic_pending_ungrabs) {
-            auto ungrab_count = g.second.exchange(0u);
-            bool was_grabbed = dsp_grab_count.at(g.first) != 0;
-            dsp_grab_count[g.first] = ungrab_count > dsp_grab_count[g.first]
-                ? 0u
-                : dsp_grab_count[g.first] - ungrab_count;
-            auto is_grabbed = dsp_grab_count.at(g.first) != 0u;
-            if (is_grabbed != was_grabbed) {
-                ungrab(g.first);
+        Gesture gesture;
+        while (pending_gestures.try_dequeue(gesture)) {
+            auto& grab_count = dsp_grab_count[gesture.index];
+            if (gesture.is_grab) {
+                if (grab_count++ == 0u) {
+                    grab(registry->address(gesture.index));
+                }
+            } else if (grab_count != 0u) {
+                if (--grab_count == 0u) {
+                    ungrab(registry->address(gesture.index));
+                }
             }
         }
     }
 
 private:
-    std::map<uint64_t, uint64_t> dsp_grab_count;
-    std::map<uint64_t, std::atomic<uint64_t>> atomic_pending_grabs;
-    std::map<uint64_t, std::atomic<uint64_t>> atomic_pending_ungrabs;
+    struct Gesture {
+        // In the `Parameter_info` list; always a known parameter.
+        size_t index;
+        bool is_grab;
+    };
+
+    void enqueue(uint64_t address, bool is_grab);
+
+    std::shared_ptr<const Parameter_registry> registry;
+
+    // Only touched by the DSP thread.
+    std::vector<uint64_t> dsp_grab_count;
+
+    // The queue is single-producer, so UI threads take turns.  This may allocate if the queue
+    // is full, but only ever on the UI side.
+    std::mutex ui_lock;
+    moodycamel::ReaderWriterQueue<Gesture> pending_gestures;
 };
 }
@@ -1,40 +1,50 @@
 #include "Brinicle/Thread/Param_mirror.h"
 #include "Brinicle/Utilities/Overload.h"
+#include <stdexcept>
 
 using namespace Brinicle;
 
-Param_mirror::Param_mirror(const std::vector<Parameter_info>& params)
+Param_mirror::Param_mirror(std::shared_ptr<const Parameter_registry> registry_)
+    : registry(std::move(registry_))
+    , to_dsp_values(registry->size())
+    , to_ui_values(registry->size())
+    , to_dsp_dirty(registry->size())
+    , to_ui_dirty(registry->size())
 {
-    for (const auto& param : params) {
-        ui_param_mirror[param.address] = std::visit(
-            overload {[](const Numeric_parameter_info& info) -> float {
-                          return double(info.default_value);
-                      },
-                      [](const Indexed_parameter_info& info) -> float {
-                          return double(info.default_value);
-                      }},
-            param.info);
-        atomic_mirror[param.address].store(
-            std::visit(overload {[](const Numeric_parameter_info& info) -> float {
-                                     return double(info.default_value);
-                                 },
-                                 [](const Indexed_parameter_info& info) -> float {
-                                     return double(info.default_value);
-                                 }},
-                       param.info));
+    for (const auto& param : registry->parameters()) {
+        auto default_value = std::visit(overload {[](const Numeric_parameter_info& info) -> float {
+                                                      return double(info.default_value);
+                                                  },
+                                                  [](const Indexed_parameter_info& info) -> float {
+                                                      return double(info.default_value);
+                                                  }},
+                                        param.info);
+        to_dsp_values[ui_values.size()].store(default_value);
+        to_ui_values[ui_values.size()].store(default_value);
+        ui_values.push_back(default_value);
     }
-    dsp_param_mirror = ui_param_mirror;
 }
 
 Param_mirror::~Param_mirror() {}
 
+size_t Param_mirror::index_of(uint64_t address) const
+{
+    const auto index = registry->index_of(address);
+    if (index == Parameter_registry::npos) {
+        throw std::out_of_range("Param_mirror: unknown parameter address");
+    }
+    return index;
+}
+
 float Param_mirror::get_from_ui_thread(uint64_t address) const
 {
-    return ui_param_mirror.at(address);
+    return ui_values[index_of(address)];
 }
 
 void Param_mirror::set_from_ui_thread(uint64_t address, float value)
 {
-    ui_param_mirror[address] = value;
-    atomic_mirror[address].store(value);
+    auto index = index_of(address);
+    ui_values[index] = value;
+    to_dsp_values[index].store(value, std::memory_order_relaxed);
+    to_dsp_dirty.mark(index);
 }
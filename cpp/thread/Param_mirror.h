@@ -1,8 +1,10 @@
 #pragma once
 #include "Brinicle/Kernel/Parameter.h"
-#include "readerwriterqueue.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Thread/Dirty_set.h"
 #include <atomic>
-#include <map>
+#include <memory>
+#include <vector>
 
 namespace Brinicle {
 
@@ -10,53 +12,54 @@ namespace Brinicle {
 // of the set of parameters of a kernel, so that manipulations
 // can happen concurrently on both threads.
 // We aim for eventual consistency
+//
+// Parameters are stored densely, in the order of the `Parameter_info` list, and each
+// direction has a dirty set, so a sync only visits parameters that actually changed.
 class Param_mirror {
 public:
-    Param_mirror(const std::vector<Parameter_info>& params);
+    Param_mirror(std::shared_ptr<const Parameter_registry> registry);
     ~Param_mirror();
 
     float get_from_ui_thread(uint64_t address) const;
     void set_from_ui_thread(uint64_t address, float value);
 
-    // "f" is the function to set a parameter.
-    // "g" is the function to get a parameter.
-    // "grab" is the function to grab/ungrab a parameter.
-    template <typename F, typename G> void sync_from_dsp_thread(F f, G g)
+    /// Tell the UI thread that the parameter at `index` (in the `Parameter_info` list)
+    /// now has `value` on the DSP side.
+    void set_from_dsp_thread(size_t index, float value)
     {
-        // Copy atomic changes to the dsp thread.
-        for (const auto& param : atomic_mirror) {
-            auto v = param.second.load();
-            if (v != dsp_param_mirror.at(param.first)) {
-                dsp_param_mirror[param.first] = v;
-                f(param.first, v);
-            }
-        }
-
-        // Send everything that has changed to the ui thread.
-        for (const auto& param : dsp_param_mirror) {
-            auto v = g(param.first);
-            if (param.second != v) {
-                dsp_param_mirror[param.first] = v;
-                atomic_mirror[param.first].store(v);
-            }
-        }
+        to_ui_values[index].store(value, std::memory_order_relaxed);
+        to_ui_dirty.mark(index);
+    }
+
+    // "f" is the function to set a parameter; it's called for each parameter the UI thread
+    // has changed since the last sync.
+    template <typename F> void sync_from_dsp_thread(F f)
+    {
+        to_dsp_dirty.drain([&](size_t index) {
+            f(registry->address(index), to_dsp_values[index].load(std::memory_order_relaxed));
+        });
     }
 
     template <typename F> void sync_from_ui_thread(F f)
     {
-        // Copy atomic changes to the ui thread.
-        for (const auto& param : atomic_mirror) {
-            auto v = param.second.load();
-            if (v != ui_param_mirror.at(param.first)) {
-                ui_param_mirror[param.first] = v;
-                f(param.first, v);
+        to_ui_dirty.drain([&](size_t index) {
+            auto v = to_ui_values[index].load(std::memory_order_relaxed);
+            if (v != ui_values[index]) {
+                ui_values[index] = v;
+                f(registry->address(index), v);
             }
-        }
+        });
     }
 
 private:
-    std::map<uint64_t, float> ui_param_mirror;
-    std::map<uint64_t, float> dsp_param_mirror;
-    std::map<uint64_t, std::atomic<float>> atomic_mirror;
+    size_t index_of(uint64_t address) const;
+
+    std::shared_ptr<const Parameter_registry> registry;
+
+    std::vector<float> ui_values;
+    std::vector<std::atomic<float>> to_dsp_values;
+    std::vector<std::atomic<float>> to_ui_values;
+    Dirty_set to_dsp_dirty;
+    Dirty_set to_ui_dirty;
 };
 }
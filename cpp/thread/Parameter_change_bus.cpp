@@ -0,0 +1,91 @@
+#include "Brinicle/Thread/Parameter_change_bus.h"
+#include <algorithm>
+
+using namespace Brinicle;
+
+Parameter_change_bus::Parameter_change_bus(std::shared_ptr<const Parameter_registry> registry_)
+    : registry(std::move(registry_)), values(registry->size()), dirty(registry->size())
+{
+    batch.reserve(registry->size());
+}
+
+Parameter_change_bus::Subscription::~Subscription()
+{
+    if (auto locked_bus = bus.lock()) {
+        locked_bus->unsubscribe(this);
+    }
+}
+
+void Parameter_change_bus::publish(uint64_t address, float value)
+{
+    const auto index = registry->index_of(address);
+    if (index == Parameter_registry::npos) {
+        return;
+    }
+    publish_index(index, value);
+}
+
+size_t Parameter_change_bus::deliver()
+{
+    std::lock_guard<std::recursive_mutex> guard(subscribers_lock);
+    if (delivering) {
+        // Called from a subscriber; the outer delivery has this covered.
+        return 0;
+    }
+
+    batch.clear();
+    dirty.drain([this](size_t index) {
+        const auto value = values[index].load(std::memory_order_relaxed);
+        batch.push_back(Parameter_value_change {registry->address(index), value});
+    });
+    if (batch.empty()) {
+        return 0;
+    }
+
+    // Subscribers added during delivery are appended, and those removed are only cleared, so
+    // indices stay valid while we call them.
+    delivering = true;
+    const auto subscriber_count = subscribers.size();
+    for (size_t index = 0; index < subscriber_count; ++index) {
+        const auto& subscriber = *subscribers[index];
+        if (subscriber.subscription) {
+            subscriber.callback(Parameter_change_batch {batch.data(), batch.size()});
+        }
+    }
+    delivering = false;
+    remove_unsubscribed();
+    return batch.size();
+}
+
+std::shared_ptr<Parameter_change_bus::Subscription>
+Parameter_change_bus::subscribe(std::function<void(Parameter_change_batch)> callback)
+{
+    std::shared_ptr<Subscription> subscription(new Subscription(weak_from_this()));
+    std::lock_guard<std::recursive_mutex> guard(subscribers_lock);
+    subscribers.push_back(
+        std::make_unique<Subscriber>(Subscriber {subscription.get(), std::move(callback)}));
+    return subscription;
+}
+
+void Parameter_change_bus::unsubscribe(Subscription* subscription)
+{
+    std::lock_guard<std::recursive_mutex> guard(subscribers_lock);
+    for (auto& subscriber : subscribers) {
+        if (subscriber->subscription == subscription) {
+            subscriber->subscription = nullptr;
+        }
+    }
+    if (!delivering) {
+        remove_unsubscribed();
+    }
+}
+
+void Parameter_change_bus::remove_unsubscribed()
+{
+    subscribers.erase(std::remove_if(begin(subscribers),
+                                     end(subscribers),
+                                     [](const auto& subscriber) {
+                                         return subscriber->subscription == nullptr;
+                                     }),
+                      end(subscribers));
+}
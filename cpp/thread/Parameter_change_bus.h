@@ -0,0 +1,107 @@
+#pragma once
+#include "Brinicle/Kernel/Parameter.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Thread/Dirty_set.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Brinicle {
+
+struct Parameter_value_change {
+    uint64_t address;
+    float value;
+};
+
+/// The changes delivered together by a `Parameter_change_bus`, at most one per parameter, in
+/// the order the parameters were declared.  Only valid during the callback.
+class Parameter_change_batch {
+public:
+    Parameter_change_batch(const Parameter_value_change* changes, size_t size)
+        : changes_(changes), size_(size)
+    {
+    }
+
+    const Parameter_value_change* begin() const { return changes_; }
+    const Parameter_value_change* end() const { return changes_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Parameter_value_change& operator[](size_t index) const { return changes_[index]; }
+
+private:
+    const Parameter_value_change* changes_;
+    size_t size_;
+};
+
+/// Fans parameter changes out to subscribers, in batches.
+///
+/// `publish` just records the latest value of a parameter, so any number of changes to it
+/// between deliveries cost one entry in the next batch.  It never allocates or locks, and may
+/// be called from any thread.  `deliver` (typically once per UI frame, from one thread) calls
+/// each subscriber once with everything that changed since the last delivery.
+class Parameter_change_bus : public std::enable_shared_from_this<Parameter_change_bus> {
+public:
+    /// Unsubscribes when destroyed.
+    class Subscription {
+    public:
+        ~Subscription();
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+    private:
+        friend class Parameter_change_bus;
+        explicit Subscription(std::weak_ptr<Parameter_change_bus> bus_) : bus(std::move(bus_)) {}
+        std::weak_ptr<Parameter_change_bus> bus;
+    };
+
+    explicit Parameter_change_bus(std::shared_ptr<const Parameter_registry> registry);
+
+    Parameter_change_bus(const Parameter_change_bus&) = delete;
+    Parameter_change_bus& operator=(const Parameter_change_bus&) = delete;
+
+    /// Changes to unknown addresses are ignored.
+    void publish(uint64_t address, float value);
+
+    /// Like `publish`, for the parameter at `index` in the `Parameter_info` list.
+    void publish_index(size_t index, float value)
+    {
+        values[index].store(value, std::memory_order_relaxed);
+        dirty.mark(index);
+    }
+
+    /// Calls every subscriber with the changes published since the last delivery, and returns
+    /// how many there were.  Subscribers may subscribe or unsubscribe from their callbacks;
+    /// new subscribers get their first batch at the next delivery.
+    size_t deliver();
+
+    /// The bus must be owned by a `shared_ptr`.
+    std::shared_ptr<Subscription> subscribe(std::function<void(Parameter_change_batch)> callback);
+
+private:
+    struct Subscriber {
+        Subscription* subscription;
+        std::function<void(Parameter_change_batch)> callback;
+    };
+
+    void unsubscribe(Subscription* subscription);
+    void remove_unsubscribed();
+
+    std::shared_ptr<const Parameter_registry> registry;
+    std::vector<std::atomic<float>> values;
+    Dirty_set dirty;
+
+    // The batch being delivered; sized for every parameter, so delivering never allocates.
+    std::vector<Parameter_value_change> batch;
+
+    // Guards `subscribers`.  Recursive, so callbacks can subscribe and unsubscribe.
+    std::recursive_mutex subscribers_lock;
+
+    // Boxed, so a callback stays put if it subscribes someone else.
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+    bool delivering = false;
+};
+
+}
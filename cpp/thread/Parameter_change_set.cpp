@@ -0,0 +1,29 @@
+#include "Brinicle/Thread/Parameter_change_set.h"
+#include <algorithm>
+#include <limits>
+
+using namespace Brinicle;
+
+Parameter_change_set::Parameter_change_set(std::shared_ptr<const Parameter_registry> registry_)
+    : registry(std::move(registry_))
+    , values(registry->size())
+    , dirty(registry->size())
+    , taken(registry->size(), std::numeric_limits<float>::quiet_NaN())
+{
+}
+
+bool Parameter_change_set::record(uint64_t address, float value)
+{
+    const auto index = registry->index_of(address);
+    if (index == Parameter_registry::npos) {
+        return false;
+    }
+    values[index].store(value, std::memory_order_relaxed);
+    dirty.mark(index);
+    return !pending.exchange(true, std::memory_order_acq_rel);
+}
+
+void Parameter_change_set::resend_all()
+{
+    std::fill(begin(taken), end(taken), std::numeric_limits<float>::quiet_NaN());
+}
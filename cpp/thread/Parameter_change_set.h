@@ -0,0 +1,68 @@
+#pragma once
+#include "Brinicle/Kernel/Parameter.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Thread/Dirty_set.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Brinicle {
+
+/// Collects parameter changes into versioned change sets, for sending to a UI in batches.
+///
+/// Any thread may `record` changes; only the latest value of each parameter is kept.  One
+/// thread periodically calls `take`, which reports each parameter whose latest value differs
+/// from the one it last reported, and bumps the version if there were any.
+class Parameter_change_set {
+public:
+    explicit Parameter_change_set(std::shared_ptr<const Parameter_registry> registry);
+
+    Parameter_change_set(const Parameter_change_set&) = delete;
+    Parameter_change_set& operator=(const Parameter_change_set&) = delete;
+
+    /// Returns true if this is the first change recorded since the last `take`, in which case
+    /// the caller should arrange for `take` to be called.  Changes to unknown addresses are
+    /// ignored, and return false.
+    bool record(uint64_t address, float value);
+
+    /// Forgets what was last taken, so the next `take` reports every parameter recorded before
+    /// it, even those whose value hasn't changed.  Only call this from the taking thread.
+    void resend_all();
+
+    /// Calls `f(index, value)`, with `index` in the `Parameter_info` list, for every parameter
+    /// that changed since the last call, and returns how many there were.
+    template <typename F> size_t take(F f)
+    {
+        // An exchange, so that a `record` that returned false is seen by the drain below.
+        pending.exchange(false, std::memory_order_acq_rel);
+        size_t count = 0;
+        dirty.drain([&](size_t index) {
+            const auto value = values[index].load(std::memory_order_relaxed);
+            // `taken` starts out NaN, which differs from everything.
+            if (!(value == taken[index])) {
+                taken[index] = value;
+                f(index, value);
+                ++count;
+            }
+        });
+        if (count != 0) {
+            ++version_;
+        }
+        return count;
+    }
+
+    /// The number of non-empty change sets taken so far.
+    uint64_t version() const { return version_; }
+
+private:
+    std::shared_ptr<const Parameter_registry> registry;
+    std::vector<std::atomic<float>> values;
+    Dirty_set dirty;
+    std::atomic<bool> pending = {false};
+
+    // Only touched by the taking thread.
+    std::vector<float> taken;
+    uint64_t version_ = 0;
+};
+
+}
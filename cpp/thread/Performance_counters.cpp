@@ -0,0 +1,107 @@
+#include "Brinicle/Thread/Performance_counters.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Brinicle;
+
+static size_t event_histogram_bucket(size_t event_count)
+{
+    size_t bucket = 0;
+    while (event_count && bucket + 1 < Performance_snapshot::event_histogram_size) {
+        event_count >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+Performance_counters::Performance_counters(double sample_rate_, double window_seconds)
+    : sample_rate(sample_rate_)
+    , window_frames(static_cast<uint64_t>(std::max(0., std::ceil(sample_rate_ * window_seconds))))
+{
+}
+
+void Performance_counters::record_block(std::chrono::steady_clock::duration elapsed,
+                                        size_t frames,
+                                        size_t event_count)
+{
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    const double budget = sample_rate > 0. ? static_cast<double>(frames) / sample_rate : 0.;
+    const double block_load
+        = budget > 0. ? std::chrono::duration<double>(nanoseconds).count() / budget : 0.;
+
+    // Two windows are kept, so the reported maximum always covers at least a full window.
+    if (frames_in_window >= window_frames) {
+        previous_window_max_load = window_max_load;
+        window_max_load = 0.;
+        frames_in_window = 0;
+    }
+    frames_in_window += frames;
+    window_max_load = std::max(window_max_load, block_load);
+
+    // Only this thread writes, so the counters can be updated with plain loads and stores.
+    const auto start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block_count.store(block_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    frame_count.store(frame_count.load(std::memory_order_relaxed) + frames,
+                      std::memory_order_relaxed);
+    last_block_nanoseconds.store(nanoseconds.count(), std::memory_order_relaxed);
+    load.store(block_load, std::memory_order_relaxed);
+    max_load.store(std::max(window_max_load, previous_window_max_load),
+                   std::memory_order_relaxed);
+    if (block_load > peak_load.load(std::memory_order_relaxed)) {
+        peak_load.store(block_load, std::memory_order_relaxed);
+    }
+    if (block_load > 1.) {
+        overload_count.store(overload_count.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+    }
+    auto& bucket = events_per_block[event_histogram_bucket(event_count)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+void Performance_counters::record_mirror_sync(bool found_changes)
+{
+    mirror_sync_count.fetch_add(1, std::memory_order_relaxed);
+    if (found_changes) {
+        mirror_sync_change_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Performance_counters::record_skipped_mirror_sync()
+{
+    mirror_sync_skip_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+Performance_snapshot Performance_counters::snapshot() const
+{
+    Performance_snapshot ret;
+    while (true) {
+        const auto start = sequence.load(std::memory_order_acquire);
+        if (start & 1) {
+            continue;
+        }
+        ret.block_count = block_count.load(std::memory_order_relaxed);
+        ret.frame_count = frame_count.load(std::memory_order_relaxed);
+        ret.last_block_time
+            = std::chrono::nanoseconds(last_block_nanoseconds.load(std::memory_order_relaxed));
+        ret.load = load.load(std::memory_order_relaxed);
+        ret.max_load = max_load.load(std::memory_order_relaxed);
+        ret.peak_load = peak_load.load(std::memory_order_relaxed);
+        ret.overload_count = overload_count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < events_per_block.size(); ++i) {
+            ret.events_per_block[i] = events_per_block[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == start) {
+            break;
+        }
+    }
+    ret.mirror_sync_count = mirror_sync_count.load(std::memory_order_relaxed);
+    ret.mirror_sync_change_count = mirror_sync_change_count.load(std::memory_order_relaxed);
+    ret.mirror_sync_skip_count = mirror_sync_skip_count.load(std::memory_order_relaxed);
+    return ret;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Brinicle {
+
+/// A consistent copy of a `Performance_counters`.
+struct Performance_snapshot {
+    static constexpr size_t event_histogram_size = 8;
+
+    uint64_t block_count = 0;
+    uint64_t frame_count = 0;
+
+    /// Wall time spent processing the last block.
+    std::chrono::nanoseconds last_block_time = std::chrono::nanoseconds(0);
+
+    /// Time spent processing the last block, as a fraction of the time it lasts at the sample
+    /// rate.  Above 1, the kernel can't keep up.
+    double load = 0.;
+
+    /// The largest `load` over the last one to two windows.
+    double max_load = 0.;
+
+    /// The largest `load` since the counters were created.
+    double peak_load = 0.;
+
+    /// The number of blocks with a `load` above 1.
+    uint64_t overload_count = 0;
+
+    /// `events_per_block[0]` counts blocks with no events, and `events_per_block[i]` blocks
+    /// with `2^(i - 1)` to `2^i - 1` events.  The last entry also counts all larger blocks.
+    std::array<uint64_t, event_histogram_size> events_per_block = {};
+
+    /// Syncs of the parameter mirror, how many of them found parameters the UI had changed,
+    /// and how many were skipped because another thread was already syncing.
+    uint64_t mirror_sync_count = 0;
+    uint64_t mirror_sync_change_count = 0;
+    uint64_t mirror_sync_skip_count = 0;
+};
+
+/// Lock-free counters describing how well a kernel keeps up with real time.
+///
+/// Only the DSP thread records blocks; any thread may record mirror syncs or take a snapshot.
+/// Recording never waits, and a snapshot only retries if it races with the DSP thread.
+class Performance_counters {
+public:
+    /// `max_load` is taken over windows of `window_seconds` of audio.  If the sample rate is
+    /// unknown (zero), loads are reported as zero.
+    explicit Performance_counters(double sample_rate, double window_seconds = 1.);
+
+    Performance_counters(const Performance_counters&) = delete;
+    Performance_counters& operator=(const Performance_counters&) = delete;
+
+    /// DSP thread only.
+    void record_block(std::chrono::steady_clock::duration elapsed,
+                      size_t frame_count,
+                      size_t event_count);
+
+    void record_mirror_sync(bool found_changes);
+    void record_skipped_mirror_sync();
+
+    Performance_snapshot snapshot() const;
+
+private:
+    double sample_rate;
+    uint64_t window_frames;
+
+    // Owned by the DSP thread.
+    uint64_t frames_in_window = 0;
+    double window_max_load = 0.;
+    double previous_window_max_load = 0.;
+
+    // Odd while the DSP thread is writing the block counters below.
+    std::atomic<uint64_t> sequence = {0};
+
+    std::atomic<uint64_t> block_count = {0};
+    std::atomic<uint64_t> frame_count = {0};
+    std::atomic<int64_t> last_block_nanoseconds = {0};
+    std::atomic<double> load = {0.};
+    std::atomic<double> max_load = {0.};
+    std::atomic<double> peak_load = {0.};
+    std::atomic<uint64_t> overload_count = {0};
+    std::array<std::atomic<uint64_t>, Performance_snapshot::event_histogram_size>
+        events_per_block = {};
+
+    std::atomic<uint64_t> mirror_sync_count = {0};
+    std::atomic<uint64_t> mirror_sync_change_count = {0};
+    std::atomic<uint64_t> mirror_sync_skip_count = {0};
+};
+
+}
@@ -0,0 +1,81 @@
+#include "Brinicle/Thread/Realtime_checks.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+using namespace Brinicle;
+
+namespace {
+// Plain ints, so reading them from inside `malloc` can't itself allocate.
+thread_local int scope_depth = 0;
+
+std::atomic<uint64_t> allocation_count = {0};
+std::atomic<uint64_t> lock_count = {0};
+std::atomic<uint64_t> blocking_call_count = {0};
+std::atomic<const char*> first = {nullptr};
+std::atomic<bool> trap_enabled = {false};
+}
+
+static void write_to_stderr(const char* text) { (void)!::write(2, text, std::strlen(text)); }
+
+Realtime_checks::Scope::Scope() { ++scope_depth; }
+
+Realtime_checks::Scope::~Scope() { --scope_depth; }
+
+Realtime_checks::Allowed::Allowed() : depth(scope_depth) { scope_depth = 0; }
+
+Realtime_checks::Allowed::~Allowed() { scope_depth = depth; }
+
+bool Realtime_checks::in_scope() { return scope_depth > 0; }
+
+void Realtime_checks::check(Violation kind, const char* what)
+{
+    if (scope_depth <= 0) {
+        return;
+    }
+    // Whatever we call from here on must not be reported again.
+    Allowed allowed;
+
+    switch (kind) {
+    case Violation::allocation:
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Violation::lock:
+        lock_count.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Violation::blocking_call:
+        blocking_call_count.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    const char* expected = nullptr;
+    first.compare_exchange_strong(expected, what);
+
+    if (trap_enabled.load(std::memory_order_relaxed)) {
+        write_to_stderr("real-time violation on the audio thread: ");
+        write_to_stderr(what);
+        write_to_stderr("\n");
+        std::abort();
+    }
+}
+
+Realtime_checks::Counts Realtime_checks::counts()
+{
+    Counts ret;
+    ret.allocations = allocation_count.load();
+    ret.locks = lock_count.load();
+    ret.blocking_calls = blocking_call_count.load();
+    return ret;
+}
+
+const char* Realtime_checks::first_violation() { return first.load(); }
+
+void Realtime_checks::reset()
+{
+    allocation_count = 0;
+    lock_count = 0;
+    blocking_call_count = 0;
+    first = nullptr;
+}
+
+void Realtime_checks::set_trap(bool trap) { trap_enabled = trap; }
@@ -0,0 +1,76 @@
+#pragma once
+#include "Brinicle/Utilities/Macro_join.h"
+#include <cstdint>
+
+// Set to 1 to mark the render paths with `BRINICLE_REALTIME_SCOPE`.  Nothing is checked unless
+// the program also links `headless/Realtime_interposer.cpp`, which reports the calls that
+// aren't safe on the audio thread.
+#ifndef BRINICLE_REALTIME_CHECKS
+#define BRINICLE_REALTIME_CHECKS 0
+#endif
+
+namespace Brinicle {
+
+/// A debugging aid that finds heap allocations, lock acquisitions and blocking calls made on
+/// the audio thread.
+///
+/// Code that must be real-time safe runs inside a `Scope`, which just marks the calling
+/// thread.  Interposed versions of `malloc`, `pthread_mutex_lock` and friends call `check`,
+/// which records a violation if the calling thread is marked.
+namespace Realtime_checks {
+
+    enum class Violation { allocation, lock, blocking_call };
+
+    /// Marks the calling thread as real-time for its lifetime.  Scopes nest.
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /// Suspends the checks on the calling thread for its lifetime, e.g. for debug logging.
+    class Allowed {
+    public:
+        Allowed();
+        ~Allowed();
+        Allowed(const Allowed&) = delete;
+        Allowed& operator=(const Allowed&) = delete;
+
+    private:
+        int depth;
+    };
+
+    bool in_scope();
+
+    /// Records a violation by `what` (a string literal) if the calling thread is in a `Scope`.
+    void check(Violation kind, const char* what);
+
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t locks = 0;
+        uint64_t blocking_calls = 0;
+
+        uint64_t total() const { return allocations + locks + blocking_calls; }
+    };
+
+    /// Violations on any thread since the last `reset`.
+    Counts counts();
+
+    /// The `what` of the first violation since the last `reset`, or null if there was none.
+    const char* first_violation();
+
+    void reset();
+
+    /// If set, a violation prints its `what` to stderr and aborts, so a debugger stops on it.
+    void set_trap(bool trap);
+}
+}
+
+#if BRINICLE_REALTIME_CHECKS
+#define BRINICLE_REALTIME_SCOPE()                                                              \
+    ::Brinicle::Realtime_checks::Scope MACRO_JOIN(brinicle_realtime_scope_, __LINE__)
+#else
+#define BRINICLE_REALTIME_SCOPE()
+#endif
@@ -0,0 +1,306 @@
+#include "Brinicle/Thread/Render_graph.h"
+#include "Brinicle/Kernel/Buffer_ops.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Brinicle;
+
+static uint64_t pack_range(size_t begin, size_t end)
+{
+    return static_cast<uint64_t>(begin) << 32 | static_cast<uint64_t>(end);
+}
+
+Render_graph::Render_graph(Configuration configuration_)
+    : configuration(configuration_)
+    , thread_count_(configuration_.thread_count
+                        ? configuration_.thread_count
+                        : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+{
+    for (size_t thread = 1; thread < thread_count_; ++thread) {
+        workers.emplace_back([this, thread] { worker_main(thread); });
+    }
+}
+
+Render_graph::~Render_graph()
+{
+    {
+        std::lock_guard<std::mutex> guard(pool_lock);
+        stopping = true;
+    }
+    pool_wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+Render_graph::Node_id Render_graph::add_node(std::shared_ptr<Wrapped_kernel> kernel,
+                                             uint32_t channel_count)
+{
+    Node node;
+    node.kernel = std::move(kernel);
+    node.channel_count = channel_count;
+    nodes.push_back(std::move(node));
+    prepared = false;
+    return nodes.size() - 1;
+}
+
+void Render_graph::connect(Node_id from, Node_id to)
+{
+    if (from >= nodes.size() || to >= nodes.size()) {
+        throw std::out_of_range("Render_graph: unknown node");
+    }
+    nodes[to].input_edges.push_back(edges.size());
+    edges.push_back(Edge {from, to, 0, {}});
+    prepared = false;
+}
+
+void Render_graph::prepare()
+{
+    // Kahn's algorithm, one level at a time.
+    std::vector<size_t> unresolved_inputs(nodes.size());
+    std::vector<std::vector<Node_id>> outputs(nodes.size());
+    for (const auto& edge : edges) {
+        ++unresolved_inputs[edge.to];
+        outputs[edge.from].push_back(edge.to);
+    }
+
+    order.clear();
+    level_begin.clear();
+    for (Node_id id = 0; id < nodes.size(); ++id) {
+        if (unresolved_inputs[id] == 0) {
+            order.push_back(id);
+        }
+    }
+    size_t level_start = 0;
+    while (level_start < order.size()) {
+        level_begin.push_back(level_start);
+        const auto level_end = order.size();
+        for (auto index = level_start; index < level_end; ++index) {
+            for (auto output : outputs[order[index]]) {
+                if (--unresolved_inputs[output] == 0) {
+                    order.push_back(output);
+                }
+            }
+        }
+        level_start = level_end;
+    }
+    level_begin.push_back(order.size());
+    if (order.size() != nodes.size()) {
+        throw std::invalid_argument("Render_graph: graph has a cycle");
+    }
+
+    const size_t max_frames = configuration.max_frames_per_block;
+    for (auto id : order) {
+        auto& node = nodes[id];
+        uint64_t input_latency = 0;
+        for (auto edge : node.input_edges) {
+            input_latency = std::max(input_latency, nodes[edges[edge].from].latency);
+        }
+        for (auto edge_index : node.input_edges) {
+            auto& edge = edges[edge_index];
+            edge.delay = input_latency - nodes[edge.from].latency;
+            edge.history.assign(
+                edge.delay ? nodes[edge.from].channel_count * (edge.delay + max_frames) : 0, 0.f);
+        }
+        node.latency = input_latency + (node.kernel ? node.kernel->get_latency() : 0);
+
+        node.buffer.assign(node.channel_count * max_frames, 0.f);
+        node.pointers.resize(node.channel_count);
+        for (uint32_t channel = 0; channel < node.channel_count; ++channel) {
+            node.pointers[channel] = node.buffer.data() + channel * max_frames;
+        }
+        node.events.set_capacity(configuration.max_events_per_block);
+    }
+
+    const auto level_count = level_begin.size() - 1;
+    ranges = std::vector<Padded_atomic>(level_count * thread_count_);
+    remaining = std::vector<Padded_atomic>(level_count);
+    prepared = true;
+}
+
+float* Render_graph::channel(Node_id node, uint32_t channel)
+{
+    if (!prepared) {
+        throw std::logic_error("Render_graph: prepare must be called first");
+    }
+    return nodes.at(node).pointers.at(channel);
+}
+
+bool Render_graph::add_event(Node_id node, const Audio_event& event)
+{
+    if (!prepared) {
+        throw std::logic_error("Render_graph: prepare must be called first");
+    }
+    return nodes.at(node).events.push(event);
+}
+
+bool Render_graph::add_midi_packet(Node_id node,
+                                   int64_t buffer_offset_time,
+                                   uint8_t cable,
+                                   Midi_packet_format format,
+                                   const uint8_t* bytes,
+                                   size_t size)
+{
+    if (!prepared) {
+        throw std::logic_error("Render_graph: prepare must be called first");
+    }
+    return nodes.at(node).events.push_midi_packet(buffer_offset_time, cable, format, bytes, size);
+}
+
+void Render_graph::render(uint32_t frame_count_)
+{
+    if (!prepared) {
+        throw std::logic_error("Render_graph: prepare must be called first");
+    }
+    if (frame_count_ > configuration.max_frames_per_block) {
+        throw std::invalid_argument("Render_graph: block is larger than max_frames_per_block");
+    }
+    frame_count = frame_count_;
+
+    const auto level_count = level_begin.size() - 1;
+    for (size_t level = 0; level < level_count; ++level) {
+        const auto begin = level_begin[level];
+        const auto size = level_begin[level + 1] - begin;
+        for (size_t thread = 0; thread < thread_count_; ++thread) {
+            ranges[level * thread_count_ + thread].value.store(
+                pack_range(begin + size * thread / thread_count_,
+                           begin + size * (thread + 1) / thread_count_),
+                std::memory_order_relaxed);
+        }
+        remaining[level].value.store(size, std::memory_order_relaxed);
+    }
+    workers_done.value.store(0, std::memory_order_relaxed);
+
+    if (!workers.empty()) {
+        {
+            std::lock_guard<std::mutex> guard(pool_lock);
+            ++block_generation;
+        }
+        pool_wake.notify_all();
+    }
+    render_levels(0);
+
+    // Workers may still be looking for work to steal; the ranges can't be reset until
+    // they've all stopped.
+    while (workers_done.value.load(std::memory_order_acquire) != workers.size()) {
+        std::this_thread::yield();
+    }
+}
+
+void Render_graph::worker_main(size_t thread)
+{
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pool_lock);
+            pool_wake.wait(lock, [&] { return stopping || block_generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = block_generation;
+        }
+        render_levels(thread);
+        workers_done.value.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void Render_graph::render_levels(size_t thread)
+{
+    const auto level_count = level_begin.size() - 1;
+    for (size_t level = 0; level < level_count; ++level) {
+        size_t index;
+        while (take_node(level, thread, index)) {
+            run_node(nodes[order[index]]);
+            remaining[level].value.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        while (remaining[level].value.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool Render_graph::take_node(size_t level, size_t thread, size_t& index)
+{
+    // Our own work comes off the front of our range, and stolen work off the back of others',
+    // so that owner and thieves rarely contend.
+    auto& own = ranges[level * thread_count_ + thread].value;
+    auto range = own.load(std::memory_order_relaxed);
+    while ((range >> 32) < (range & 0xffffffff)) {
+        if (own.compare_exchange_weak(range, range + (uint64_t(1) << 32))) {
+            index = range >> 32;
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < thread_count_; ++offset) {
+        auto& victim = ranges[level * thread_count_ + (thread + offset) % thread_count_].value;
+        range = victim.load(std::memory_order_relaxed);
+        while ((range >> 32) < (range & 0xffffffff)) {
+            if (victim.compare_exchange_weak(range, range - 1)) {
+                index = (range & 0xffffffff) - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Render_graph::sum_inputs(Node& node)
+{
+    const size_t max_frames = configuration.max_frames_per_block;
+    if (node.input_edges.empty()) {
+        if (node.kernel) {
+            for (auto pointer : node.pointers) {
+                Buffer_ops::clear(pointer, frame_count);
+            }
+        }
+        return;
+    }
+
+    bool first = true;
+    for (auto edge_index : node.input_edges) {
+        auto& edge = edges[edge_index];
+        const auto& from = nodes[edge.from];
+
+        if (edge.delay) {
+            for (uint32_t channel = 0; channel < from.channel_count; ++channel) {
+                auto history = edge.history.data() + channel * (edge.delay + max_frames);
+                std::copy(from.pointers[channel],
+                          from.pointers[channel] + frame_count,
+                          history + edge.delay);
+            }
+        }
+        for (uint32_t channel = 0; channel < node.channel_count; ++channel) {
+            const auto from_channel = channel % from.channel_count;
+            const float* source = edge.delay
+                ? edge.history.data() + from_channel * (edge.delay + max_frames)
+                : from.pointers[from_channel];
+            auto destination = node.pointers[channel];
+            if (first) {
+                Buffer_ops::copy(source, destination, frame_count);
+            } else {
+                Buffer_ops::add(source, destination, frame_count);
+            }
+        }
+        if (edge.delay) {
+            for (uint32_t channel = 0; channel < from.channel_count; ++channel) {
+                auto history = edge.history.data() + channel * (edge.delay + max_frames);
+                std::memmove(history, history + frame_count, edge.delay * sizeof(float));
+            }
+        }
+        first = false;
+    }
+}
+
+void Render_graph::run_node(Node& node)
+{
+    sum_inputs(node);
+    if (node.kernel) {
+        node.kernel->sync_from_dsp_thread();
+        node.kernel->process(
+            Deinterleaved_audio {node.channel_count, frame_count, node.pointers.data()},
+            node.events.span());
+    }
+    node.events.clear();
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "Brinicle/Thread/Wrapped_kernel.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Brinicle {
+
+/// Renders a graph of many kernels each block, spreading the work over a pool of threads.
+///
+/// Each node owns a buffer and processes it in place.  Before that, the buffer is set to
+/// the sum of the node's inputs, so mixing is simply a node with several inputs and no
+/// kernel.  Nodes with no inputs are the graph's sources: with a kernel (e.g. an
+/// instrument) they start each block silent, and without one they're external inputs,
+/// keeping whatever was written to their channels.
+///
+/// Inputs are delayed as needed so that everything arriving at a node lines up, using each
+/// kernel's latency as of `prepare`.
+///
+/// Nodes are grouped into levels, where every node only depends on earlier levels.  A level's
+/// nodes are split evenly between the threads up front, and threads that run out of work
+/// steal from the others.  `render` wakes the pool through a condition variable, so this is
+/// meant for offline rendering and test rigs rather than a real-time audio thread.
+class Render_graph {
+public:
+    using Node_id = size_t;
+
+    struct Configuration {
+        uint32_t max_frames_per_block;
+        size_t max_events_per_block = Audio_event_buffer::default_capacity;
+
+        /// Threads rendering each block, including the one calling `render`.  Zero means
+        /// one per core.
+        size_t thread_count = 0;
+    };
+
+    explicit Render_graph(Configuration configuration);
+    ~Render_graph();
+
+    Render_graph(const Render_graph&) = delete;
+    Render_graph& operator=(const Render_graph&) = delete;
+
+    Node_id add_node(std::shared_ptr<Wrapped_kernel> kernel, uint32_t channel_count);
+    Node_id add_input(uint32_t channel_count) { return add_node(nullptr, channel_count); }
+    Node_id add_mix(uint32_t channel_count) { return add_node(nullptr, channel_count); }
+
+    /// Channel `c` of `to` receives channel `c` of `from`, wrapping around if `from` has fewer
+    /// channels (so mono inputs feed every channel).
+    void connect(Node_id from, Node_id to);
+
+    /// Must be called after changing the graph, or when kernel latencies change, and before
+    /// the next `render`.  Throws `std::invalid_argument` if the graph has a cycle.
+    void prepare();
+
+    /// Renders one block.  Afterwards, each node's channels hold its output.
+    void render(uint32_t frame_count);
+
+    uint32_t channel_count(Node_id node) const { return nodes.at(node).channel_count; }
+    float* channel(Node_id node, uint32_t channel);
+
+    /// Schedule an event for `node` in the next `render`.  Returns false (and drops the
+    /// event) if the node's block is already full.
+    bool add_event(Node_id node, const Audio_event& event);
+
+    /// Schedule a sysex message or MIDI 2.0 packets for `node` in the next `render`, copying
+    /// `size` bytes into the node's payload.  Returns false (and drops them) if the node's
+    /// block is already full.
+    bool add_midi_packet(Node_id node,
+                         int64_t buffer_offset_time,
+                         uint8_t cable,
+                         Midi_packet_format format,
+                         const uint8_t* bytes,
+                         size_t size);
+
+    /// The total latency of `node`'s output, as of `prepare`.
+    uint64_t latency(Node_id node) const { return nodes.at(node).latency; }
+
+    size_t thread_count() const { return thread_count_; }
+
+private:
+    struct Node {
+        std::shared_ptr<Wrapped_kernel> kernel;
+        uint32_t channel_count;
+        std::vector<size_t> input_edges;
+        Audio_event_buffer events;
+        std::vector<float> buffer;
+        std::vector<float*> pointers;
+        uint64_t latency = 0;
+    };
+
+    struct Edge {
+        Node_id from;
+        Node_id to;
+        uint64_t delay = 0;
+
+        // `delay` frames of history per channel, followed by room for a block.
+        std::vector<float> history;
+    };
+
+    // Kept on their own cache lines, since every thread hammers them.
+    struct alignas(64) Padded_atomic {
+        std::atomic<uint64_t> value {0};
+    };
+
+    void sum_inputs(Node& node);
+    void run_node(Node& node);
+    bool take_node(size_t level, size_t thread, size_t& index);
+    void render_levels(size_t thread);
+    void worker_main(size_t thread);
+
+    Configuration configuration;
+    size_t thread_count_;
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+
+    // Node ids sorted by level; level `l` is `order[level_begin[l], level_begin[l + 1])`.
+    std::vector<Node_id> order;
+    std::vector<size_t> level_begin;
+    bool prepared = false;
+
+    // Per block state.  `ranges[level * thread_count_ + thread]` packs the `[begin, end)`
+    // part of `order` that thread still has to run, as `begin << 32 | end`.
+    uint32_t frame_count = 0;
+    std::vector<Padded_atomic> ranges;
+    std::vector<Padded_atomic> remaining;
+    Padded_atomic workers_done;
+
+    std::mutex pool_lock;
+    std::condition_variable pool_wake;
+    uint64_t block_generation = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+}
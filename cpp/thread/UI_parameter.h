@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Brinicle/Kernel/Parameter.h"
+#include <memory>
 
 namespace Brinicle {
 /// Represents a parameter that is being interacted with.
@@ -1,17 +1,44 @@
 #include "Brinicle/Thread/Wrapped_kernel.h"
+#include "Brinicle/Thread/Realtime_checks.h"
+#include "Brinicle/Utilities/Overload.h"
+#include <algorithm>
 
 using namespace std;
 using namespace Brinicle;
 
 Wrapped_kernel::Wrapped_kernel(std::unique_ptr<Kernel> kernel,
-                               const std::vector<Parameter_info>& parameters,
-                               std::weak_ptr<Host_interface> client)
+                               std::shared_ptr<const Parameter_registry> registry_,
+                               std::weak_ptr<Host_interface> client,
+                               double sample_rate)
     : kernel(std::move(kernel))
-    , mirror(parameters)
-    , grab_mirror(parameters)
+    , registry(std::move(registry_))
+    , mirror(registry)
+    , grab_mirror(registry)
+    , pending_values(registry->size())
+    , pending_dirty(registry->size())
+    , kernel_reports_changes(this->kernel->reports_changes())
+    , touched(registry->size())
+    , recheck_dirty(registry->size())
+    , published_values(registry->size())
+    , dsp_published_values(registry->size())
+    , published_latency(this->kernel->get_latency())
+    , published_dirty(registry->size())
+    , performance_counters(sample_rate)
     , threaded_ui_parameter_set(this)
     , client(client)
 {
+    for (auto& slot : state_slots) {
+        slot.values.resize(registry->size());
+        slot.present.resize(registry->size());
+    }
+    ramp_events.reserve(registry->size() + Audio_event_buffer::default_capacity);
+    touched_indices.reserve(registry->size());
+    for (size_t index = 0; index < registry->size(); ++index) {
+        dsp_published_values[index] = this->kernel->get_parameter(registry->address(index));
+        published_values[index].store(dsp_published_values[index]);
+        published_dirty.mark(index);
+        mirror.set_from_dsp_thread(index, dsp_published_values[index]);
+    }
 }
 
 Wrapped_kernel::~Wrapped_kernel() {}
@@ -54,59 +81,273 @@ float Wrapped_kernel::Threaded_ui_parameter_set::get_parameter(uint64_t identifi
     return kernel->mirror.get_from_ui_thread(identifier);
 }
 
-uint64_t Wrapped_kernel::get_latency() const
-{
-    lock_guard<mutex> guard(dsp_lock);
-    return kernel->get_latency();
-}
+uint64_t Wrapped_kernel::get_latency() const { return published_latency.load(); }
 
 void Wrapped_kernel::sync_from_dsp_thread()
 {
     last_dsp_sync_time = std::chrono::steady_clock::now();
-    {
-        lock_guard<mutex> guard(dsp_lock);
-        mirror.sync_from_dsp_thread(
-            [=](uint64_t address, float value) { kernel->set_parameter(address, value); },
-            [=](uint64_t address) { return kernel->get_parameter(address); });
+    if (mirror_sync_in_progress.test_and_set(std::memory_order_acquire)) {
+        performance_counters.record_skipped_mirror_sync();
+        return;
     }
+    bool found_changes = false;
+    mirror.sync_from_dsp_thread([&](uint64_t address, float value) {
+        found_changes = true;
+        set_parameter(address, value);
+    });
+    performance_counters.record_mirror_sync(found_changes);
     auto locked_client = client.lock();
+    // The host should see the final value of a gesture before the gesture ends.
+    grab_mirror.check_pending_gestures_from_dsp_thread(
+        [&locked_client](uint64_t address) {
+            if (locked_client) {
+                locked_client->grab(address);
+            }
+        },
+        [&locked_client](uint64_t address) {
+            if (locked_client) {
+                locked_client->update_host();
+                locked_client->ungrab(address);
+            }
+        });
     if (locked_client) {
-        {
-            lock_guard<mutex> guard(dsp_lock);
-            grab_mirror.check_pending_grabs_from_dsp_thread(
-                [&locked_client](uint64_t address) { locked_client->grab(address); });
-        }
         locked_client->update_host();
-        {
-            lock_guard<mutex> guard(dsp_lock);
-            grab_mirror.check_pending_ungrabs_from_dsp_thread(
-                [&locked_client](uint64_t address) { locked_client->ungrab(address); });
-        }
     }
+    mirror_sync_in_progress.clear(std::memory_order_release);
 }
 
 void Wrapped_kernel::set_parameter(uint64_t identifier, float value)
 {
-    lock_guard<mutex> guard(dsp_lock);
-    kernel->set_parameter(identifier, value);
+    const auto index = registry->index_of(identifier);
+    if (index == Parameter_registry::npos) {
+        return;
+    }
+    // Published first, so the DSP thread sees it when it applies the change.
+    pending_values[index].store(value, std::memory_order_relaxed);
+    published_values[index].store(value);
+    pending_dirty.mark(index);
+    published_dirty.mark(index);
 }
 
 float Wrapped_kernel::get_parameter(uint64_t identifier) const
 {
-    lock_guard<mutex> guard(dsp_lock);
-    return kernel->get_parameter(identifier);
+    const auto index = registry->index_of(identifier);
+    if (index == Parameter_registry::npos) {
+        return 0.f;
+    }
+    return published_values[index].load();
+}
+
+void Wrapped_kernel::reset() { reset_requested.store(true); }
+
+template <typename F> void Wrapped_kernel::publish_state(F fill, uint32_t ramp_frames)
+{
+    lock_guard<mutex> guard(state_lock);
+    auto& slot = state_slots[state_writer_slot];
+    std::fill(begin(slot.present), end(slot.present), uint8_t(0));
+    fill([&](size_t index, float value) {
+        slot.values[index] = value;
+        slot.present[index] = 1;
+        published_values[index].store(value);
+        published_dirty.mark(index);
+        recheck_dirty.mark(index);
+    });
+    slot.ramp_frames = ramp_frames;
+    const auto fresh = static_cast<uint8_t>(state_writer_slot | state_fresh);
+    state_writer_slot = state_exchange.exchange(fresh, std::memory_order_acq_rel) & ~state_fresh;
+}
+
+void Wrapped_kernel::set_state(const Parameter_state& state, uint32_t ramp_frames)
+{
+    publish_state(
+        [&](auto set) {
+            for (const auto& [address, value] : state) {
+                const auto index = registry->index_of(address);
+                if (index != Parameter_registry::npos) {
+                    set(index, value);
+                }
+            }
+        },
+        ramp_frames);
+}
+
+void Wrapped_kernel::set_state(const Dense_parameter_state& state, uint32_t ramp_frames)
+{
+    publish_state(
+        [&](auto set) {
+            for (size_t index = 0; index < registry->size(); ++index) {
+                set(index, state[index]);
+            }
+        },
+        ramp_frames);
+}
+
+void Wrapped_kernel::set_state(const Preset_codec& codec,
+                               const Preset_view& preset,
+                               uint32_t ramp_frames)
+{
+    publish_state(
+        [&](auto set) {
+            codec.read(preset, [&](uint64_t address, float value) {
+                const auto index = registry->index_of(address);
+                if (index != Parameter_registry::npos) {
+                    set(index, value);
+                }
+            });
+        },
+        ramp_frames);
+}
+
+Audio_event_span Wrapped_kernel::apply_published_state_from_dsp_thread(Audio_event_span events)
+{
+    if (!(state_exchange.load(std::memory_order_relaxed) & state_fresh)) {
+        return events;
+    }
+    state_dsp_slot = state_exchange.exchange(static_cast<uint8_t>(state_dsp_slot),
+                                             std::memory_order_acq_rel)
+        & ~state_fresh;
+    const auto& slot = state_slots[state_dsp_slot];
+
+    // If the block's events wouldn't fit after the ramps, jump rather than allocate.
+    const bool ramp = slot.ramp_frames != 0
+        && events.size() <= ramp_events.capacity() - registry->size();
+    ramp_events.clear();
+    for (size_t index = 0; index < registry->size(); ++index) {
+        if (!slot.present[index]) {
+            continue;
+        }
+        applied_from_dsp_thread(index, slot.values[index]);
+        const auto address = registry->address(index);
+        if (!ramp) {
+            kernel->set_parameter(address, slot.values[index]);
+        } else if (kernel->get_parameter(address) != slot.values[index]) {
+            ramp_events.push_back(
+                Ramped_parameter_change {0, address, slot.values[index], slot.ramp_frames});
+        }
+    }
+    if (!ramp) {
+        return events;
+    }
+    ramp_events.insert(end(ramp_events), events.begin(), events.end());
+    return Audio_event_span(ramp_events.data(), ramp_events.size(), events.payload());
+}
+
+void Wrapped_kernel::apply_pending_changes_from_dsp_thread()
+{
+    if (reset_requested.exchange(false)) {
+        kernel->reset();
+        // Nothing promises a reset leaves the parameters alone.
+        publish_all = true;
+    }
+    recheck_dirty.drain([this](size_t index) {
+        dsp_published_values[index] = published_values[index].load();
+        touch_from_dsp_thread(index);
+    });
+    pending_dirty.drain([this](size_t index) {
+        const auto value = pending_values[index].load(std::memory_order_relaxed);
+        kernel->set_parameter(registry->address(index), value);
+        applied_from_dsp_thread(index, value);
+    });
+}
+
+void Wrapped_kernel::applied_from_dsp_thread(size_t index, float value)
+{
+    // The value was published when it was set, so only a newer one should win over the
+    // kernel's after the block.
+    dsp_published_values[index] = value;
+    mirror.set_from_dsp_thread(index, value);
+    touch_from_dsp_thread(index);
+}
+
+void Wrapped_kernel::touch_from_dsp_thread(size_t index)
+{
+    if (!touched[index]) {
+        touched[index] = 1;
+        touched_indices.push_back(index);
+    }
+}
+
+void Wrapped_kernel::touch_address_from_dsp_thread(uint64_t address)
+{
+    const auto index = registry->index_of(address);
+    if (index != Parameter_registry::npos) {
+        touch_from_dsp_thread(index);
+    }
+}
+
+void Wrapped_kernel::touch_events_from_dsp_thread(Audio_event_span events)
+{
+    for (const auto& event : events) {
+        std::visit(overload {[this](const Parameter_change& change) {
+                                 touch_address_from_dsp_thread(change.address);
+                             },
+                             [this](const Ramped_parameter_change& change) {
+                                 touch_address_from_dsp_thread(change.address);
+                             },
+                             [](const Midi_message&) {},
+                             [](const Midi_packet&) {}},
+                   event);
+    }
 }
 
-void Wrapped_kernel::reset()
+void Wrapped_kernel::publish_from_dsp_thread(size_t index)
 {
-    lock_guard<mutex> guard(dsp_lock);
-    kernel->reset();
+    const auto value = kernel->get_parameter(registry->address(index));
+    auto expected = dsp_published_values[index];
+    if (value == expected && published_values[index].load(std::memory_order_relaxed) == expected) {
+        return;
+    }
+    // If another thread has set this parameter since we last published, its value is newer
+    // than the kernel's, so leave it be - it will reach the kernel next block.  Check again
+    // then, in case it doesn't.
+    if (published_values[index].compare_exchange_strong(expected, value)) {
+        dsp_published_values[index] = value;
+    } else {
+        dsp_published_values[index] = expected;
+        recheck_dirty.mark(index);
+    }
+    published_dirty.mark(index);
+    mirror.set_from_dsp_thread(index, dsp_published_values[index]);
 }
 
-void Wrapped_kernel::process(Deinterleaved_audio interleaved_audio, Audio_event_generator events)
+void Wrapped_kernel::publish_from_dsp_thread(bool latency_changed)
 {
-    lock_guard<mutex> guard(dsp_lock);
-    kernel->process(std::move(interleaved_audio), std::move(events));
+    if (!kernel_reports_changes || publish_all) {
+        for (size_t index = 0; index < registry->size(); ++index) {
+            publish_from_dsp_thread(index);
+        }
+    } else {
+        for (auto index : touched_indices) {
+            publish_from_dsp_thread(index);
+        }
+    }
+    for (auto index : touched_indices) {
+        touched[index] = 0;
+    }
+    touched_indices.clear();
+    if (!kernel_reports_changes || publish_all || latency_changed) {
+        published_latency.store(kernel->get_latency());
+    }
+    publish_all = false;
+}
+
+void Wrapped_kernel::process(Deinterleaved_audio interleaved_audio, Audio_event_span events)
+{
+    BRINICLE_REALTIME_SCOPE();
+    const auto start = std::chrono::steady_clock::now();
+    const auto frame_count = interleaved_audio.frame_count;
+    apply_pending_changes_from_dsp_thread();
+    kernel->process(std::move(interleaved_audio), apply_published_state_from_dsp_thread(events));
+    bool latency_changed = false;
+    if (kernel_reports_changes) {
+        touch_events_from_dsp_thread(events);
+        latency_changed = kernel->take_changes(this, [](void* context, uint64_t address) {
+            static_cast<Wrapped_kernel*>(context)->touch_address_from_dsp_thread(address);
+        });
+    }
+    publish_from_dsp_thread(latency_changed);
+    performance_counters.record_block(
+        std::chrono::steady_clock::now() - start, frame_count, events.size());
 }
 
 std::chrono::seconds Wrapped_kernel::dsp_disabled_duration = 1s;
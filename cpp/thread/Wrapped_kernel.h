@@ -1,15 +1,27 @@
 #pragma once
 #include "Brinicle/Kernel/Kernel.h"
+#include "Brinicle/Kernel/Parameter_registry.h"
+#include "Brinicle/Kernel/Preset.h"
+#include "Brinicle/Thread/Dirty_set.h"
 #include "Brinicle/Thread/Event_stream.h"
 #include "Brinicle/Thread/Grab_mirror.h"
 #include "Brinicle/Thread/Param_mirror.h"
+#include "Brinicle/Thread/Performance_counters.h"
 #include "Brinicle/Thread/UI_parameter.h"
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <mutex>
+#include <vector>
 
 namespace Brinicle {
 /// Wraps a kernel to allow access from multiple threads.
+///
+/// The kernel itself is only ever touched from `process`, and nothing the DSP thread calls
+/// here takes a lock or waits on another thread.  Other threads see snapshots of the
+/// kernel's parameters and latency, published after each block, and their parameter
+/// changes and resets are handed to the DSP thread through atomics, to be applied at the
+/// start of the next block.
 class Wrapped_kernel : public Parameter_set {
 public:
     class Host_interface {
@@ -27,9 +39,11 @@ public:
         virtual void ungrab(uint64_t) {}
     };
 
+    /// `registry` indexes the kernel's parameters; share the factory's `parameter_registry()`.
     Wrapped_kernel(std::unique_ptr<Kernel> kernel,
-                   const std::vector<Parameter_info>& parameters,
-                   std::weak_ptr<Host_interface> client);
+                   std::shared_ptr<const Parameter_registry> registry,
+                   std::weak_ptr<Host_interface> client,
+                   double sample_rate);
     ~Wrapped_kernel();
 
     UI_parameter_set& ui_parameter_set() { return threaded_ui_parameter_set; }
@@ -52,20 +66,125 @@ public:
         }
     }
 
+    /// If another thread is already syncing, this returns immediately without syncing.
     void sync_from_dsp_thread();
 
+    /// May be called from any thread; takes effect at the start of the next `process`.
     void set_parameter(uint64_t identifier, float value) override;
-    uint64_t get_latency() const;
+
+    /// As of the last `process` (or `set_parameter`, whichever was later).
     float get_parameter(uint64_t identifier) const override;
+
+    /// As of the last `process`, so a latency changed by `set_parameter` or `reset` is only
+    /// seen once a block has been rendered.
+    uint64_t get_latency() const;
+
+    /// Calls `f(address, value)` for each parameter whose value seen by `get_parameter` may
+    /// have changed since the last call, and for every parameter on the first call.  Only one
+    /// thread at a time may call this.
+    template <typename F> void take_parameter_changes(F f)
+    {
+        published_dirty.drain([&](size_t index) {
+            f(registry->address(index), published_values[index].load());
+        });
+    }
+
+    /// May be called from any thread, but doesn't reset the kernel right away: that happens at
+    /// the start of the next `process`, on the DSP thread.  Until then, the kernel keeps its
+    /// state, and `get_parameter` and `get_latency` report values from before the reset.
     void reset();
-    void process(Deinterleaved_audio interleaved_audio, Audio_event_generator events);
+
+    /// Replaces every parameter in `state` at once.  May be called from any thread but the DSP
+    /// thread, and never waits for it; the whole state takes effect at the start of the next
+    /// `process`, after any changes from `set_parameter`.  If another state is set before
+    /// then, only the newer one is applied.  A non-zero `ramp_frames` sends the kernel a
+    /// `Ramped_parameter_change` to each new value over that many frames, instead of setting
+    /// it.  This isn't a crossfade of the audio: kernels that jump to a ramp's target, as the
+    /// template and most rust kernels do, will still click.
+    void set_state(const Parameter_state& state, uint32_t ramp_frames = 0);
+
+    /// As above, with a value for every parameter, in the order of the `Parameter_info` list.
+    void set_state(const Dense_parameter_state& state, uint32_t ramp_frames = 0);
+
+    /// As above, reading the values straight from a binary preset, without allocating.
+    void set_state(const Preset_codec& codec,
+                   const Preset_view& preset,
+                   uint32_t ramp_frames = 0);
+
+    void process(Deinterleaved_audio interleaved_audio, Audio_event_span events);
+
+    /// Timing and event counts for `process`, and counts of mirror syncs.  May be called from
+    /// any thread; it never blocks the DSP thread.
+    Performance_snapshot performance() const { return performance_counters.snapshot(); }
 
 private:
+    // A full state, stored densely; `present` marks the parameters it sets.
+    struct State_slot {
+        std::vector<float> values;
+        std::vector<uint8_t> present;
+        uint32_t ramp_frames = 0;
+    };
+
+    template <typename F> void publish_state(F fill, uint32_t ramp_frames);
+    Audio_event_span apply_published_state_from_dsp_thread(Audio_event_span events);
+    void apply_pending_changes_from_dsp_thread();
+    void touch_events_from_dsp_thread(Audio_event_span events);
+    void applied_from_dsp_thread(size_t index, float value);
+    void touch_from_dsp_thread(size_t index);
+    void touch_address_from_dsp_thread(uint64_t address);
+    void publish_from_dsp_thread(bool latency_changed);
+    void publish_from_dsp_thread(size_t index);
+
     std::unique_ptr<Kernel> kernel;
+
+    // Parameters are stored densely, in the order they were declared.
+    std::shared_ptr<const Parameter_registry> registry;
+
     Param_mirror mirror;
     Grab_mirror grab_mirror;
     mutable std::recursive_mutex ui_lock;
-    mutable std::mutex dsp_lock;
+
+    // Values set from other threads but not yet applied to the kernel.  An index in
+    // `pending_dirty` means the matching `pending_values` entry must be applied.
+    std::vector<std::atomic<float>> pending_values;
+    Dirty_set pending_dirty;
+    std::atomic<bool> reset_requested = {false};
+
+    // States set from other threads, triple buffered.  A thread setting a state fills
+    // `state_slots[state_writer_slot]`, then swaps it for the slot in `state_exchange`, marked
+    // `state_fresh`; the DSP thread swaps its own slot for that one when it sees the mark.
+    std::array<State_slot, 3> state_slots;
+    std::mutex state_lock;
+    size_t state_writer_slot = 0;
+    size_t state_dsp_slot = 1;
+    std::atomic<uint8_t> state_exchange = {2};
+    static constexpr uint8_t state_fresh = 4;
+
+    // Ramps to a newly set state, followed by the block's own events.
+    std::vector<Audio_event> ramp_events;
+
+    // If the kernel reports its own changes, only the parameters touched during a block - by
+    // pending changes, states, events, or the kernel itself - are published after it.
+    // `recheck_dirty` marks published values the kernel may never follow: those of a state
+    // replaced before the DSP thread applied it, or that raced with a block.
+    bool kernel_reports_changes;
+    bool publish_all = true;
+    std::vector<uint8_t> touched;
+    std::vector<size_t> touched_indices;
+    Dirty_set recheck_dirty;
+
+    // Snapshots readable from any thread.  `dsp_published_values` is what the DSP thread
+    // last published, so it can tell whether another thread has written since.
+    std::vector<std::atomic<float>> published_values;
+    std::vector<float> dsp_published_values;
+    std::atomic<uint64_t> published_latency;
+    Dirty_set published_dirty;
+
+    // Held while the mirrors are being synced, by whichever thread is doing it.
+    std::atomic_flag mirror_sync_in_progress = ATOMIC_FLAG_INIT;
+
+    Performance_counters performance_counters;
+
     static std::chrono::seconds dsp_disabled_duration;
     std::atomic<std::chrono::time_point<std::chrono::steady_clock>> last_dsp_sync_time = {
         std::chrono::time_point<std::chrono::steady_clock>::min()};
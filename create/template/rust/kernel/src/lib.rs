@@ -42,6 +42,7 @@ fn handle_event(kernel: &mut Kernel, data: event::Data) {
             kernel.set_parameter(address, value)
         }
         event::Data::MIDIMessage { .. } => {}
+        _ => {}
     }
 }
 
@@ -28,7 +28,12 @@ where
     true
 }
 
-pub type SubBufferMut<'a> = SmallVec<[&'a mut [f32]; 8]>;
+/// How many channels a `SubBufferMut` or `SubBuffer` holds inline, on the stack.  Slicing a
+/// buffer with more channels than this allocates; slice wide formats, such as ambisonics,
+/// through a `ChannelTable` instead.
+pub const MAX_INLINE_CHANNELS: usize = 8;
+
+pub type SubBufferMut<'a> = SmallVec<[&'a mut [f32]; MAX_INLINE_CHANNELS]>;
 
 impl<'c, 'a: 'c> AudioBufferMut<'c, 'a> {
     pub fn new(buf: &'c mut [&'a mut [f32]]) -> AudioBufferMut<'c, 'a> {
@@ -84,6 +89,64 @@ impl<'d, 'c: 'd, 'a: 'c> From<&'d mut AudioBufferMut<'c, 'a>> for AudioBufferMut
     }
 }
 
+/// Room for a table of channels, allocated up front, so that buffers with more channels than
+/// `SubBufferMut` holds inline can be sliced on the audio thread without allocating.
+pub struct ChannelTable {
+    // Always empty between uses; only its allocation is kept.
+    spare: Vec<&'static mut [f32]>,
+}
+
+// Empties `table`, keeping its allocation for references with another lifetime.
+fn reuse<'x, 'y>(mut table: Vec<&'x mut [f32]>) -> Vec<&'y mut [f32]> {
+    table.clear();
+    // The table is empty, so no reference outlives its lifetime.
+    unsafe { std::mem::transmute(table) }
+}
+
+impl ChannelTable {
+    pub fn with_capacity(channels: usize) -> ChannelTable {
+        ChannelTable {
+            spare: Vec::with_capacity(channels),
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.spare.capacity()
+    }
+
+    /// Calls `f` with a buffer of `channels`, which must all be the same length.  Only
+    /// allocates if there are more channels than the capacity.
+    pub fn with_channels<'a, I, F, R>(&mut self, channels: I, f: F) -> R
+    where
+        I: Iterator<Item = &'a mut [f32]>,
+        F: for<'c> FnOnce(AudioBufferMut<'c, 'a>) -> R,
+    {
+        let mut table = reuse(std::mem::replace(&mut self.spare, Vec::new()));
+        table.extend(channels);
+        let ret = f(AudioBufferMut::new(&mut table));
+        self.spare = reuse(table);
+        ret
+    }
+
+    /// Like `AudioBufferMut::slice`, but calls `f` with the slice rather than returning it.
+    pub fn slice<'d, F, R>(
+        &mut self,
+        buf: &'d mut AudioBufferMut<'_, '_>,
+        range: Range<usize>,
+        f: F,
+    ) -> R
+    where
+        F: for<'c> FnOnce(AudioBufferMut<'c, 'd>) -> R,
+    {
+        self.with_channels(
+            buf.buf
+                .iter_mut()
+                .map(|chan| (*chan).index_mut(range.clone())),
+            f,
+        )
+    }
+}
+
 pub struct IterMut<'c, 'a: 'c> {
     iter: std::slice::IterMut<'c, &'a mut [f32]>,
 }
@@ -127,7 +190,7 @@ pub struct AudioBuffer<'c, 'a: 'c> {
     buf: &'c [&'a [f32]],
 }
 
-pub type SubBuffer<'a> = SmallVec<[&'a [f32]; 8]>;
+pub type SubBuffer<'a> = SmallVec<[&'a [f32]; MAX_INLINE_CHANNELS]>;
 
 impl<'c, 'a: 'c> AudioBuffer<'c, 'a> {
     pub fn new(buf: &'c [&'a [f32]]) -> AudioBuffer<'c, 'a> {
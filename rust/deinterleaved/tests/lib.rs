@@ -0,0 +1,34 @@
+use brinicle_deinterleaved::*;
+
+const WIDE: usize = MAX_INLINE_CHANNELS * 2;
+
+#[test]
+fn channel_table_slices_every_channel() {
+    let mut storage = vec![vec![0f32; 8]; WIDE];
+    let mut channels: Vec<&mut [f32]> = storage.iter_mut().map(|chan| &mut chan[..]).collect();
+    let mut buf = AudioBufferMut::new(&mut channels);
+    let mut table = ChannelTable::with_capacity(WIDE);
+    table.slice(&mut buf, 2..5, |mut sub| {
+        assert_eq!(sub.num_channels(), WIDE);
+        assert_eq!(sub.len(), 3);
+        for (index, chan) in (&mut sub).into_iter().enumerate() {
+            chan.iter_mut().for_each(|x| *x = index as f32);
+        }
+    });
+    for (index, chan) in storage.iter().enumerate() {
+        let i = index as f32;
+        assert_eq!(chan[..], [0., 0., i, i, i, 0., 0., 0.]);
+    }
+}
+
+#[test]
+fn channel_table_keeps_its_allocation() {
+    let mut storage = vec![vec![0f32; 4]; WIDE];
+    let mut table = ChannelTable::with_capacity(WIDE);
+    for block in 0..3 {
+        let channels = storage.iter_mut().map(|chan| &mut chan[..]);
+        table.with_channels(channels, |mut buf| buf[0][0] = block as f32);
+        assert_eq!(table.capacity(), WIDE);
+    }
+    assert_eq!(storage[0][0], 2.);
+}
@@ -1,9 +1,9 @@
 use brinicle_kernel::event;
 use brinicle_kernel::parameter::*;
+use brinicle_kernel::ChannelTable;
 use brinicle_kernel::Kernel;
 use libc::c_char;
 use libc::c_void;
-use smallvec::SmallVec;
 use std::ffi::CString;
 
 fn convert_unit(unit: &Unit) -> u64 {
@@ -163,52 +163,124 @@ pub fn get_kernel_type<K: Kernel>() -> u32 {
     K::info().kernel_type as u32
 }
 
-pub fn create_kernel<K: Kernel>(input_count: u32, output_count: u32, sample_rate: f64) -> *mut K {
-    Box::into_raw(Box::new(K::new(brinicle_kernel::AudioFormat {
-        input_channel_count: input_count,
-        output_channel_count: output_count,
-        sample_rate,
-    })))
+/// What C holds for each kernel: the kernel, and a table for its channels, allocated along with
+/// it so that processing doesn't allocate however many channels there are.
+pub struct GlueKernel<K> {
+    kernel: K,
+    channels: ChannelTable,
 }
 
-pub unsafe fn delete_kernel<K: Kernel>(k: *mut K) {
+pub fn create_kernel<K: Kernel>(
+    input_count: u32,
+    output_count: u32,
+    sample_rate: f64,
+) -> *mut GlueKernel<K> {
+    Box::into_raw(Box::new(GlueKernel {
+        kernel: K::new(brinicle_kernel::AudioFormat {
+            input_channel_count: input_count,
+            output_channel_count: output_count,
+            sample_rate,
+        }),
+        channels: ChannelTable::with_capacity(input_count.max(output_count) as usize),
+    }))
+}
+
+pub unsafe fn delete_kernel<K: Kernel>(k: *mut GlueKernel<K>) {
     Box::from_raw(k);
 }
 
-pub unsafe fn set_kernel_parameter<K: Kernel>(k: *mut K, address: u64, value: f64) {
-    let k2: &mut K = &mut *k;
+pub unsafe fn set_kernel_parameter<K: Kernel>(k: *mut GlueKernel<K>, address: u64, value: f64) {
+    let k2: &mut K = &mut (*k).kernel;
     k2.set_parameter(address, value)
 }
 
-pub unsafe fn get_kernel_parameter<K: Kernel>(k: *const K, address: u64) -> f64 {
-    let k2: &K = &*k;
+pub unsafe fn get_kernel_parameter<K: Kernel>(k: *const GlueKernel<K>, address: u64) -> f64 {
+    let k2: &K = &(*k).kernel;
     k2.get_parameter(address)
 }
 
-pub unsafe fn get_kernel_latency<K: Kernel>(k: *const K) -> u64 {
-    let k2: &K = &*k;
+pub unsafe fn get_kernel_latency<K: Kernel>(k: *const GlueKernel<K>) -> u64 {
+    let k2: &K = &(*k).kernel;
     k2.get_latency()
 }
 
-pub unsafe fn reset_kernel<K: Kernel>(k: *mut K) {
-    let k2: &mut K = &mut *k;
+pub unsafe fn reset_kernel<K: Kernel>(k: *mut GlueKernel<K>) {
+    let k2: &mut K = &mut (*k).kernel;
     k2.reset();
 }
 
-#[repr(C)]
+pub fn get_kernel_reports_changes<K: Kernel>() -> u32 {
+    K::reports_changes() as u32
+}
+
+pub unsafe fn take_kernel_changes<K: Kernel>(
+    k: *mut GlueKernel<K>,
+    changed_ctx: *mut c_void,
+    changed: extern "C" fn(ctx: *mut c_void, address: u64),
+) -> u64 {
+    let k2: &mut K = &mut (*k).kernel;
+    k2.take_changes(|address| changed(changed_ctx, address)) as u64
+}
+
+/// One event as it crosses the FFI boundary.  This is laid out to be exactly 32 bytes, so
+/// a block's worth of events packs two to a cache line.  So a MIDI packet (`ty` 3) reuses the
+/// parameter fields: `param_addr` points at its bytes, `param_ramp_time` is their count, and
+/// `midi_bytes[0]` is its format.
+#[repr(C, align(32))]
 pub struct GlueEvent {
     pub time: i64,
-    pub ty: u64,
 
     pub param_addr: u64,
-    pub param_value: f64,
+    pub param_value: f32,
     pub param_ramp_time: u32,
 
+    pub ty: u8,
     pub midi_cable: u8,
     pub midi_valid_bytes: u16,
     pub midi_bytes: [u8; 3],
 }
 
+fn convert_event(ge: &GlueEvent) -> event::Event {
+    event::Event {
+        time: ge.time,
+        data: match ge.ty {
+            0 => event::Data::ParameterChange {
+                address: ge.param_addr,
+                value: f64::from(ge.param_value),
+            },
+            1 => event::Data::RampedParameterChange {
+                address: ge.param_addr,
+                value: f64::from(ge.param_value),
+                ramp_time: ge.param_ramp_time,
+            },
+            2 => event::Data::MIDIMessage {
+                cable: ge.midi_cable,
+                valid_bytes: ge.midi_valid_bytes,
+                bytes: ge.midi_bytes,
+            },
+            3 => event::Data::MIDIPacket {
+                cable: ge.midi_cable,
+                format: if ge.midi_bytes[0] == 1 {
+                    event::MIDIPacketFormat::UMP
+                } else {
+                    event::MIDIPacketFormat::Bytes
+                },
+                // The host keeps the payload alive until `process` returns.
+                bytes: unsafe {
+                    event::MIDIPacketBytes::from_raw_parts(
+                        ge.param_addr as usize as *const u8,
+                        ge.param_ramp_time as usize,
+                    )
+                },
+            },
+            _ => event::Data::ParameterChange {
+                address: ge.param_addr,
+                value: f64::from(ge.param_value),
+            },
+        },
+    }
+}
+
 struct GlueEventStream {
     events_ctx: *mut c_void,
     events_fn: extern "C" fn(ctx: *mut c_void) -> *const GlueEvent,
@@ -221,35 +293,27 @@ impl Iterator for GlueEventStream {
         if gp.is_null() {
             return None;
         }
-        let ge = unsafe { &*gp };
-        Some(event::Event {
-            time: ge.time,
-            data: match ge.ty {
-                0 => event::Data::ParameterChange {
-                    address: ge.param_addr,
-                    value: ge.param_value,
-                },
-                1 => event::Data::RampedParameterChange {
-                    address: ge.param_addr,
-                    value: ge.param_value,
-                    ramp_time: ge.param_ramp_time,
-                },
-                2 => event::Data::MIDIMessage {
-                    cable: ge.midi_cable,
-                    valid_bytes: ge.midi_valid_bytes,
-                    bytes: ge.midi_bytes,
-                },
-                _ => event::Data::ParameterChange {
-                    address: ge.param_addr,
-                    value: ge.param_value,
-                },
-            },
-        })
+        Some(convert_event(unsafe { &*gp }))
     }
 }
 
+unsafe fn process_kernel_events<K: Kernel, I: Iterator<Item = event::Event>>(
+    k: *mut GlueKernel<K>,
+    data: *mut *mut f32,
+    chans: u64,
+    samples: u64,
+    events: I,
+) {
+    let GlueKernel { kernel, channels } = &mut *k;
+    let chan_iter = (0..chans).map(|chan| {
+        let slice_ptr = *data.offset(chan as isize);
+        std::slice::from_raw_parts_mut(slice_ptr, samples as usize)
+    });
+    channels.with_channels(chan_iter, |audio| kernel.process(audio, events));
+}
+
 pub unsafe fn process_kernel<K: Kernel>(
-    k: *mut K,
+    k: *mut GlueKernel<K>,
     data: *mut *mut f32,
     chans: u64,
     samples: u64,
@@ -260,14 +324,25 @@ pub unsafe fn process_kernel<K: Kernel>(
         events_ctx,
         events_fn,
     };
-    let mut chan_vec: SmallVec<[&mut [f32]; 8]> = (0..chans)
-        .map(|chan| {
-            let slice_ptr = *data.offset(chan as isize);
-            std::slice::from_raw_parts_mut(slice_ptr, samples as usize)
-        })
-        .collect();
-    let k2: &mut K = &mut *k;
-    k2.process((&mut chan_vec).into(), glue_events);
+    process_kernel_events(k, data, chans, samples, glue_events);
+}
+
+/// Like `process_kernel`, but all of the block's events are passed up front as a
+/// contiguous array, sorted by time.
+pub unsafe fn process_kernel_batched<K: Kernel>(
+    k: *mut GlueKernel<K>,
+    data: *mut *mut f32,
+    chans: u64,
+    samples: u64,
+    events: *const GlueEvent,
+    num_events: u64,
+) {
+    let glue_events: &[GlueEvent] = if num_events == 0 {
+        &[]
+    } else {
+        std::slice::from_raw_parts(events, num_events as usize)
+    };
+    process_kernel_events(k, data, chans, samples, glue_events.iter().map(convert_event));
 }
 
 #[macro_export]
@@ -338,38 +413,59 @@ macro_rules! generate_glue {
             input_count: u32,
             output_count: u32,
             sample_rate: f64,
-        ) -> *mut $K {
+        ) -> *mut $crate::detail::GlueKernel<$K> {
             $crate::detail::create_kernel(input_count, output_count, sample_rate)
         }
 
         #[no_mangle]
-        unsafe extern "C" fn delete_kernel(k: *mut $K) {
+        unsafe extern "C" fn delete_kernel(k: *mut $crate::detail::GlueKernel<$K>) {
             $crate::detail::delete_kernel(k)
         }
 
         #[no_mangle]
-        unsafe extern "C" fn set_kernel_parameter(k: *mut $K, address: u64, value: f64) {
+        unsafe extern "C" fn set_kernel_parameter(
+            k: *mut $crate::detail::GlueKernel<$K>,
+            address: u64,
+            value: f64,
+        ) {
             $crate::detail::set_kernel_parameter(k, address, value)
         }
 
         #[no_mangle]
-        unsafe extern "C" fn get_kernel_parameter(k: *const $K, address: u64) -> f64 {
+        unsafe extern "C" fn get_kernel_parameter(
+            k: *const $crate::detail::GlueKernel<$K>,
+            address: u64,
+        ) -> f64 {
             $crate::detail::get_kernel_parameter(k, address)
         }
 
         #[no_mangle]
-        unsafe extern "C" fn get_kernel_latency(k: *const $K) -> u64 {
+        unsafe extern "C" fn get_kernel_latency(k: *const $crate::detail::GlueKernel<$K>) -> u64 {
             $crate::detail::get_kernel_latency(k)
         }
 
         #[no_mangle]
-        unsafe extern "C" fn reset_kernel(k: *mut $K) {
+        unsafe extern "C" fn reset_kernel(k: *mut $crate::detail::GlueKernel<$K>) {
             $crate::detail::reset_kernel(k)
         }
 
+        #[no_mangle]
+        extern "C" fn get_kernel_reports_changes() -> u32 {
+            $crate::detail::get_kernel_reports_changes::<$K>()
+        }
+
+        #[no_mangle]
+        unsafe extern "C" fn take_kernel_changes(
+            k: *mut $crate::detail::GlueKernel<$K>,
+            changed_ctx: *mut c_void,
+            changed: extern "C" fn(ctx: *mut c_void, address: u64),
+        ) -> u64 {
+            $crate::detail::take_kernel_changes(k, changed_ctx, changed)
+        }
+
         #[no_mangle]
         unsafe extern "C" fn process_kernel(
-            k: *mut $K,
+            k: *mut $crate::detail::GlueKernel<$K>,
             data: *mut *mut f32,
             chans: u64,
             samples: u64,
@@ -378,5 +474,17 @@ macro_rules! generate_glue {
         ) {
             $crate::detail::process_kernel(k, data, chans, samples, events_ctx, events_fn)
         }
+
+        #[no_mangle]
+        unsafe extern "C" fn process_kernel_batched(
+            k: *mut $crate::detail::GlueKernel<$K>,
+            data: *mut *mut f32,
+            chans: u64,
+            samples: u64,
+            events: *const brinicle_glue::detail::GlueEvent,
+            num_events: u64,
+        ) {
+            $crate::detail::process_kernel_batched(k, data, chans, samples, events, num_events)
+        }
     };
 }
@@ -1,4 +1,7 @@
+/// Brinicle may add kinds of event as hosts grow them, so matches need a wildcard arm; kernels
+/// should ignore events they don't understand.
 #[derive(Debug)]
+#[non_exhaustive]
 pub enum Data {
     ParameterChange {
         address: u64,
@@ -14,6 +17,57 @@ pub enum Data {
         valid_bytes: u16,
         bytes: [u8; 3],
     },
+    /// MIDI too long for a `MIDIMessage`: a sysex message, or MIDI 2.0 packets.
+    MIDIPacket {
+        cable: u8,
+        format: MIDIPacketFormat,
+        bytes: MIDIPacketBytes,
+    },
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum MIDIPacketFormat {
+    /// A MIDI 1.0 byte stream, usually one whole sysex message from 0xF0 to 0xF7.
+    Bytes,
+
+    /// MIDI 2.0 universal MIDI packets: whole 32-bit words, in native byte order.
+    UMP,
+}
+
+/// The bytes of a `MIDIPacket`.  These aren't copied out of the host's buffer for the block,
+/// so they are only valid until `process` returns.
+#[derive(Debug)]
+pub struct MIDIPacketBytes {
+    data: *const u8,
+    len: usize,
+}
+
+impl MIDIPacketBytes {
+    /// # Safety
+    ///
+    /// `data` must point to `len` bytes that stay valid for as long as the event is used.
+    pub unsafe fn from_raw_parts(data: *const u8, len: usize) -> MIDIPacketBytes {
+        MIDIPacketBytes { data, len }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// # Safety
+    ///
+    /// Must only be called during the `process` call the event was passed to.
+    pub unsafe fn as_slice(&self) -> &[u8] {
+        if self.len == 0 {
+            &[]
+        } else {
+            std::slice::from_raw_parts(self.data, self.len)
+        }
+    }
 }
 
 #[derive(Debug)]
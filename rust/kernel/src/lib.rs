@@ -8,6 +8,8 @@ pub mod utils;
 pub use crate::audio_format::AudioFormat;
 pub use brinicle_deinterleaved::AudioBuffer;
 pub use brinicle_deinterleaved::AudioBufferMut;
+pub use brinicle_deinterleaved::ChannelTable;
+pub use brinicle_deinterleaved::SubBufferMut;
 
 pub struct KernelInfo {
     pub params: Vec<parameter::Info>,
@@ -32,4 +34,23 @@ pub trait Kernel {
         I: Iterator<Item = event::Event>;
 
     fn reset(&mut self);
+
+    /// Return true to promise that `take_changes` reports every parameter this kernel changes
+    /// by itself.  Hosts then only look at those after each block, rather than polling every
+    /// parameter.
+    fn reports_changes() -> bool {
+        false
+    }
+
+    /// Calls `changed` with the address of each parameter this kernel has changed by itself
+    /// since the last call.  A parameter set through `set_parameter` or a parameter event needn't
+    /// be reported, unless `get_parameter` follows a ramp over later blocks.  Returns whether
+    /// the latency may have changed.  Only called after `process`, and only if
+    /// `reports_changes` is true.
+    fn take_changes<F>(&mut self, _changed: F) -> bool
+    where
+        F: FnMut(u64),
+    {
+        true
+    }
 }
@@ -1,15 +1,18 @@
 use super::event;
 use super::AudioBufferMut;
+use super::ChannelTable;
+use std::ops::Range;
 
 pub enum EventOrAudio<'c, 'a: 'c> {
     Event(event::Event),
     Audio(AudioBufferMut<'c, 'a>),
 }
 
-pub fn run_split_at_events<I, F>(mut audio: AudioBufferMut, events: I, mut f: F)
+fn split_at_events<I, F, S>(mut audio: AudioBufferMut, events: I, mut f: F, mut slice: S)
 where
     I: Iterator<Item = event::Event>,
     F: FnMut(EventOrAudio),
+    S: FnMut(&mut AudioBufferMut, Range<usize>, &mut F),
 {
     let buffer_len = audio.len();
 
@@ -26,11 +29,8 @@ where
         assert!(time < buffer_len);
 
         // We need to handle some audio before we handle the event.
-        // Split our AudioBuffer.
-        let mut sb = audio.slice(curr_slice_start..time);
-
-        // Process our sub_buffer
-        f(EventOrAudio::Audio((&mut sb).into()));
+        // Process a slice of our AudioBuffer.
+        slice(&mut audio, curr_slice_start..time, &mut f);
 
         // update our slice start time.
         curr_slice_start = time;
@@ -40,6 +40,32 @@ where
     }
 
     // Now handle any remaining audio
-    let mut sb = audio.slice(curr_slice_start..buffer_len);
-    f(EventOrAudio::Audio((&mut sb).into()));
+    slice(&mut audio, curr_slice_start..buffer_len, &mut f);
+}
+
+pub fn run_split_at_events<I, F>(audio: AudioBufferMut, events: I, f: F)
+where
+    I: Iterator<Item = event::Event>,
+    F: FnMut(EventOrAudio),
+{
+    split_at_events(audio, events, f, |audio, range, f| {
+        let mut sb = audio.slice(range);
+        f(EventOrAudio::Audio((&mut sb).into()));
+    });
+}
+
+/// Like `run_split_at_events`, but slices the audio through `channels`, so that it doesn't
+/// allocate for formats wider than `brinicle_deinterleaved::MAX_INLINE_CHANNELS`.
+pub fn run_split_at_events_in<I, F>(
+    channels: &mut ChannelTable,
+    audio: AudioBufferMut,
+    events: I,
+    f: F,
+) where
+    I: Iterator<Item = event::Event>,
+    F: FnMut(EventOrAudio),
+{
+    split_at_events(audio, events, f, |audio, range, f| {
+        channels.slice(audio, range, |sb| f(EventOrAudio::Audio(sb)));
+    });
 }